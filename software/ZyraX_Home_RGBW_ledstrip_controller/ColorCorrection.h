@@ -0,0 +1,126 @@
+/******************************************************************************/
+/*
+ * File:    ColorCorrection.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * 
+ * Brief:   Gamma and white point correction tables for the output stage. The
+ *          tables are generated at compile time from the gamma and white
+ *          point configuration, so correcting a pixel costs three lookups.
+ *          Values are 8.8 fixed point, the fraction is used for temporal
+ *          dithering.
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef COLOR_CORRECTION_H
+#define COLOR_CORRECTION_H
+#include "stdint.h"                                                             //For size defined int types
+#include "Configuration.h"                                                      //For configuration variables and global constants
+#include "PixelKernels.h"                                                       //For the ColorLut type
+
+#define LN2                             0.69314718055994530942
+
+/******************************************************************************/
+/*!
+  @brief    Natural logarithm, usable at compile time. The argument is scaled
+            to [0.5, 1) first, so the series converges in a few terms.
+  @param    x                   Value, > 0
+  @returns  double              ln(x)
+*/
+/******************************************************************************/
+constexpr double constexprLn(double x) {
+    int16_t exponent = 0;
+    while (x >= 1.0) {
+        x /= 2.0;
+        exponent++;
+    }
+    while (x < 0.5) {
+        x *= 2.0;
+        exponent--;
+    }
+
+    /* ln(x) = 2 * atanh((x - 1) / (x + 1)) */
+    double z = (x - 1.0) / (x + 1.0);
+    double term = z;
+    double sum = 0.0;
+    for (uint8_t n = 1; n < 40; n += 2) {
+        sum += term / n;
+        term *= z * z;
+    }
+
+    return 2.0 * sum + exponent * LN2;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Exponential function, usable at compile time. The argument is
+            divided by 16 for the series, the result is squared back.
+  @param    x                   Value, <= 0 for the gamma tables
+  @returns  double              e^x
+*/
+/******************************************************************************/
+constexpr double constexprExp(double x) {
+    double y = x / 16.0;
+    double term = 1.0;
+    double sum = 1.0;
+    for (uint8_t n = 1; n < 30; n++) {
+        term *= y / n;
+        sum += term;
+    }
+
+    for (uint8_t i = 0; i < 4; i++) {
+        sum *= sum;
+    }
+
+    return sum;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Calculates one gamma corrected channel value.
+  @param    value               Linear channel value
+  @param    gamma               Gamma of the channel
+  @param    maxValue            Output for full input, the white point
+  @returns  uint16_t            Corrected channel value, 8.8 fixed point
+*/
+/******************************************************************************/
+constexpr uint16_t gammaCorrect(uint8_t value, double gamma, uint8_t maxValue) {
+    if (value == 0) {
+        return 0;
+    }
+
+    return (uint16_t) (constexprExp(gamma * constexprLn(value / 255.0)) * maxValue * 256 + 0.5);
+}
+
+/******************************************************************************/
+/*!
+  @brief    Generates the correction tables for the specified white point.
+  @param    whitePoint          Max output per channel, 0xRRGGBB
+  @returns  ColorLut            Correction tables
+*/
+/******************************************************************************/
+constexpr ColorLut makeColorLut(uint32_t whitePoint) {
+    ColorLut lut = {};
+
+    if (!WHITE_POINT_CORRECTION) {
+        whitePoint = 0xFFFFFF;
+    }
+
+    for (uint16_t i = 0; i < 256; i++) {
+        lut.red[i] = gammaCorrect(i, GAMMA_RED, (whitePoint >> 16) & 0xFF);
+        lut.green[i] = gammaCorrect(i, GAMMA_GREEN, (whitePoint >> 8) & 0xFF);
+        lut.blue[i] = gammaCorrect(i, GAMMA_BLUE, whitePoint & 0xFF);
+    }
+
+    return lut;
+}
+
+/* Tables per driver, indexed by the driver ID */
+static constexpr ColorLut COLOR_LUTS[] = {
+    makeColorLut(WS2801_WHITE_POINT),                                           //_WS2801
+    makeColorLut(WS2812B_WHITE_POINT),                                          //_WS2812B
+    makeColorLut(SK6812_WHITE_POINT)                                            //_SK6812
+};
+#endif
@@ -0,0 +1,122 @@
+/******************************************************************************/
+/*
+ * File:    ColorTables.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * 
+ * Brief:   Color wheel and heat palette tables for the modes. The tables are
+ *          generated at compile time and stored in flash, so looking up a
+ *          color costs one table index per channel instead of branches,
+ *          multiplications or float math per pixel.
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef COLOR_TABLES_H
+#define COLOR_TABLES_H
+#include "stdint.h"                                                             //For size defined int types
+#include "Configuration.h"                                                      //For configuration variables and global constants
+
+#define NUMBER_OF_HEAT_PALETTES         4                                       //PALETTE_YELLOW_RED up to PALETTE_BLUE_GREEN
+
+struct ColorTable {
+    uint8_t red[256];
+    uint8_t green[256];
+    uint8_t blue[256];
+};
+
+/******************************************************************************/
+/*!
+  @brief    Generates the color wheel, green to red to blue and back to green.
+  @returns  ColorTable          Color per wheel position
+*/
+/******************************************************************************/
+constexpr ColorTable makeColorWheelTable() {
+    ColorTable table = {};
+
+    for (uint16_t i = 0; i < 256; i++) {
+        uint8_t position = i;
+
+        if (position < 85) {
+            table.red[i] = position * 3;
+            table.green[i] = 255 - position * 3;
+            table.blue[i] = 0;
+        } else if (position < 170) {
+            position -= 85;
+            table.red[i] = 255 - position * 3;
+            table.green[i] = 0;
+            table.blue[i] = position * 3;
+        } else {
+            position -= 170;
+            table.red[i] = 0;
+            table.green[i] = position * 3;
+            table.blue[i] = 255 - position * 3;
+        }
+    }
+
+    return table;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Generates a heat palette for the fire mode. The temperature is
+            scaled to 0 - 191 and split in a cool, middle and hot third, each
+            ramping up one channel.
+  @param    palette             Heat palette, PALETTE_YELLOW_RED up to
+                                PALETTE_BLUE_GREEN
+  @returns  ColorTable          Color per temperature
+*/
+/******************************************************************************/
+constexpr ColorTable makeHeatTable(uint8_t palette) {
+    ColorTable table = {};
+
+    for (uint16_t i = 0; i < 256; i++) {
+        uint8_t t192 = (uint8_t) (i / 255.0 * 191 + 0.5);
+        uint8_t heatramp = (t192 & 0x3F) << 2;                                  //0..252
+        uint8_t level = t192 > 0x80 ? 2 : (t192 > 0x40 ? 1 : 0);                //Hottest, middle, coolest
+        uint8_t r = 0;
+        uint8_t g = 0;
+        uint8_t b = 0;
+
+        switch (palette) {
+            case PALETTE_PURPLE_BLUE:
+                r = level == 2 ? 255 : (level == 1 ? heatramp : 0);
+                g = level == 2 ? heatramp : 0;
+                b = level == 0 ? heatramp : 255;
+                break;
+            case PALETTE_GREEN_BLUE:
+                r = level == 2 ? heatramp : 0;
+                g = level == 2 ? 255 : (level == 1 ? heatramp : 0);
+                b = level == 0 ? heatramp : 255;
+                break;
+            case PALETTE_BLUE_GREEN:
+                r = level == 2 ? heatramp : 0;
+                g = level == 0 ? heatramp : 255;
+                b = level == 2 ? 255 : (level == 1 ? heatramp : 0);
+                break;
+            default:                                                            //PALETTE_YELLOW_RED
+                r = level == 0 ? heatramp : 255;
+                g = level == 2 ? 255 : (level == 1 ? heatramp : 0);
+                b = level == 2 ? heatramp : 0;
+                break;
+        }
+
+        table.red[i] = r;
+        table.green[i] = g;
+        table.blue[i] = b;
+    }
+
+    return table;
+}
+
+static constexpr ColorTable COLOR_WHEEL_TABLE = makeColorWheelTable();
+
+/* Heat palettes, indexed by the palette ID - PALETTE_YELLOW_RED */
+static constexpr ColorTable HEAT_TABLES[NUMBER_OF_HEAT_PALETTES] = {
+    makeHeatTable(PALETTE_YELLOW_RED),
+    makeHeatTable(PALETTE_PURPLE_BLUE),
+    makeHeatTable(PALETTE_GREEN_BLUE),
+    makeHeatTable(PALETTE_BLUE_GREEN)
+};
+#endif
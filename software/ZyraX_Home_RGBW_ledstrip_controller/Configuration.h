@@ -23,8 +23,29 @@
 
 
 /* Animation delays */
-#define COLOR_DELAY                     3                                       //Delay between frames, in ms
-#define BRIGHTNESS_DELAY                5                                       //Delay between frames, in ms
+#define BRIGHTNESS_FADE_TIME            500                                     //Ramp to a new brightness, in ms
+#define DEFAULT_FRAME_RATE              60                                      //Frames per second, for animations without a delay parameter
+#define MODE_TRANSITION_TIME            300                                     //Crossfade from the previous mode, in ms (200 - 500)
+#define POWER_FADE_TIME                 500                                     //Fade power animation, in ms
+#define POWER_DISSOLVE_TIME             2000                                    //Dissolve power animation, in ms
+#define RANDOM_SEED                     0                                       //Seed of the effects, 0 = new hardware random seed at every mode start. A fixed seed makes the effects reproducible
+#define FRAME_FENCE_TIMEOUT             100                                     //Max time to wait for the output task to release the back frame, in ms
+#define RENDER_MESSAGE_TIMEOUT          100                                     //Max time to wait for space in the render queue, in ms
+#define RENDER_JOIN_TIMEOUT             250                                     //Max time to wait for the render task to apply a message, in ms
+
+/* Color correction, applied by the output stage */
+#define GAMMA_RED                       2.2                                     //Gamma of the color channels, 1.0 is linear
+#define GAMMA_GREEN                     2.2
+#define GAMMA_BLUE                      2.2
+#define WHITE_POINT_CORRECTION          false                                   //Opt in, the white points below change the white and hue balance of existing installs
+#define WS2801_WHITE_POINT              0xFFFFFF                                //Max output per channel, 0xRRGGBB
+#define WS2812B_WHITE_POINT             0xFFB0F0                                //Typical 5050 SMD LED
+#define SK6812_WHITE_POINT              0xFFB0F0                                //Typical 5050 SMD LED
+#define TEMPORAL_DITHERING              false                                   //Spreads the fraction of corrected colors over successive frames
+#define DITHER_REFRESH_FRAMES           120                                     //Times a static frame is sent again to dither its fractions, then it holds
+
+/* Color order of the drivers */
+#define WS2812B_COLOR_ORDER             RBG                                     //Order of existing installs, most WS2812B strips are GRB
 
 /* Local sensor pins */
 #define LOCAL_SENSOR1_PIN               5
@@ -32,7 +53,10 @@
 
 /* Others */
 #define MAX_BRIGHTNESS                  180
-#define MAX_NUMBER_LEDS                 250
+#define MAX_NUMBER_LEDS                 4000
+#define DEFAULT_NUMBER_LEDS             250
+#define MAX_NUMBER_OF_OUTPUTS           8                                       //Data pins the strip can be split over, see LEDSTRIP_DATA_PIN_x
+#define MAX_NUMBER_OF_SEGMENTS          4                                       //Parts of the strip that run their own mode
 
 
 /* Network credentials */
@@ -0,0 +1,46 @@
+/******************************************************************************/
+/*
+ * File:    FastLedOutputDriver.cpp
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * Class:   FastLedOutputDriver
+ * 
+ * Brief:   Output driver that sends the frames to the strip with FastLED.
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#include "FastLedOutputDriver.h"
+
+/******************************************************************************/
+/*!
+  @brief    Sends the output buffer to the strip. The buffers are registered
+            at the FastLED controllers, so the arguments are not used.
+  @param    pixels              Output buffer
+  @param    size                Size of the output buffer, in bytes
+*/
+/******************************************************************************/
+void FastLedOutputDriver::show(const uint8_t pixels[], size_t size) {
+    FastLED.show();
+}
+
+/******************************************************************************/
+/*!
+  @brief    Sets the brightness, applied by FastLED while sending.
+  @param    brightness          Brightness
+*/
+/******************************************************************************/
+void FastLedOutputDriver::setBrightness(uint8_t brightness) {
+    FastLED.setBrightness(brightness);
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns the brightness.
+  @returns  uint8_t             Brightness
+*/
+/******************************************************************************/
+uint8_t FastLedOutputDriver::getBrightness() {
+    return FastLED.getBrightness();
+}
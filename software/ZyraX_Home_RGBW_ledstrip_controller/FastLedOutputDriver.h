@@ -0,0 +1,27 @@
+/******************************************************************************/
+/*
+ * File:    FastLedOutputDriver.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * Class:   FastLedOutputDriver
+ * 
+ * Brief:   Output driver that sends the frames to the strip with FastLED. The
+ *          output buffers are registered at the FastLED controllers by
+ *          Ledstrip, when the outputs are added.
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef FASTLED_OUTPUT_DRIVER_H
+#define FASTLED_OUTPUT_DRIVER_H
+#include "FastLED.h"                                                            //For sending colors to LED strip
+#include "OutputDriver.h"                                                       //For the output driver interface
+
+class FastLedOutputDriver : public OutputDriver {
+  public:
+    void show(const uint8_t pixels[], size_t size) override;
+    void setBrightness(uint8_t brightness) override;
+    uint8_t getBrightness() override;
+};
+#endif
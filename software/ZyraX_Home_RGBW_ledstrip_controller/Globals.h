@@ -27,6 +27,15 @@
 /* Ledstrip */
 #define LEDSTRIP_DATA_PIN               MOSI
 #define LEDSTRIP_CLOCK_PIN              SCK
+
+/* Additional ledstrip outputs, clockless drivers only */
+#define LEDSTRIP_DATA_PIN_2             13
+#define LEDSTRIP_DATA_PIN_3             14
+#define LEDSTRIP_DATA_PIN_4             15
+#define LEDSTRIP_DATA_PIN_5             16
+#define LEDSTRIP_DATA_PIN_6             17
+#define LEDSTRIP_DATA_PIN_7             18
+#define LEDSTRIP_DATA_PIN_8             21
 #pragma endregion
 
 #pragma region Boot modes
@@ -167,9 +176,7 @@
 #define NUM_POWER_ANIMATIONS            5
 
 /* States */
-#define _FADE_BRIGHTNESS                5
-#define _FADE_TO_SINGLE_COLOR           6
-#define _FADE_TO_MULTIPLE_COLOR         7
+#define _FADE_TO_MODE                   6                                       //Segments crossfade from their previous mode, or a power animation runs
 
 #define _READY_TO_RUN                   8
 #define _LOOPING                        9
@@ -196,6 +203,27 @@
 #define PARAMETER_NAME_FADE_LENGTH          "fade_length"           //Todo change to fade delay
 
 #define NUMBER_OF_MODE_PARAMETERS       18
+
+/* Parameter flags, the parameters of a mode are a combination of these */
+#define PARAMETER_MIN_COLOR_POS         (1UL << 0)
+#define PARAMETER_MAX_COLOR_POS         (1UL << 1)
+#define PARAMETER_COLOR1                (1UL << 2)
+#define PARAMETER_COLOR2                (1UL << 3)
+#define PARAMETER_USE_GRADIENT1         (1UL << 4)
+#define PARAMETER_USE_GRADIENT2         (1UL << 5)
+#define PARAMETER_SEGMENT_SIZE          (1UL << 6)
+#define PARAMETER_TAIL_LENGTH           (1UL << 7)
+#define PARAMETER_WAVE_LENGTH           (1UL << 8)
+#define PARAMETER_TIME_FADE             (1UL << 9)
+#define PARAMETER_DELAY                 (1UL << 10)
+#define PARAMETER_DELAY_BETWEEN         (1UL << 11)
+#define PARAMETER_RANDOMNESS_DELAY      (1UL << 12)
+#define PARAMETER_INTENSITY             (1UL << 13)
+#define PARAMETER_DIRECTION             (1UL << 14)
+#define PARAMETER_NUMBER_OF_ELEMENTS    (1UL << 15)
+#define PARAMETER_PALETTE               (1UL << 16)
+#define PARAMETER_FADE_LENGTH           (1UL << 17)
+#define PARAMETER_COLORS                (PARAMETER_COLOR1 | PARAMETER_COLOR2 | PARAMETER_USE_GRADIENT1 | PARAMETER_USE_GRADIENT2)
 #define MAX_SEGMENT_SIZE                21
 
 #define PALETTE_RANDOM                  0
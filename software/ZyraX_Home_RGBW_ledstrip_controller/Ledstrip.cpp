@@ -28,12 +28,23 @@ Ledstrip::Ledstrip() {
     _prevBrightness = MAX_BRIGHTNESS;
     _isOn = true;
     _wasOn = true;
-    _fullColor = CRGB(255, 255, 255);
     _doorState = false;
 
-    /* Temporary variables */
-    _desiredColorPos = 0;
-    _fadeToGradientColors = false;
+    /* Layers */
+    _layers[LAYER_DOOR].color = CRGB(255, 255, 255);
+    _layers[LAYER_POWER].blendOperation = BLEND_MASK;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Sets the driver the frames are sent to, instead of FastLED. Has
+            to be called before initialize(), no FastLED controllers are
+            added then.
+  @param    driver              Output driver
+*/
+/******************************************************************************/
+void Ledstrip::setOutputDriver(OutputDriver* driver) {
+    _outputDriver = driver;
 }
 
 /******************************************************************************/
@@ -46,74 +57,64 @@ void Ledstrip::initialize() {
     
     _nvMemory.begin(NV_MEM_CONFIG);
     _driver = _nvMemory.getUChar("driver", _SK6812);
-    _numberLeds = _nvMemory.getUShort("numberLeds", MAX_NUMBER_LEDS);
+    _numberLeds = min(_nvMemory.getUShort("numberLeds", DEFAULT_NUMBER_LEDS), (uint16_t) MAX_NUMBER_LEDS);
     _powerAnimation = _nvMemory.getUChar("pwrAnimation", _POWER_FADE);
     _brightness = _nvMemory.getUChar("brightness", MAX_BRIGHTNESS);
-    _mode = _nvMemory.getUChar("mode", MODE_COLOR);
     _nvMemory.end();
+
+    if (_driver < sizeof(COLOR_LUTS) / sizeof(COLOR_LUTS[0])) {
+        _colorLut = &COLOR_LUTS[_driver];
+    }
+    _isColorCorrected = !isIdentityLut(*_colorLut);
     
     _loadPixelAddresses();
 
+    if (_bufferArena == NULL) {
+        return;
+    }
+
     _l.logi("_driver: " + String(_driver));
     _l.logi("_numberLeds: " + String(_numberLeds));
     _l.logi("_powerAnimation: " + String(_powerAnimation));
 
-    if (_driver == _WS2801) {
-        FastLED.addLeds<WS2801, LEDSTRIP_DATA_PIN, LEDSTRIP_CLOCK_PIN, RBG>(_tempLeds, _numberLeds);
-    } else if (_driver == _WS2812B) {
-        FastLED.addLeds<WS2801, LEDSTRIP_DATA_PIN, RBG>(_tempLeds, _numberLeds);
-    } else if (_driver == _SK6812) {
-        FastLED.addLeds<WS2812B, LEDSTRIP_DATA_PIN, RGB>(_ledsPointer, getRGBWsize(_numberLeds));
-    }
-    
-    for (uint8_t mode = 1; mode < NUM_MODES; mode++) {
-        configureMode(mode, _memoryManager.loadModeParameters(mode), false);
+    if (_outputDriver == &_fastLedOutputDriver) {
+        _addOutputs();                                                          //Other drivers do not send with FastLED
     }
+    _loadSegments();
+    _random.seed(RANDOM_SEED != 0 ? RANDOM_SEED : esp_random());
+
+    _frameFence = xSemaphoreCreateBinary();
+    xSemaphoreGive(_frameFence);                                                //Both frames are free at start
 
-    setBrightness(_brightness);
-    setMode(_mode);
+    _outputBrightness = _brightness;
+    _brightnessFadeFrom = _brightness;
+    _brightnessFadeTo = _brightness;
+    _outputDriver->setBrightness(_brightness);
+
+    xTaskCreatePinnedToCore(
+        Ledstrip::__startOutputTask,                                            //Task function
+        "OutputHandler",                                                        //Task name
+        4000,                                                                   //Stack size in bytes
+        this,                                                                   //Task parameter
+        OUTPUT_PRIORITY,                                                        //Task priority
+        &_outputTaskHandler,                                                    //Task handler
+        OUTPUT_CORE_NUMBER                                                      //Task CPU core
+    );
+    
+    _loadModeParameters();
+    _startModes();
+    _startRenderTask();
 }
 
 /******************************************************************************/
 /*!
-  @brief    Sets the power.
+  @brief    Sets the power. The power animation masks the segments, so the
+            modes continue where they were when turned on again.
   @param    state               Power state, true = on, false = off
-  @param    startMode           If true, the mode is started
 */
 /******************************************************************************/
-void Ledstrip::setPower(bool state, bool startMode) {
-    if (state == _isOn) {
-        return;
-    }
-    
-    _waitUntilIdle();
-    
-    if (_isOn) {
-        _saveLeds();
-    }
-    
-    _isOn = state;
-
-    switch (_powerAnimation) {
-        case _POWER_FADE:
-            _powerFade();
-            break;
-        case _POWER_DISSOLVE:
-            _powerDissolve();
-            break;
-        case _POWER_SWEEP:
-            _powerSweep();
-            break;
-        case _POWER_DUAL_SWEEP:
-            _powerDualSweep();
-            break;
-        default:
-            break;
-    }
-
-    if (_isOn && startMode) {
-        setMode(_mode);
-    }
+void Ledstrip::setPower(bool state) {
+    _sendRenderMessage(RENDER_MESSAGE_SET_POWER, state);
 }
 
 /******************************************************************************/
@@ -123,48 +124,25 @@ void Ledstrip::setPower(bool state, bool startMode) {
 */
 /******************************************************************************/
 void Ledstrip::doorHandler(bool state) {
-    if (state == _doorState) {
-        return;
-    }
-    
-    _waitUntilIdle();
-    _doorState = state;
-    
-    if (state) {
-        _handleDoorOpen();
-    } else {
-        _handleDoorClosed();
-    }
+    _sendRenderMessage(RENDER_MESSAGE_DOOR_CHANGE, state);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Handles the door opened event.
+  @brief    Handles the door opened event. The door light is a layer over the
+            segments, so the modes keep running underneath.
 */
 /******************************************************************************/
 void Ledstrip::_handleDoorOpen() {
     _wasOn = _isOn;
-    //_isOn = false;
     _prevBrightness = _brightness;
-    _prevColor = _fullColor;
-    _prevMode = _mode;
 
-    if (_isOn) {
-        _modeParameters[MODE_COLOR].color1 = CRGB(255, 255, 255);
-        color();
-    } else {
-        /* Fade to white leds */
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            _savedLeds[i] = CRGB(255, 255, 255);
-        }
-        
-        setPower(true, false);
+    _layers[LAYER_DOOR].isEnabled = true;
+    _setTargetBrightness(MAX_BRIGHTNESS);
+
+    if (!_isOn) {
+        _startPowerAnimation(true);
     }
-    
-    setBrightness(MAX_BRIGHTNESS);
-    _waitUntilIdle();
-    
-    _state = _WAIT_FOR_DOOR_CLOSED;
 }
 
 /******************************************************************************/
@@ -173,157 +151,133 @@ void Ledstrip::_handleDoorOpen() {
 */
 /******************************************************************************/
 void Ledstrip::_handleDoorClosed() {
-    setBrightness(_prevBrightness);
-    _waitUntilIdle();
-    _modeParameters[MODE_COLOR].color1 = _prevColor;
-    _mode = _prevMode;
-    
-    if (_wasOn) {
-        setMode(_mode);
+    _setTargetBrightness(_prevBrightness);
+
+    if (_wasOn || !_isOn) {
+        _layers[LAYER_DOOR].isEnabled = false;
     } else {
-        setPower(false, false);
-        _waitUntilIdle();
-        
-        setMode(_mode);                                                         //Set mode to get leds values when turning on
-        _waitUntilIdle();
-        _saveLeds();
-        
-        /* Reset actual leds */
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            _leds[i] = CRGB(0, 0, 0);
-        }
+        _startPowerAnimation(false);                                            //Door light is disabled when the strip is off
     }
 }
 
 /******************************************************************************/
 /*!
-  @brief    Starts the specified mode.
+  @brief    Starts the specified mode on one or all segments.
   @param    mode                Mode ID
+  @param    segment             Segment index, ALL_SEGMENTS for the whole strip
 */
 /******************************************************************************/
-void Ledstrip::setMode(uint8_t mode) {
-    switch (mode) {
-        case MODE_COLOR:
-            color();
-            break;
-        case MODE_FADE:
-            fade();
-            break;
-        case MODE_GRADIENT:
-            gradient();
-            break;
-        case MODE_BLINK:
-            blink();
-            break;
-        case MODE_SCAN:
-            scan();
-            break;
-        case MODE_THEATER:
-            theater();
-            break;
-        case MODE_SINE:
-            sine();
-            break;
-        case MODE_BOUNCING_BALLS:
-            bouncingBalls();
-            break;
-        case MODE_DISSOLVE:
-            dissolve();
-            break;
-        case MODE_SPARKLE:
-            sparkle();
-            break;
-        case MODE_FIREWORKS:
-            fireworks();
-            break;
-        case MODE_FIRE:
-            fire();
-            break;
-        case MODE_SWEEP:
-            sweep();
-            break;
-        case MODE_COLOR_TWINKELS:
-            colorTwinkels();
-            break;
-        case MODE_METEOR_RAIN:
-            meteorRain();
-            break;
-        case MODE_COLOR_WAVES:
-            colorWaves();
-            break;
-        case MODE_TEMPLATE_1:
-            modeTemplate1();
-            break;
-        case MODE_TEMPLATE_2:
-            modeTemplate2();
-            break;
-        case MODE_TEMPLATE_3:
-            modeTemplate3();
-            break;
-        case MODE_TEMPLATE_4:
-            modeTemplate4();
-            break;
-        case MODE_TEMPLATE_5:
-            modeTemplate5();
-            break;
-        case MODE_TEMPLATE_6:
-            modeTemplate6();
-            break;
-        case MODE_TEMPLATE_7:
-            modeTemplate7();
-            break;
-        case MODE_TEMPLATE_8:
-            modeTemplate8();
-            break;
-        case MODE_TEMPLATE_9:
-            modeTemplate9();
-            break;
-        case MODE_TEMPLATE_10:
-            modeTemplate10();
-            break;
-        case MODE_DRAWING:
-            _modeParameters[MODE_COLOR].color1 = CRGB(0, 0, 0);//Reset colors
-            color();
-            if (!_isOn) {
-                setPower(true, false);
-            }
-            break;
+void Ledstrip::setMode(uint8_t mode, uint8_t segment) {
+    if (segment != ALL_SEGMENTS && segment >= _numberOfSegments) {
+        _l.loge("Segment not found");
+        return;
+    }
 
-        case SYSTEM_MODE_PULSES:
-            systemPulses();
-            break;
-        case SYSTEM_MODE_ALARM:
-            systemAlarm();
-            break;
-        default:
-            _l.loge("Mode not found");
-            break;
+    if (mode == MODE_DRAWING) {
+        segment = ALL_SEGMENTS;                                                 //Drawings are for the whole strip
+    }
+
+    _sendRenderMessage(RENDER_MESSAGE_SET_MODE, mode, segment);
+
+    if (mode == SYSTEM_MODE_ALARM) {
+        return;                                                                 //Alarm is an overlay, the segments keep their mode
+    }
+
+    if (mode == MODE_DRAWING && !_isOn) {
+        setPower(true);
     }
     
-    _mode = mode;
+    /* Segments are started by the render task, so the saved modes are taken from the message */
+    uint8_t segmentModes[MAX_NUMBER_OF_SEGMENTS];
+    for (uint8_t i = 0; i < MAX_NUMBER_OF_SEGMENTS; i++) {
+        segmentModes[i] = segment == ALL_SEGMENTS || segment == i ? mode : _segments[i].mode;
+    }
+
     _nvMemory.begin(NV_MEM_CONFIG);
-    _nvMemory.putUChar("mode", mode);
+    _nvMemory.putUChar("mode", segmentModes[0]);
+    _nvMemory.putBytes("segmentModes", segmentModes, MAX_NUMBER_OF_SEGMENTS);
     _nvMemory.end();
 }
 
 /******************************************************************************/
 /*!
-  @brief    Configures the specified mode.
+  @brief    Configures the specified mode. The parameters are handed over to
+            the render task, segments running the mode use them from the next
+            frame. Parameters of one segment are used instead of the
+            parameters of the mode whenever the segment starts the mode,
+            configuring the mode itself removes them.
   @param    mode                Mode ID
   @param    parameters          Parameters of the mode
   @param    save                If true, gets saved in non-volatile memory
+  @param    segment             Only configures the mode of this segment,
+                                ALL_SEGMENTS for the mode itself
 */
 /******************************************************************************/
-void Ledstrip::configureMode(uint8_t mode, ModeParameters parameters, bool save) {
-    _modeParameters[mode] = parameters;
+void Ledstrip::configureMode(uint8_t mode, ModeParameters parameters, bool save, uint8_t segment) {
+    if (mode == 0 || mode >= NUM_MODES) {
+        _l.loge("Mode has no parameters");
+        return;
+    }
 
-    if (save) {
-        _memoryManager.writeModeParameters(mode, parameters);
+    if (segment != ALL_SEGMENTS && segment >= _numberOfSegments) {
+        _l.loge("Segment not found");
+        return;
+    }
+
+    if (save && segment == ALL_SEGMENTS) {
+        _memoryManager.writeModeParameters(mode, parameters, getModeParameterFlags(mode));
+
+        for (uint8_t i = 0; i < MAX_NUMBER_OF_SEGMENTS; i++) {
+            _memoryManager.removeSegmentModeParameters(i, mode);
+        }
+    } else if (save) {
+        _memoryManager.writeSegmentModeParameters(segment, mode, parameters);
     }
 
+    RenderMessage message;
+    message.type = RENDER_MESSAGE_CONFIGURE_MODE;
+    message.value = mode;
+    message.segment = segment;
+    message.parameters = parameters;
+    _sendRenderMessage(message);
+
     _l.logd("Configured mode: " + String(mode));
 }
 
+/******************************************************************************/
+/*!
+  @brief    Sets the segments of the strip. The segments are a JSON array with
+            the length of every segment, from the start of the strip. Lengths
+            are clipped to the strip, LEDs after the last segment are added to
+            it.
+  @param    segmentsJson        JSON string with segment lengths
+  @returns  bool                True if a restart is needed to apply it
+*/
+/******************************************************************************/
+bool Ledstrip::setSegments(String segmentsJson) {
+    _nvMemory.begin(NV_MEM_CONFIG);
+    _nvMemory.putString("segments", segmentsJson);
+    _nvMemory.end();
+
+    JsonDocument jsonParser;
+    deserializeJson(jsonParser, segmentsJson);                                  //Convert JSON string to object
+
+    uint16_t segmentLengths[MAX_NUMBER_OF_SEGMENTS];
+    uint8_t numberOfSegments = _parseSegments(jsonParser, segmentLengths);
+
+    /* Segments share the scratch buffer and the render task, so they are applied at boot */
+    if (numberOfSegments != _numberOfSegments) {
+        return true;
+    }
+    for (uint8_t i = 0; i < numberOfSegments; i++) {
+        if (segmentLengths[i] != _segments[i].length) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /******************************************************************************/
 /*!
   @brief    Sets the power animation.
@@ -339,2542 +293,3009 @@ void Ledstrip::setPowerAnimation(uint8_t animation) {
 
 /******************************************************************************/
 /*!
-  @brief    Sets the pixel addressing configuration.
+  @brief    Sets the pixel addressing configuration. The addresses are a
+            JSON array with one address per LED, or an array of arrays with
+            the addresses per output (data pin).
   @param    addressesJson       JSON string with addresses
   @param    numberOfLeds        Number of LEDs
+  @returns  bool                True if a restart is needed to apply it
 */
 /******************************************************************************/
-void Ledstrip::setPixelAddressing(String addressesJson, uint16_t numberOfLeds) {
+bool Ledstrip::setPixelAddressing(String addressesJson, uint16_t numberOfLeds) {
     _nvMemory.begin(NV_MEM_CONFIG);
     _nvMemory.putString("ledAddresses", addressesJson);
     _nvMemory.putUShort("numberLeds", numberOfLeds);
     _nvMemory.end();
-        
-    JsonDocument jsonParser;
 
+    JsonDocument jsonParser;
     deserializeJson(jsonParser, addressesJson);                                 //Convert JSON string to object
+
+    /* Buffers and output controllers are created at boot, a new layout needs a restart */
+    uint16_t outputLengths[MAX_NUMBER_OF_OUTPUTS];
+    uint8_t numberOfOutputs = _parseOutputs(jsonParser, numberOfLeds, outputLengths);
     
-    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        _ledAddresses[i] = (uint16_t) jsonParser[i];
+    if (numberOfLeds != _numberLeds || numberOfOutputs != _numberOfOutputs || memcmp(outputLengths, _outputLengths, numberOfOutputs * sizeof(uint16_t)) != 0) {
+        _l.logi("Output layout changed, restart needed");
+        return true;
+    }
+
+    /* Frame and canvases are allocated for the highest address, same layout so the outputs can be parsed already */
+    uint16_t frameSize = addressesJson == "" ? _numberLeds : _getFrameSize(jsonParser);
+    if (frameSize != _highestPixelAddress) {
+        _l.logi("Highest pixel address changed, restart needed");
+        return true;
+    }
+
+    /* Hold the fence, so the output task does not remap while the runs change */
+    if (xSemaphoreTake(_frameFence, pdMS_TO_TICKS(FRAME_FENCE_TIMEOUT)) != pdTRUE) {
+        _l.logw("Output task did not release frame in time, addressing is applied after a restart");
+        return true;
     }
+    _parsePixelAddresses(jsonParser);
+    _compilePixelAddresses();
+    _forceNextFrame = true;                                                     //Same frame has to be sent again with the new addressing
+    xSemaphoreGive(_frameFence);
+
+    return false;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Draws the specified LEDs.
-  @param    leds                LEDs array
+  @brief    Draws the specified LEDs. The LEDs are copied into a buffer of the
+            render message, the render task copies them into _leds between
+            two frames.
+  @param    leds                LEDs array, size: number of LEDs
 */
 /******************************************************************************/
 void Ledstrip::drawPixels(CRGB leds[]) {
-    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        _leds[i] = leds[i];
+    if (_leds == NULL) {
+        _l.loge("No pixel buffers, cannot draw");
+        return;
     }
-    
-    _showLeds();
+
+    RenderMessage message;
+    message.type = RENDER_MESSAGE_DRAW;
+    message.leds = (CRGB *) malloc(min(_highestPixelAddress, _numberLeds) * sizeof(CRGB));
+
+    if (message.leds == NULL) {
+        _l.loge("Not enough memory to draw");
+        return;
+    }
+
+    memcpy(message.leds, leds, min(_highestPixelAddress, _numberLeds) * sizeof(CRGB));
+    _sendRenderMessage(message);                                                //Only the render task writes _leds and presents frames
+}
+
+#pragma region Mode registry
+/* Mode registry, one descriptor per slot. Modes up to the last template are
+   stored at their ID, so finding a mode is one table lookup. */
+const Mode Ledstrip::_modes[NUMBER_OF_MODE_SLOTS] = {
+    {MODE_DRAWING, "drawing", ENTRY_COLORS_BLACK, NULL, &Ledstrip::_renderStatic, 0, false},
+    {MODE_COLOR, "color", ENTRY_COLORS_COLOR1, NULL, &Ledstrip::_renderStatic, PARAMETER_COLOR1, true},
+    {MODE_FADE, "fade", ENTRY_COLORS_COLOR_WHEEL, NULL, &Ledstrip::_renderFade, PARAMETER_DELAY, true},
+    {MODE_GRADIENT, "gradient", ENTRY_COLORS_GRADIENT, NULL, &Ledstrip::_renderGradient,
+        PARAMETER_MIN_COLOR_POS | PARAMETER_MAX_COLOR_POS | PARAMETER_WAVE_LENGTH | PARAMETER_DELAY, true},
+    {MODE_BLINK, "blink", ENTRY_COLORS_COLOR1_GRADIENT, NULL, &Ledstrip::_renderBlink,
+        PARAMETER_COLORS | PARAMETER_DELAY, true},
+    {MODE_SCAN, "scan", ENTRY_COLORS_COLOR2_GRADIENT, &Ledstrip::_beginScan, &Ledstrip::_renderScan,
+        PARAMETER_COLORS | PARAMETER_DELAY | PARAMETER_SEGMENT_SIZE | PARAMETER_TAIL_LENGTH, false},
+    {MODE_THEATER, "theater", ENTRY_COLORS_COLOR2_GRADIENT, &Ledstrip::_beginTheater, &Ledstrip::_renderTheater,
+        PARAMETER_COLORS | PARAMETER_DIRECTION | PARAMETER_DELAY | PARAMETER_SEGMENT_SIZE, true},
+    {MODE_SINE, "sine", ENTRY_COLORS_COLOR2, NULL, &Ledstrip::_renderSine,
+        PARAMETER_COLORS | PARAMETER_DIRECTION | PARAMETER_DELAY | PARAMETER_WAVE_LENGTH, true},
+    {MODE_BOUNCING_BALLS, "bouncing_balls", ENTRY_COLORS_COLOR2, &Ledstrip::_beginBouncingBalls, &Ledstrip::_renderBouncingBalls,
+        PARAMETER_COLORS | PARAMETER_NUMBER_OF_ELEMENTS | PARAMETER_SEGMENT_SIZE, false},
+    {MODE_DISSOLVE, "dissolve", ENTRY_COLORS_COLOR2, &Ledstrip::_beginPixelFades, &Ledstrip::_renderDissolve,
+        PARAMETER_COLORS | PARAMETER_DELAY | PARAMETER_TIME_FADE | PARAMETER_DELAY_BETWEEN | PARAMETER_NUMBER_OF_ELEMENTS, false},
+    {MODE_SPARKLE, "sparkle", ENTRY_COLORS_COLOR2, &Ledstrip::_beginPixelFades, &Ledstrip::_renderSparkle,
+        PARAMETER_COLORS | PARAMETER_INTENSITY | PARAMETER_DELAY_BETWEEN | PARAMETER_TIME_FADE | PARAMETER_NUMBER_OF_ELEMENTS, false},
+    {MODE_FIREWORKS, "fireworks", ENTRY_COLORS_BLACK, NULL, &Ledstrip::_renderFireworks,
+        PARAMETER_PALETTE | PARAMETER_DELAY_BETWEEN | PARAMETER_RANDOMNESS_DELAY, false},
+    {MODE_FIRE, "fire", ENTRY_COLORS_BLACK, &Ledstrip::_beginFire, &Ledstrip::_renderFire,
+        PARAMETER_PALETTE | PARAMETER_SEGMENT_SIZE | PARAMETER_DELAY, false},
+    {MODE_SWEEP, "sweep", ENTRY_COLORS_COLOR1_GRADIENT, NULL, &Ledstrip::_renderSweep,
+        PARAMETER_COLORS | PARAMETER_FADE_LENGTH | PARAMETER_DELAY | PARAMETER_DELAY_BETWEEN, true},
+    {MODE_COLOR_TWINKELS, "color_twinkels", ENTRY_COLORS_BLACK, &Ledstrip::_beginColorTwinkels, &Ledstrip::_renderColorTwinkels,
+        PARAMETER_PALETTE | PARAMETER_TIME_FADE | PARAMETER_DELAY | PARAMETER_DELAY_BETWEEN, false},
+    {MODE_METEOR_RAIN, "meteor_rain", ENTRY_COLORS_BLACK, NULL, &Ledstrip::_renderMeteorRain,
+        PARAMETER_COLOR1 | PARAMETER_USE_GRADIENT1 | PARAMETER_SEGMENT_SIZE | PARAMETER_TAIL_LENGTH | PARAMETER_DELAY | PARAMETER_DELAY_BETWEEN | PARAMETER_RANDOMNESS_DELAY, false},
+    {MODE_COLOR_WAVES, "color_waves", ENTRY_COLORS_BLACK, NULL, &Ledstrip::_renderColorWaves, PARAMETER_PALETTE, true},
+    {MODE_TEMPLATE_1, "template_1", ENTRY_COLORS_BLACK, NULL, &Ledstrip::_renderModeTemplate, 0, false},
+    {MODE_TEMPLATE_2, "template_2", ENTRY_COLORS_NONE, NULL, &Ledstrip::_renderModeTemplate, 0, false},
+    {MODE_TEMPLATE_3, "template_3", ENTRY_COLORS_NONE, NULL, &Ledstrip::_renderModeTemplate, 0, false},
+    {MODE_TEMPLATE_4, "template_4", ENTRY_COLORS_NONE, NULL, &Ledstrip::_renderModeTemplate, 0, false},
+    {MODE_TEMPLATE_5, "template_5", ENTRY_COLORS_NONE, NULL, &Ledstrip::_renderModeTemplate, 0, false},
+    {MODE_TEMPLATE_6, "template_6", ENTRY_COLORS_NONE, NULL, &Ledstrip::_renderModeTemplate, 0, false},
+    {MODE_TEMPLATE_7, "template_7", ENTRY_COLORS_NONE, NULL, &Ledstrip::_renderModeTemplate, 0, false},
+    {MODE_TEMPLATE_8, "template_8", ENTRY_COLORS_NONE, NULL, &Ledstrip::_renderModeTemplate, 0, false},
+    {MODE_TEMPLATE_9, "template_9", ENTRY_COLORS_NONE, NULL, &Ledstrip::_renderModeTemplate, 0, false},
+    {MODE_TEMPLATE_10, "template_10", ENTRY_COLORS_NONE, NULL, &Ledstrip::_renderModeTemplate, 0, false},
+    {SYSTEM_MODE_PULSES, "system_pulses", ENTRY_COLORS_BLACK, &Ledstrip::_beginSystemPulses, &Ledstrip::_renderSystemPulses, 0, false}
+};
+
+/******************************************************************************/
+/*!
+  @brief    Finds the descriptor of the specified mode. The render task calls
+            the functions of the descriptor, so the mode is only looked up
+            when it starts.
+  @param    mode                Mode ID
+  @returns  const Mode*         Mode descriptor, the drawing mode if not found
+*/
+/******************************************************************************/
+const Mode* Ledstrip::_findMode(uint8_t mode) {
+    if (mode <= MODE_TEMPLATE_10) {
+        return &_modes[mode];
+    }
+    if (mode == SYSTEM_MODE_PULSES) {
+        return &_modes[MODE_SLOT_SYSTEM_PULSES];
+    }
+    return &_modes[MODE_SLOT_DRAWING];
 }
 
-#pragma region Modes
 /******************************************************************************/
 /*!
-  @brief    Fade leds to the specified color.
+  @brief    Returns the configurable parameters of the specified mode.
+  @param    mode                Mode ID
+  @returns  uint32_t            PARAMETER_* flags, 0 if the mode has no
+                                parameters
 */
 /******************************************************************************/
-void Ledstrip::color() {
-    _fullColor = _modeParameters[MODE_COLOR].color1;
-    _fadeToColor();
-
-    _waitUntilIdle();
-
-    _l.logi("Color mode");
-    
-    _mode = MODE_COLOR;
-    _state = _READY_TO_RUN;
+uint32_t Ledstrip::getModeParameterFlags(uint8_t mode) {
+    return _findMode(mode)->parameterFlags;
 }
+#pragma endregion
 
+#pragma region Segments
 /******************************************************************************/
 /*!
-  @brief    Fade of all colors possible, all LEDs same color.
+  @brief    Starts the specified mode on one or all segments, without saving
+            it. Segments that keep their mode continue where they were. The
+            alarm is started as overlay, any other mode ends it. Called by
+            the render task.
+  @param    mode                Mode ID
+  @param    segment             Segment index or ALL_SEGMENTS
 */
 /******************************************************************************/
-void Ledstrip::fade() {
-    _fullColor = _colorWheel(_modeParameters[MODE_FADE].colorPosition);
-    
-    _fadeToColor();
+void Ledstrip::_startMode(uint8_t mode, uint8_t segment) {
+    if (mode == SYSTEM_MODE_ALARM) {
+        _layers[LAYER_ALARM] = Layer();
+        _layers[LAYER_ALARM].isEnabled = true;
+        _layers[LAYER_ALARM].isAnimated = true;
+        _layers[LAYER_ALARM].nextFrameTime = xTaskGetTickCount();
+        _l.logi("Start alarm");
+        return;
+    }
 
-    _waitUntilIdle();
-    
-    _mode = MODE_FADE;
-    _state = _LOOPING;
-    
-    _l.logi("Start fade mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority, 1 seems to work just fine for us
-        &_taskHandler,                                                          //Task handle
-        CORE_NUMBER                                                             //Task CPU core, 1 is where usually the Arduino Framework code (setup and loop function) are running,
-                                                                                //core 0 by default runs the Wifi Stack
-    );
+    _layers[LAYER_ALARM].isEnabled = false;
+    _layers[LAYER_ALARM].isAnimated = false;
+
+    for (uint8_t i = 0; i < _numberOfSegments; i++) {
+        if (segment != ALL_SEGMENTS && segment != i) {
+            continue;
+        }
+        _segments[i].mode = mode;
+        _startSegment(_segments[i]);
+    }
+
+    _l.logi("Start mode " + String(_findMode(mode)->name) + " on " + (segment == ALL_SEGMENTS ? "all segments" : "segment " + String(segment)));
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. Fade of all colors possible.
+  @brief    Restarts the mode of every segment.
 */
 /******************************************************************************/
-void Ledstrip::__fade() {
-    while (1) {
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            _leds[i] = _colorWheel(_modeParameters[MODE_FADE].colorPosition);
-        }
-
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_FADE].delay);
-        
-        _modeParameters[MODE_FADE].colorPosition++;
+void Ledstrip::_startModes() {
+    for (uint8_t i = 0; i < _numberOfSegments; i++) {
+        _startSegment(_segments[i]);
     }
 }
 
 /******************************************************************************/
 /*!
-  @brief    Fade of gradient tints in a rainbow style across strip.
+  @brief    Resets the segment to the start of its mode. The previous mode
+            keeps running while it is crossfaded into the new mode.
+  @param    segment             Segment to start
 */
 /******************************************************************************/
-void Ledstrip::gradient() {
-    _fadeToMultipleColors(_modeParameters[MODE_GRADIENT].colorPosition, true);
+void Ledstrip::_startSegment(Segment &segment) {
+    TickType_t now = xTaskGetTickCount();
+    uint32_t time = pdTICKS_TO_MS(now);
 
-    _waitUntilIdle();
-    
-    _mode = MODE_GRADIENT;
-    _state = _LOOPING;
+    _resetRotation(segment);                                                    //Next mode starts on the colors as they are visible
+    _startTransition(segment, time);
 
-    _l.logi("Start gradient mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    segment.parameters = _getModeParameters(segment.mode, &segment - _segments);
+
+    segment.activeMode = _findMode(segment.mode);
+    segment.state = SegmentState();
+    segment.state.nextFrameTime = now;
+    segment.state.startTime = time;
+    segment.state.phase = SEGMENT_RUNNING;
+    segment.state.seed = RANDOM_SEED != 0 ? RANDOM_SEED + segment.start : esp_random();
+    segment.state.random.seed(segment.state.seed);
+
+    _setEntryColors(segment);
+
+    if (segment.activeMode->begin != NULL) {
+        (this->*segment.activeMode->begin)(segment, time);
+    }
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. Fade of gradient tints in a rainbow style across strip.
-           
+  @brief    Applies the parameters of a configured mode. Segments running the
+            mode continue with the new parameters. Called by the render task.
+  @param    mode                Mode ID
+  @param    parameters          Parameters of the mode
+  @param    segment             Segment index, ALL_SEGMENTS for the mode itself
 */
 /******************************************************************************/
-void Ledstrip::__gradient() {
-    int8_t direction = 1;
+void Ledstrip::_applyModeParameters(uint8_t mode, ModeParameters &parameters, uint8_t segment) {
+    if (segment == ALL_SEGMENTS) {
+        _modeParameters[mode] = parameters;
 
-    while (1) {
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            uint8_t colorPosition = _getGradientColorPosition(i);
-            _leds[i] = _colorWheel(colorPosition);
-            _leds[_highestPixelAddress-1 - i] = _colorWheel(colorPosition);     //gradient begins on right and left side and ends in middle, so split strip in half
+        for (uint8_t i = 0; i < MAX_NUMBER_OF_SEGMENTS; i++) {
+            _segmentModeOverrides[i] &= ~(1UL << mode);
         }
-        
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_GRADIENT].delay);
-        _modeParameters[MODE_GRADIENT].colorPosition += direction;
-        
-        if (_modeParameters[MODE_GRADIENT].colorPosition > _modeParameters[MODE_GRADIENT].maxColorPos) {
-            direction = -1;
-        } else if (_modeParameters[MODE_GRADIENT].colorPosition < _modeParameters[MODE_GRADIENT].minColorPos) {
-            direction = 1;
+    } else {
+        _segmentModeParameters[segment][mode] = parameters;
+        _segmentModeOverrides[segment] |= 1UL << mode;
+    }
+
+    for (uint8_t i = 0; i < _numberOfSegments; i++) {
+        if (_segments[i].mode != mode || (segment != ALL_SEGMENTS && segment != i)) {
+            continue;
         }
+        uint8_t colorPosition = _segments[i].parameters.colorPosition;          //Keep the start position of the running mode
+        _segments[i].parameters = parameters;
+        _segments[i].parameters.colorPosition = colorPosition;
     }
 }
 
 /******************************************************************************/
 /*!
-  @brief    Blinking between two colors.
+  @brief    Returns the parameters the specified segment runs the specified
+            mode with, its own parameters if it has them.
+  @param    mode                Mode ID
+  @param    segment             Segment index
+  @returns  ModeParameters      Parameters, the defaults for modes without
+                                parameters
 */
 /******************************************************************************/
-void Ledstrip::blink() {
-    if (_modeParameters[MODE_BLINK].useGradient1) {
-        _fadeToMultipleColors(0);
-    } else {
-        _fullColor = _modeParameters[MODE_BLINK].color1;
-        _fadeToColor();
+const ModeParameters& Ledstrip::_getModeParameters(uint8_t mode, uint8_t segment) {
+    static const ModeParameters noParameters;                                   //Templates and system modes have no parameters
+
+    if (mode >= NUM_MODES) {
+        return noParameters;
     }
-    
-    _waitUntilIdle();
-     
-    _mode = MODE_BLINK;
-    _state = _LOOPING;
 
-    _l.logi("Start blink mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    if (segment < MAX_NUMBER_OF_SEGMENTS && (_segmentModeOverrides[segment] & (1UL << mode))) {
+        return _segmentModeParameters[segment][mode];
+    }
+
+    return _modeParameters[mode];
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. Blinking between two colors.
+  @brief    Hands the running mode of the segment over to its outgoing
+            segment, with a copy of the canvas and scratch memory, so it
+            keeps running while the new mode fades in. A transition that is
+            still running is frozen at its current blend.
+  @param    segment             Segment
+  @param    time                Start time of the transition, in ms
 */
 /******************************************************************************/
-void Ledstrip::__blink() {
-    uint8_t colorPosition1 = 0;
-    uint8_t colorPosition2 = 255;
-    int8_t colorDirection1 = 1;
-    int8_t colorDirection2 = -1;
-
-    while (1) {
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            if (_modeParameters[MODE_BLINK].useGradient1) {
-                _leds[i] = _colorWheel((i + colorPosition1) & 255);
-            } else {
-                _leds[i] = _modeParameters[MODE_BLINK].color1;
-            }
-        }
+void Ledstrip::_startTransition(Segment &segment, uint32_t time) {
+    Segment &outgoing = *segment.outgoing;
 
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_BLINK].delay);
-
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            if (_modeParameters[MODE_BLINK].useGradient2) {
-                _leds[i] = _colorWheel((i + colorPosition2) & 255);
-            } else {
-                _leds[i] = _modeParameters[MODE_BLINK].color2;
-            }
-        }
+    if (segment.isTransitioning) {
+        _resetRotation(outgoing);
+        _fadeColors(outgoing.leds, outgoing.leds, segment.leds, segment.transitionProgress, segment.length);
+        outgoing.state.phase = SEGMENT_IDLE;
+    } else {
+        memcpy(outgoing.leds, segment.leds, segment.length * sizeof(CRGB));
+        memcpy(outgoing.scratch, segment.scratch, segment.length * SCRATCH_BYTES_PER_LED + SCRATCH_EXTRA_BYTES);
+        outgoing.activeMode = segment.activeMode;
+        outgoing.parameters = segment.parameters;
+        outgoing.state = segment.state;
 
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_BLINK].delay);
-        
-        if (_modeParameters[MODE_BLINK].useGradient1) {
-            colorPosition1 += colorDirection1;
-            if (colorPosition1 == 255 || colorPosition1 == 0) {
-                colorDirection1 = -colorDirection1;
-            }
-        }
-        if (_modeParameters[MODE_BLINK].useGradient2) {
-            colorPosition2 += colorDirection2;
-            if (colorPosition2 == 255 || colorPosition2 == 0) {
-                colorDirection2 = -colorDirection2;
-            }
+        if (outgoing.activeMode == NULL) {
+            outgoing.state.phase = SEGMENT_IDLE;                                //Nothing ran yet, fade in from the current colors
         }
     }
+
+    segment.isTransitioning = true;
+    segment.transitionStartTime = time;
+    segment.transitionProgress = 0;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Moving dot/segment between endpoints.
+  @brief    Rotates the canvas of the segment by its rotation offset, so the
+            canvas holds the colors as they are visible, and clears the
+            offset.
+  @param    segment             Segment
 */
 /******************************************************************************/
-void Ledstrip::scan() {
-    if (_modeParameters[MODE_SCAN].useGradient2) {
-        _fadeToMultipleColors(0);
-    } else {
-        _fullColor = _modeParameters[MODE_SCAN].color2;
-        _fadeToColor();
+void Ledstrip::_resetRotation(Segment &segment) {
+    if (segment.state.rotation != 0) {
+        _rotateLeft(segment.leds, segment.length, segment.state.rotation);
+        segment.state.rotation = 0;
     }
-
-    _waitUntilIdle();
-     
-    _mode = MODE_SCAN;
-    _state = _LOOPING;
-    
-    _l.logi("Start scan mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. Moving dot/segment between endpoints.
+  @brief    Renders the outgoing mode of the segment and moves the crossfade
+            on. The crossfade is a fixed duration ramp, independent of the
+            steps of both modes.
+  @param    segment             Segment
+  @param    now                 Time of the frame, in ticks
+  @returns  bool                False when the transition ended
 */
 /******************************************************************************/
-void Ledstrip::__scan() {
-    uint16_t padding = _modeParameters[MODE_SCAN].segmentSize + _modeParameters[MODE_SCAN].tailLength;
-    uint16_t segmentLocation = padding;                                         //Padding because there is where the leds will start to shine
-    int8_t segmentDirection = 1;
+bool Ledstrip::_renderTransition(Segment &segment, TickType_t now) {
+    Segment &outgoing = *segment.outgoing;
+    uint32_t elapsed = pdTICKS_TO_MS(now) - segment.transitionStartTime;
 
-    uint8_t colorPosition1 = 0;
-    uint8_t colorPosition2 = 255;
-    int8_t colorDirection1 = 1;
-    int8_t colorDirection2 = -1;
-    
-    while (1) {
-        /* Draw background */
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            if (_modeParameters[MODE_SCAN].useGradient2) {
-                _leds[i] = _colorWheel((i + colorPosition2) & 255);
-            } else {
-                _leds[i] = _modeParameters[MODE_SCAN].color2;
-            }
-        }
+    segment.transitionProgress = _getFadeProgress(elapsed, MODE_TRANSITION_TIME);
 
-        /* Draw tail */
-        float color1Portion = 0;
-        CRGB tailColor;
-        CRGB color1;
-        CRGB color2;
-        
-        if (_modeParameters[MODE_SCAN].useGradient1) {
-            color1 = _colorWheel(colorPosition1 & 255);
-        } else {
-            color1 = _modeParameters[MODE_SCAN].color1;
+    if (segment.transitionProgress == FADE_PROGRESS_END) {
+        segment.isTransitioning = false;
+        return false;
+    }
+
+    if (outgoing.state.phase != SEGMENT_IDLE && (int32_t) (now - outgoing.state.nextFrameTime) >= 0) {
+        if (!_renderSegment(outgoing, now)) {
+            outgoing.state.phase = SEGMENT_IDLE;
         }
-        if (_modeParameters[MODE_SCAN].useGradient2) {
-            color2 = _colorWheel(colorPosition2 & 255);
-        } else {
-            color2 = _modeParameters[MODE_SCAN].color2;
-        }
-
-        for (uint8_t i = 0; i < _modeParameters[MODE_SCAN].tailLength; i++) {
-            color1Portion = (_modeParameters[MODE_SCAN].tailLength - i) * 1.0 / _modeParameters[MODE_SCAN].tailLength;
-            color1Portion = color1Portion / 2;
-            
-            tailColor = _blendColors(color1, color1Portion, color2);
-            
-            if (segmentDirection == 1 && segmentLocation - padding - _modeParameters[MODE_SCAN].segmentSize - i >= 0) {
-                _leds[segmentLocation - padding - _modeParameters[MODE_SCAN].segmentSize - i] = tailColor;
-            } else if (segmentDirection == -1 && segmentLocation - padding + i < _highestPixelAddress) {
-                _leds[segmentLocation - padding + i] = tailColor;
+    }
+
+    return true;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Sets the colors the canvas of the segment starts with, for modes
+            that draw over their previous frame or do not draw at all.
+  @param    segment             Segment
+*/
+/******************************************************************************/
+void Ledstrip::_setEntryColors(Segment &segment) {
+    CRGB* leds = segment.leds;
+    ModeParameters &parameters = segment.parameters;
+    bool useGradient = false;
+    CRGB color = CRGB(0, 0, 0);                                                 //Black background by default
+
+    switch (segment.activeMode->entryColors) {
+        case ENTRY_COLORS_NONE:
+            return;
+        case ENTRY_COLORS_COLOR1:
+            color = parameters.color1;
+            break;
+        case ENTRY_COLORS_COLOR1_GRADIENT:
+            useGradient = parameters.useGradient1;
+            color = parameters.color1;
+            break;
+        case ENTRY_COLORS_COLOR2:
+            color = parameters.color2;
+            break;
+        case ENTRY_COLORS_COLOR2_GRADIENT:
+            useGradient = parameters.useGradient2;
+            color = parameters.color2;
+            break;
+        case ENTRY_COLORS_COLOR_WHEEL:
+            color = _colorWheel(parameters.colorPosition);
+            break;
+        case ENTRY_COLORS_GRADIENT:
+            for (uint16_t i = 0; i < segment.length; i++) {
+                uint8_t colorPosition = _getGradientColorPosition(i, parameters, parameters.colorPosition);
+                leds[i] = _colorWheel(colorPosition);
+                leds[segment.length-1 - i] = _colorWheel(colorPosition);
             }
+            return;
+        default:
+            break;
+    }
+
+    for (uint16_t i = 0; i < segment.length; i++) {
+        if (useGradient) {
+            leds[i] = _colorWheel(i & 255);
+            leds[segment.length-1 - i] = _colorWheel(i & 255);
+        } else {
+            leds[i] = color;
         }
-        
-        /* Draw scan leds */
-        for (uint8_t i = 0; i < _modeParameters[MODE_SCAN].segmentSize; i++) {
-            if (segmentLocation - padding - i < 0) {
-                break;
-            }
-            if (_modeParameters[MODE_SCAN].useGradient1) {
-                _leds[segmentLocation - padding - i] = _colorWheel((i + colorPosition1) & 255);
-            } else {
-                _leds[segmentLocation - padding - i] = _modeParameters[MODE_SCAN].color1;
-            }
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Renders the segment into its canvas as it is at the specified
+            time. A seekable mode renders only the step at the time of the
+            frame. For other modes, every step that is due runs with its own
+            time, so the speed of the mode does not depend on how often
+            frames are rendered.
+  @param    segment             Segment
+  @param    now                 Time of the frame, in ticks
+  @returns  bool                False if the segment does not change anymore
+*/
+/******************************************************************************/
+bool Ledstrip::_renderSegment(Segment &segment, TickType_t now) {
+    SegmentState &state = segment.state;
+
+    if (segment.activeMode->isSeekable) {
+        uint16_t period = (this->*segment.activeMode->renderFrame)(segment, pdTICKS_TO_MS(now));
+        if (period == FRAME_IDLE) {
+            return false;
         }
-        
-        _showLeds();
-        if (_modeParameters[MODE_SCAN].useGradient1) {
-            colorPosition1 += colorDirection1;
-            if (colorPosition1 == 255 || colorPosition1 == 0) {
-                colorDirection1 = -colorDirection1;
-            }
+
+        state.nextFrameTime = now + max(pdMS_TO_TICKS(period), (TickType_t) 1);
+        return true;
+    }
+
+    for (uint8_t step = 0; (int32_t) (now - state.nextFrameTime) >= 0; step++) {
+        if (step == MAX_STEPS_PER_FRAME) {
+            state.nextFrameTime = now + 1;                                      //Too far behind, skip the remaining steps
+            break;
         }
-        if (_modeParameters[MODE_SCAN].useGradient2) {
-            colorPosition2 += colorDirection2;
-            if (colorPosition2 == 255 || colorPosition2 == 0) {
-                colorDirection2 = -colorDirection2;
-            }
+
+        uint16_t period = (this->*segment.activeMode->renderFrame)(segment, pdTICKS_TO_MS(state.nextFrameTime));
+        if (period == FRAME_IDLE) {
+            return false;
         }
 
-        /* No need to wait if no scanline has been drawn */
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {//TODO can be deletd?
-            /* If something is drawn, wait */
-            if (_leds[i] != _modeParameters[MODE_SCAN].color2) {
-                vTaskDelay(_modeParameters[MODE_SCAN].delay);
-                break;
+        /* At least one tick per step, a period of 0 (like a delay of 0) would run MAX_STEPS_PER_FRAME steps in every frame */
+        state.nextFrameTime += max(pdMS_TO_TICKS(period), (TickType_t) 1);
+    }
+
+    return true;
+}
+#pragma endregion
+
+#pragma region Modes
+/******************************************************************************/
+/*!
+  @brief    Fade of all colors possible, all LEDs same color. Every step
+            moves one position on the color wheel.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
+*/
+/******************************************************************************/
+uint16_t Ledstrip::_renderFade(Segment &segment, uint32_t time) {
+    CRGB* leds = segment.leds;
+    ModeParameters &parameters = segment.parameters;
+    CRGB color = _colorWheel(parameters.colorPosition + _getModeStep(segment, time, parameters.delay));
+
+    for (uint16_t i = 0; i < segment.length; i++) {
+        leds[i] = color;
+    }
+
+    return _getTimeToNextStep(segment, time, parameters.delay);
+}
+
+/******************************************************************************/
+/*!
+  @brief    Fade of gradient tints in a rainbow style across the segment. The
+            gradient moves one position per step, bouncing between the min and
+            max color position.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
+*/
+/******************************************************************************/
+uint16_t Ledstrip::_renderGradient(Segment &segment, uint32_t time) {
+    CRGB* leds = segment.leds;
+    ModeParameters &parameters = segment.parameters;
+    uint8_t startPosition = constrain(parameters.colorPosition, parameters.minColorPos, parameters.maxColorPos);
+    uint32_t steps = _getModeStep(segment, time, parameters.delay) + startPosition - parameters.minColorPos;
+    uint8_t colorPosition = _getBouncePosition(steps, parameters.minColorPos, parameters.maxColorPos);
+
+    for (uint16_t i = 0; i < segment.length; i++) {
+        uint8_t ledColorPosition = _getGradientColorPosition(i, parameters, colorPosition);
+        leds[i] = _colorWheel(ledColorPosition);
+        leds[segment.length-1 - i] = _colorWheel(ledColorPosition);            //gradient begins on right and left side and ends in middle, so split strip in half
+    }
+
+    return _getTimeToNextStep(segment, time, parameters.delay);
+}
+
+/******************************************************************************/
+/*!
+  @brief    Blinking between two colors, color 1 on even steps and color 2 on
+            odd steps. Gradients move one position per blink, bouncing
+            between both ends of the color wheel.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
+*/
+/******************************************************************************/
+uint16_t Ledstrip::_renderBlink(Segment &segment, uint32_t time) {
+    CRGB* leds = segment.leds;
+    ModeParameters &parameters = segment.parameters;
+    uint32_t step = _getModeStep(segment, time, parameters.delay);
+    uint8_t colorPosition = _getBouncePosition(step / 2, 0, 255);               //Gradient 2 moves the other way, from 255
+
+    if (step % 2 == 0) {
+        for (uint16_t i = 0; i < segment.length; i++) {
+            if (parameters.useGradient1) {
+                leds[i] = _colorWheel((i + colorPosition) & 255);
+            } else {
+                leds[i] = parameters.color1;
             }
         }
-
-        /* Change directions */
-        if (segmentLocation >= _highestPixelAddress + padding*2) {
-            segmentDirection = -1;
-        } else if (segmentLocation == 0) {
-            segmentDirection = 1;
+    } else {
+        for (uint16_t i = 0; i < segment.length; i++) {
+            if (parameters.useGradient2) {
+                leds[i] = _colorWheel((i + 255 - colorPosition) & 255);
+            } else {
+                leds[i] = parameters.color2;
+            }
         }
-        segmentLocation += segmentDirection;
     }
+
+    return _getTimeToNextStep(segment, time, parameters.delay);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Pattern used in old theaters.
+  @brief    Places the scanline before the start of the segment.
+  @param    segment             Segment to prepare
+  @param    time                Time the mode starts, in ms
 */
 /******************************************************************************/
-void Ledstrip::theater() {
-    if (_modeParameters[MODE_THEATER].useGradient2) {
-        _fadeToMultipleColors(0);
+void Ledstrip::_beginScan(Segment &segment, uint32_t time) {
+    segment.state.position = segment.parameters.segmentSize + segment.parameters.tailLength;    //Padding because there is where the leds will start to shine
+}
+
+/******************************************************************************/
+/*!
+  @brief    Moving dot/segment between endpoints.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
+*/
+/******************************************************************************/
+uint16_t Ledstrip::_renderScan(Segment &segment, uint32_t time) {
+    CRGB* leds = segment.leds;
+    ModeParameters &parameters = segment.parameters;
+    SegmentState &state = segment.state;
+    uint16_t padding = parameters.segmentSize + parameters.tailLength;
+    int32_t location = state.position - padding;
+
+    /* Draw background */
+    for (uint16_t i = 0; i < segment.length; i++) {
+        if (parameters.useGradient2) {
+            leds[i] = _colorWheel((i + state.colorPosition2) & 255);
+        } else {
+            leds[i] = parameters.color2;
+        }
+    }
+
+    /* Draw tail */
+    CRGB tailColor;
+    CRGB color1;
+    CRGB color2;
+
+    if (parameters.useGradient1) {
+        color1 = _colorWheel(state.colorPosition1 & 255);
     } else {
-        _fullColor = _modeParameters[MODE_THEATER].color2;
-        _fadeToColor();
+        color1 = parameters.color1;
+    }
+    if (parameters.useGradient2) {
+        color2 = _colorWheel(state.colorPosition2 & 255);
+    } else {
+        color2 = parameters.color2;
     }
-    
-    _fadeToColor();
 
-    _waitUntilIdle();
-     
-    _mode = MODE_THEATER;
-    _state = _LOOPING;
-    
-    _l.logi("Start theater mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    for (uint8_t i = 0; i < parameters.tailLength; i++) {
+        uint8_t alpha = (parameters.tailLength - i) * 128 / parameters.tailLength; //Tail starts at half color 1
+
+        tailColor = _blendColors(color2, color1, alpha);
+
+        int32_t tailIndex = state.direction == 1 ? location - parameters.segmentSize - i : location + i;
+        if (tailIndex >= 0 && tailIndex < segment.length) {
+            leds[tailIndex] = tailColor;
+        }
+    }
+
+    /* Draw scan leds */
+    for (uint8_t i = 0; i < parameters.segmentSize; i++) {
+        if (location - i < 0) {
+            break;
+        }
+        if (location - i >= segment.length) {
+            continue;
+        }
+        if (parameters.useGradient1) {
+            leds[location - i] = _colorWheel((i + state.colorPosition1) & 255);
+        } else {
+            leds[location - i] = parameters.color1;
+        }
+    }
+
+    if (parameters.useGradient1) {
+        state.colorPosition1 += state.colorDirection1;
+        if (state.colorPosition1 == 255 || state.colorPosition1 == 0) {
+            state.colorDirection1 = -state.colorDirection1;
+        }
+    }
+    if (parameters.useGradient2) {
+        state.colorPosition2 += state.colorDirection2;
+        if (state.colorPosition2 == 255 || state.colorPosition2 == 0) {
+            state.colorDirection2 = -state.colorDirection2;
+        }
+    }
+
+    /* No need to wait if no scanline has been drawn */
+    bool isDrawn = false;
+    for (uint16_t i = 0; i < segment.length; i++) {
+        if (leds[i] != parameters.color2) {
+            isDrawn = true;
+            break;
+        }
+    }
+
+    /* Change directions */
+    if (state.position >= segment.length + padding*2) {
+        state.direction = -1;
+    } else if (state.position == 0) {
+        state.direction = 1;
+    }
+    state.position += state.direction;
+
+    return isDrawn ? parameters.delay : 1;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. Pattern used in old theaters. NOT FINISHED TODO
+  @brief    Draws the segments of the theater mode.
+  @param    segment             Segment to prepare
+  @param    time                Time the mode starts, in ms
 */
 /******************************************************************************/
-void Ledstrip::__theater() {
+void Ledstrip::_beginTheater(Segment &segment, uint32_t time) {
+    CRGB* leds = segment.leds;
+    ModeParameters &parameters = segment.parameters;
     uint8_t colorToggle = 0;
     uint8_t dotCounter = 0;
-
     uint8_t colorPosition1 = 0;
     uint8_t colorPosition2 = 255;
-    
+
     /* Draw segments */
-    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        if (dotCounter == _modeParameters[MODE_THEATER].segmentSize) {
+    for (uint16_t i = 0; i < segment.length; i++) {
+        if (dotCounter == parameters.segmentSize) {
             dotCounter = 0;
             colorToggle = !colorToggle;
         }
-        
+
         if (colorToggle) {
-            if (_modeParameters[MODE_THEATER].useGradient1) {
-                _leds[i] = _colorWheel(colorPosition1);
+            if (parameters.useGradient1) {
+                leds[i] = _colorWheel(colorPosition1);
                 colorPosition1++;
             } else {
-                _leds[i] = _modeParameters[MODE_THEATER].color1;
+                leds[i] = parameters.color1;
             }
         } else {
-            if (_modeParameters[MODE_THEATER].useGradient2) {
-                _leds[i]  = _colorWheel(colorPosition2);
+            if (parameters.useGradient2) {
+                leds[i] = _colorWheel(colorPosition2);
                 colorPosition2--;
             } else {
-                _leds[i] = _modeParameters[MODE_THEATER].color2;
+                leds[i] = parameters.color2;
             }
         }
         dotCounter++;
     }
+}
 
-    while (1) {
-        if (_modeParameters[MODE_THEATER].direction == DIRECTION_LEFT) {
-            _rotateLeft();
-        } else {
-            _rotateRight();
-        }
+/******************************************************************************/
+/*!
+  @brief    Pattern used in old theaters. NOT FINISHED TODO
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
+*/
+/******************************************************************************/
+uint16_t Ledstrip::_renderTheater(Segment &segment, uint32_t time) {
+    ModeParameters &parameters = segment.parameters;
+    uint16_t rotation = (_getModeStep(segment, time, parameters.delay) + 1) % segment.length;  //First step already moves the pattern
 
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_THEATER].delay);
+    /* The pattern stays in the canvas, only the rotation offset moves */
+    if (parameters.direction == DIRECTION_LEFT) {
+        segment.state.rotation = rotation;
+    } else {
+        segment.state.rotation = rotation == 0 ? 0 : segment.length - rotation;
     }
+
+    return _getTimeToNextStep(segment, time, parameters.delay);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Sine waves scrolling.
+  @brief    Sine waves scrolling. NOT FINISHED TODO
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
 */
 /******************************************************************************/
-void Ledstrip::sine() {
-    _fullColor = _modeParameters[MODE_SINE].color2;
-    
-    _fadeToColor();
+uint16_t Ledstrip::_renderSine(Segment &segment, uint32_t time) {
+    CRGB* leds = segment.leds;
+    ModeParameters &parameters = segment.parameters;
+    double speed = 0.1;                                                         //Phase per step, in rad
+    uint32_t step = _getModeStep(segment, time, parameters.delay);
+    double phase = fmod((step + 1) * speed, 2 * PI);                            //Remainder of one period, so the phase stays exact after many steps
+    uint8_t colorPosition = parameters.colorPosition + step;
+    uint8_t alpha;
+    //parameters.waveLength MIN 1 MAX 20 todo
 
-    _waitUntilIdle();
-     
-    _mode = MODE_SINE;
-    _state = _LOOPING;
-    
-    _l.logi("Start sine mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    if (parameters.direction != DIRECTION_LEFT) {
+        phase = -phase;
+    }
+
+    for (uint16_t i = 0; i < segment.length; i++) {
+        alpha = (sin(i*2.0/parameters.waveLength + phase) + 1) * 127.5;        //*2 because otherwise wavelength is too big
+
+        if (parameters.useGradient1) {
+            leds[i] = CHSV((colorPosition + i * 5) % 255, 255, alpha);
+        } else {
+            leds[i] = _blendColors(parameters.color1, parameters.color2, alpha);
+        }
+    }
+
+    return _getTimeToNextStep(segment, time, parameters.delay);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. Sine waves scrolling. NOT FINISHED TODO
+  @brief    Drops the balls, as many as fit in the scratch memory.
+  @param    segment             Segment to prepare
+  @param    time                Time the mode starts, in ms
 */
 /******************************************************************************/
-void Ledstrip::__sine() {
-    float speed = 0.1;
-    float time = 0;
-    float colorPortion;
-    uint16_t ledAddress;
-    //_modeParameters[MODE_SINE].waveLength MIN 1 MAX 20 todo
-    while (1) {
-        if (_modeParameters[MODE_SINE].direction == DIRECTION_LEFT) {
-            time += speed;
+void Ledstrip::_beginBouncingBalls(Segment &segment, uint32_t time) {
+    ModeParameters &parameters = segment.parameters;
+    SegmentState &state = segment.state;
+    Ball* balls = (Ball *) segment.scratch;
+    size_t scratchSize = segment.length * SCRATCH_BYTES_PER_LED + SCRATCH_EXTRA_BYTES;
+    state.numberOfElements = min((size_t) parameters.numberOfElements, scratchSize / sizeof(Ball));
+
+    for (uint8_t i = 0; i < state.numberOfElements; i++) {
+        balls[i].lastBounceTime = time;
+        balls[i].impactVelocity = sqrt(-2 * BALL_GRAVITY * BALL_START_HEIGHT);
+        balls[i].dampening = 0.90 - float(i)/pow(state.numberOfElements, 2);
+
+        if (parameters.useGradient1) {
+            balls[i].color = _colorWheel(state.random.next(256));
         } else {
-            time -= speed;
+            balls[i].color = parameters.color1;
         }
+    }
+}
 
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            colorPortion = (sin(i*2.0/_modeParameters[MODE_SINE].waveLength + time) + 1) / 2;//*2 because otherwise wavelength is too big
+/******************************************************************************/
+/*!
+  @brief    Bouncing balls simulation.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
+*/
+/******************************************************************************/
+uint16_t Ledstrip::_renderBouncingBalls(Segment &segment, uint32_t time) {
+    CRGB* leds = segment.leds;
+    ModeParameters &parameters = segment.parameters;
+    Ball* balls = (Ball *) segment.scratch;
+    const float IMPACT_VELOCITY_START = sqrt(-2 * BALL_GRAVITY * BALL_START_HEIGHT);
 
-            if (_modeParameters[MODE_SINE].useGradient1) {
-                _leds[i] = CHSV((_modeParameters[MODE_SINE].colorPosition + i * 5) % 255, 255, colorPortion * 255);
-            } else {
-                _leds[i] = _blendColors(_modeParameters[MODE_SINE].color2, colorPortion, _modeParameters[MODE_SINE].color1);
+    /* Reset leds */
+    for (uint16_t i = 0; i < segment.length; i++) {
+        leds[i] = parameters.color2;
+    }
+
+    for (uint8_t i = 0; i < segment.state.numberOfElements; i++) {
+        float timeSinceLastBounce = time - balls[i].lastBounceTime;
+        float height = 0.5 * BALL_GRAVITY * pow(timeSinceLastBounce/1000, 2.0) + balls[i].impactVelocity * timeSinceLastBounce/1000;
+
+        if (height < 0) {
+            height = 0;
+            balls[i].impactVelocity = balls[i].dampening * balls[i].impactVelocity;
+            balls[i].lastBounceTime = time;
+
+            if (balls[i].impactVelocity < 0.01) {
+                balls[i].impactVelocity = IMPACT_VELOCITY_START;
             }
         }
-        _modeParameters[MODE_SINE].colorPosition++;
+        uint16_t position = round(height * (segment.length - 1) / BALL_START_HEIGHT);
 
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_SINE].delay);
+        /* Draw ball */
+        for (uint8_t ballPixel = 0; ballPixel < parameters.segmentSize && position + ballPixel < segment.length; ballPixel++) {
+            leds[position + ballPixel] = balls[i].color;
+        }
     }
+
+    return 10;                                                                  //100 FPS
 }
 
 /******************************************************************************/
 /*!
-  @brief    Bouncing balls simulation.
+  @brief    Fills the LED order of the dissolve and sparkle modes and sizes
+            the pool of pixel fades behind it. As many LEDs fade at the same
+            time as the number of elements, limited by the scratch memory.
+  @param    segment             Segment to prepare
+  @param    time                Time the mode starts, in ms
 */
 /******************************************************************************/
-void Ledstrip::bouncingBalls() {
-    _fullColor = _modeParameters[MODE_BOUNCING_BALLS].color2;
-    
-    _fadeToColor();
+void Ledstrip::_beginPixelFades(Segment &segment, uint32_t time) {
+    SegmentState &state = segment.state;
+    uint16_t* indexes = (uint16_t *) segment.scratch;
+    size_t scratchSize = segment.length * SCRATCH_BYTES_PER_LED + SCRATCH_EXTRA_BYTES;
+    size_t poolSize = (scratchSize - _getPixelFadesOffset(segment)) / sizeof(PixelFade);
 
-    _waitUntilIdle();
-     
-    _mode = MODE_BOUNCING_BALLS;
-    _state = _LOOPING;
-    
-    _l.logi("Start bouncingBalls mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    for (uint16_t i = 0; i < segment.length; i++) {
+        indexes[i] = i;
+    }
+
+    state.numberOfElements = min(min((size_t) max(segment.parameters.numberOfElements, (uint8_t) 1), poolSize), (size_t) segment.length);
+    state.numberOfActiveElements = 0;
+    state.nextElementTime = time;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. Bouncing balls simulation.
+  @brief    Returns the offset of the pixel fades in the scratch memory, after
+            the LED order.
+  @param    segment             Segment
+  @returns  size_t              Offset in bytes
 */
 /******************************************************************************/
-void Ledstrip::__bouncingBalls() {
-    uint8_t numberOfBalls = _modeParameters[MODE_BOUNCING_BALLS].numberOfElements;
-    uint8_t ballSize = _modeParameters[MODE_BOUNCING_BALLS].segmentSize;
-    const float GRAVITY = -9.81;
-    const uint8_t START_HEIGHT = 10;
-    const float IMPACT_VELOCITY_START = sqrt(-2 * GRAVITY * START_HEIGHT);
-   
-    float height[numberOfBalls];
-    float impactVelocity[numberOfBalls];
-    float timeSinceLastBounce[numberOfBalls];
-    uint16_t position[numberOfBalls];
-    uint64_t clockTimeSinceLastBounce[numberOfBalls];
-    float dampening[numberOfBalls];
-    CRGB ballColors[numberOfBalls];
-    
-    for (uint8_t i = 0; i < numberOfBalls; i++) {  
-        clockTimeSinceLastBounce[i] = millis();
-        height[i] = START_HEIGHT;
-        position[i] = 0;
-        impactVelocity[i] = IMPACT_VELOCITY_START;
-        timeSinceLastBounce[i] = 0;
-        dampening[i] = 0.90 - float(i)/pow(numberOfBalls, 2);
-
-        if (_modeParameters[MODE_BOUNCING_BALLS].useGradient1) {
-            ballColors[i] = _colorWheel(random8());
-        } else {
-            ballColors[i] = _modeParameters[MODE_BOUNCING_BALLS].color1;
+size_t Ledstrip::_getPixelFadesOffset(Segment &segment) {
+    size_t offset = segment.length * sizeof(uint16_t);
+    return (offset + BUFFER_ALIGNMENT - 1) & ~((size_t) BUFFER_ALIGNMENT - 1);
+}
+
+/******************************************************************************/
+/*!
+  @brief    Adds a fade of one LED to the pool. A fade of the same LED that
+            is still running is replaced, continuing from its current color.
+  @param    segment             Segment
+  @param    led                 LED index in the segment
+  @param    from                Start color
+  @param    to                  End color
+  @param    startTime           Start of the fade in ms, the LED holds the
+                                start color until then
+  @param    duration            Duration of the fade in ms, 0 switches at the
+                                start time
+*/
+/******************************************************************************/
+void Ledstrip::_startPixelFade(Segment &segment, uint16_t led, CRGB from, CRGB to, uint32_t startTime, uint16_t duration) {
+    SegmentState &state = segment.state;
+    PixelFade* fades = (PixelFade *) (segment.scratch + _getPixelFadesOffset(segment));
+    uint8_t i = 0;
+
+    while (i < state.numberOfActiveElements && fades[i].led != led) {
+        i++;
+    }
+
+    if (i == state.numberOfActiveElements) {
+        if (state.numberOfActiveElements == state.numberOfElements) {
+            return;                                                             //Pool is full
         }
+        state.numberOfActiveElements++;
     }
 
-    while (1) {
-        /* Reset leds */
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            _leds[i] = _modeParameters[MODE_BOUNCING_BALLS].color2;
+    fades[i].led = led;
+    fades[i].from = from;
+    fades[i].to = to;
+    fades[i].startTime = startTime;
+    fades[i].duration = duration;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Renders every pixel fade of the pool at the specified time, in
+            one pass. Finished fades are written with their end color and
+            removed.
+  @param    segment             Segment
+  @param    time                Time of the step, in ms
+  @returns  bool                True if fades are still running
+*/
+/******************************************************************************/
+bool Ledstrip::_renderPixelFades(Segment &segment, uint32_t time) {
+    SegmentState &state = segment.state;
+    PixelFade* fades = (PixelFade *) (segment.scratch + _getPixelFadesOffset(segment));
+    CRGB* leds = segment.leds;
+    uint8_t i = 0;
+
+    while (i < state.numberOfActiveElements) {
+        PixelFade &fade = fades[i];
+        int32_t elapsed = time - fade.startTime;
+
+        if (elapsed < 0) {
+            leds[fade.led] = fade.from;                                         //Not started yet
+            i++;
+            continue;
         }
 
-        for (uint8_t i = 0; i < numberOfBalls; i++) {
-            timeSinceLastBounce[i] =  millis() - clockTimeSinceLastBounce[i];
-            height[i] = 0.5 * GRAVITY * pow(timeSinceLastBounce[i]/1000 , 2.0) + impactVelocity[i] * timeSinceLastBounce[i]/1000;
-        
-            if (height[i] < 0) {                      
-                height[i] = 0;
-                impactVelocity[i] = dampening[i] * impactVelocity[i];
-                clockTimeSinceLastBounce[i] = millis();
-        
-                if (impactVelocity[i] < 0.01) {
-                    impactVelocity[i] = IMPACT_VELOCITY_START;
-                }
-            }
-            position[i] = round( height[i] * (_highestPixelAddress - 1) / START_HEIGHT);
+        uint16_t progress = _getFadeProgress(elapsed, fade.duration);
+
+        if (progress == FADE_PROGRESS_END) {
+            leds[fade.led] = fade.to;
+            state.numberOfActiveElements--;
+            fade = fades[state.numberOfActiveElements];                         //Last fade takes its place
+            continue;
         }
-     
-        /* Draw balls */
-        for (uint8_t i = 0 ; i < numberOfBalls ; i++) {
-            for (uint8_t ballPixel = 0; ballPixel < ballSize; ballPixel++) {
-                _leds[position[i] + ballPixel] = ballColors[i];
-            }
+
+        leds[fade.led] = _blendColors(fade.from, fade.to, progress);             //Below FADE_PROGRESS_END, so it fits the alpha
+        i++;
+    }
+
+    return state.numberOfActiveElements > 0;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns the time until the next step of a mode with pixel fades.
+            Running fades are rendered at the default frame rate, otherwise
+            the mode waits until the next LED starts. A start that is due
+            while the pool is full waits for the next frame.
+  @param    segment             Segment
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
+*/
+/******************************************************************************/
+uint16_t Ledstrip::_getPixelFadesPeriod(Segment &segment, uint32_t time) {
+    SegmentState &state = segment.state;
+    int32_t untilNextElement = max((int32_t) (state.nextElementTime - time), (int32_t) 0);
+
+    if (state.numberOfActiveElements > 0 && (untilNextElement == 0 || untilNextElement > 1000 / DEFAULT_FRAME_RATE)) {
+        return 1000 / DEFAULT_FRAME_RATE;
+    }
+    return untilNextElement;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Two colors dissolving in each other. The LEDs start fading in a
+            random order, as many at the same time as the number of
+            elements. A round ends when every LED faded, the next round
+            fades back.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
+*/
+/******************************************************************************/
+uint16_t Ledstrip::_renderDissolve(Segment &segment, uint32_t time) {
+    CRGB* leds = segment.leds;
+    ModeParameters &parameters = segment.parameters;
+    SegmentState &state = segment.state;
+    uint16_t* indexes = (uint16_t *) segment.scratch;
+    uint16_t interval = (parameters.timeFade + parameters.delay) / state.numberOfElements;
+
+    /* Start the next LEDs, while the pool has room */
+    while (state.index < segment.length && state.numberOfActiveElements < state.numberOfElements && (int32_t) (time - state.nextElementTime) >= 0) {
+        if (state.index == 0) {
+            _shuffleIndexes(indexes, segment.length, state.random);             //New order every round
         }
-       
-        _showLeds();
-        vTaskDelay(10);
+
+        uint16_t led = indexes[state.index];
+        CRGB color = state.toggle ? parameters.color2 : parameters.color1;
+
+        _startPixelFade(segment, led, leds[led], color, time, parameters.timeFade);
+        state.index++;
+        state.nextElementTime = time + interval;
+    }
+
+    bool isFading = _renderPixelFades(segment, time);
+
+    /* The round ends when its last LED finished */
+    if (state.index >= segment.length && !isFading) {
+        state.index = 0;
+        state.toggle = !state.toggle;
+        state.nextElementTime = time + parameters.delayBetween;
+    }
+
+    return _getPixelFadesPeriod(segment, time);
+}
+
+/******************************************************************************/
+/*!
+  @brief    LEDs sparkle in a random order and fade away, as many at the same
+            time as the number of elements. Without fade time, a sparkle
+            holds for the delay between sparkles.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
+*/
+/******************************************************************************/
+uint16_t Ledstrip::_renderSparkle(Segment &segment, uint32_t time) {
+    ModeParameters &parameters = segment.parameters;
+    SegmentState &state = segment.state;
+    uint16_t* indexes = (uint16_t *) segment.scratch;
+    uint16_t interval = (parameters.timeFade + parameters.delayBetween) / state.numberOfElements;
+    uint16_t hold = parameters.timeFade == 0 ? parameters.delayBetween : 0;
+
+    /* Start the next sparkles, while the pool has room */
+    while (state.numberOfActiveElements < state.numberOfElements && (int32_t) (time - state.nextElementTime) >= 0) {
+        if (state.index == 0) {
+            _shuffleIndexes(indexes, segment.length, state.random);             //New order every round
+        }
+
+        _startPixelFade(segment, indexes[state.index], parameters.color1, parameters.color2, time + hold, parameters.timeFade);
+        state.nextElementTime = time + interval;
+        state.index++;
+
+        if (state.index >= segment.length) {
+            state.index = 0;
+        }
+    }
+
+    _renderPixelFades(segment, time);
+
+    return _getPixelFadesPeriod(segment, time);
+}
+
+/******************************************************************************/
+/*!
+  @brief    Random color blobs light up, then fade away. TODO IMPLEMENT
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
+*/
+/******************************************************************************/
+uint16_t Ledstrip::_renderFireworks(Segment &segment, uint32_t time) {
+    return 1000;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Cools down every LED of the fire. A random palette picks one
+            of the heat palettes.
+  @param    segment             Segment to prepare
+  @param    time                Time the mode starts, in ms
+*/
+/******************************************************************************/
+void Ledstrip::_beginFire(Segment &segment, uint32_t time) {
+    memset(segment.scratch, 0, segment.length);                                 //Heat
+
+    if (segment.parameters.palette == PALETTE_RANDOM) {
+        segment.parameters.palette = segment.state.random.next(PALETTE_YELLOW_RED, PALETTE_YELLOW_RED + NUMBER_OF_HEAT_PALETTES);
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Fire simulation.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
+*/
+/******************************************************************************/
+uint16_t Ledstrip::_renderFire(Segment &segment, uint32_t time) {
+    const uint8_t COOLING = 120;
+    const uint8_t SPARKING = 100;
+
+    CRGB* leds = segment.leds;
+    uint8_t* heat = segment.scratch;
+    uint8_t* noise = segment.scratch + segment.length;                          //Random byte per cell
+    uint16_t length = segment.length;
+    Random &random = segment.state.random;
+    const ColorTable* heatTable = _getHeatTable(segment.parameters.palette);
+    uint16_t maxCooldown = (((COOLING-segment.parameters.segmentSize) * 10) / length) + 2;
+    int cooldown;
+
+    /* Cool down every cell a little */
+    random.randomBytes(noise, length);
+
+    for(uint16_t i = 0; i < length; i++) {
+        cooldown = (noise[i] * maxCooldown) >> 8;                               //0 up to maxCooldown (exclusive)
+
+        if (cooldown > heat[i]) {
+            heat[i] = 0;
+        } else {
+            heat[i] = heat[i] - cooldown;
+        }
+    }
+
+    /* Heat from each cell drifts 'up' and diffuses a little */
+    for(uint16_t k = length - 1; k >= 2; k--) {
+        heat[k] = (heat[k - 1] + heat[k - 2] + heat[k - 2]) / 3;
+    }
+
+    /* Randomly ignite new 'sparks' near the bottom */
+    if(random.next(255) < SPARKING) {
+        uint16_t y = random.next(length/10);
+        heat[y] = heat[y] + random.next(160,255);
+    }
+
+    /* Convert heat to LED colors */
+    for(uint16_t j = 0; j < length; j++) {
+        leds[j] = CRGB(heatTable->red[heat[j]], heatTable->green[heat[j]], heatTable->blue[heat[j]]);
     }
+
+    return 20;                                                                  //50 FPS
 }
 
 /******************************************************************************/
 /*!
-  @brief    Two colors dissolving in each other.
+  @brief    A sweep between two colors. Every step moves the sweep one LED,
+            every sweep swaps the old and new color. Gradients move one
+            position per sweep, bouncing between both ends of the color wheel.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
 */
 /******************************************************************************/
-void Ledstrip::dissolve() {
-    _fullColor = _modeParameters[MODE_DISSOLVE].color2;
-    
-    _fadeToColor();
+uint16_t Ledstrip::_renderSweep(Segment &segment, uint32_t time) {
+    CRGB* leds = segment.leds;
+    ModeParameters &parameters = segment.parameters;
+    uint8_t fadeLength = parameters.fadeLength;
+    uint16_t animationLength = segment.length + fadeLength;
+    uint16_t delay = max(parameters.delay, (uint16_t) 1);
+    uint32_t sweepTime = (uint32_t) animationLength * delay + parameters.delayBetween;
+    uint32_t elapsed = time - segment.state.startTime;
+    uint32_t sweep = elapsed / sweepTime;
+    uint32_t sweepElapsed = elapsed % sweepTime;
+    uint16_t index = min(sweepElapsed / delay, (uint32_t) animationLength - 1);  //Last step holds during the delay between sweeps
+    uint8_t colorPosition = _getBouncePosition(sweep, 0, 255);                  //Gradient 2 moves the other way, from 255
+    bool toggle = sweep % 2 == 1;
 
-    _waitUntilIdle();
-     
-    _mode = MODE_DISSOLVE;
-    _state = _LOOPING;
-    
-    _l.logi("Start dissolve mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    /* LEDs up to index - fadeLength have the new color, the fade covers the LEDs up to index */
+    for (uint16_t i = 0; i < segment.length; i++) {
+        uint16_t gradientPosition = (i + fadeLength) * 3;
+        CRGB color1 = parameters.useGradient1 ? _colorWheel((gradientPosition + colorPosition) & 255) : parameters.color1;
+        CRGB color2 = parameters.useGradient2 ? _colorWheel((gradientPosition + 255 - colorPosition) & 255) : parameters.color2;
+        CRGB oldColor = toggle ? color2 : color1;
+        CRGB newColor = toggle ? color1 : color2;
+
+        if (i + fadeLength <= index) {
+            leds[i] = newColor;
+        } else if (i < index) {
+            leds[i] = _blendColors(oldColor, newColor, (index - i) * 255 / fadeLength);
+        } else {
+            leds[i] = oldColor;
+        }
+    }
+
+    uint32_t nextStepTime = index + 1 < animationLength ? (uint32_t) (index + 1) * delay : sweepTime;
+    return min(nextStepTime - sweepElapsed, (uint32_t) FRAME_IDLE - 1);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. Two colors dissolving in each other.
+  @brief    Starts the twinkels with the cloud palette.
+  @param    segment             Segment to prepare
+  @param    time                Time the mode starts, in ms
 */
 /******************************************************************************/
-void Ledstrip::__dissolve() {
-    bool colorToggle = false;
-    uint16_t randomIndex = 0;
-    uint16_t temp = 0;
-    uint16_t indexes[_highestPixelAddress];
-    
-    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        indexes[i] = i;
-    }
-        
-    while (1) {
-        /* Shuffle order on randomized index */
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            randomIndex = random(i, _highestPixelAddress);                      //Generate a random index between i and n, index < i is already randomized
-            
-            /* Swap elements */
-            temp = indexes[i];
-            indexes[i] = indexes[randomIndex];
-            indexes[randomIndex] = temp;
-        }
+void Ledstrip::_beginColorTwinkels(Segment &segment, uint32_t time) {
+    segment.state.currentPalette = CloudColors_p;
+    segment.state.targetPalette = CloudColors_p;
+    segment.parameters.palette = PALETTE_RANDOM;
+    segment.state.lastBlendTime = time;
+}
 
-        /* Draw randomized leds */
-        float color1Portion = 0;
-        CRGB dotColor;
-        
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            if (_modeParameters[MODE_DISSOLVE].timeFade == 0) {
-                if (colorToggle) {
-                    _leds[indexes[i]] = _modeParameters[MODE_DISSOLVE].color1;
-                } else {                  
-                    _leds[indexes[i]] = _modeParameters[MODE_DISSOLVE].color2;
-                }
-                _showLeds();
-                vTaskDelay(_modeParameters[MODE_DISSOLVE].delay);
-                continue;
-            }
+/******************************************************************************/
+/*!
+  @brief    Random color blobs light up, then fade away. TODO test
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
+*/
+/******************************************************************************/
+uint16_t Ledstrip::_renderColorTwinkels(Segment &segment, uint32_t time) {
+    CRGB* leds = segment.leds;
+    ModeParameters &parameters = segment.parameters;
+    SegmentState &state = segment.state;
+    uint8_t fadeIntensity = MAX_FADE_TIME+1 - parameters.timeFade;              //Lower = slower fade rate.
+    uint16_t delayBetween = max(parameters.delayBetween, (uint16_t) 1);
+    uint8_t secondHand = (time % (delayBetween * 4) / 1000);
 
-            for (uint16_t timeStep = 0; timeStep < 100; timeStep++) {
-                if (colorToggle) {
-                    color1Portion = (100-timeStep-1) * 1.0 / 100;
-                } else {                  
-                    color1Portion = timeStep * 1.0 / 100;
-                }
-                
-                color1Portion = color1Portion / 2;
-  
-                dotColor = _blendColors(_modeParameters[MODE_DISSOLVE].color1, color1Portion, _modeParameters[MODE_DISSOLVE].color2);
-  
-                _leds[indexes[i]] = dotColor;
-  
-                _showLeds();
-                vTaskDelay(_modeParameters[MODE_DISSOLVE].timeFade/100);
+    if (parameters.palette == PALETTE_RANDOM) {
+        if (state.lastSecond != secondHand) {                                   //Debounce to make sure we're not repeating an assignment.
+            state.lastSecond = secondHand;
+            if (secondHand == delayBetween) {
+                state.targetPalette = CloudColors_p;
+                state.hue = 192;
+                state.hueRange = 256;
+            } else if (secondHand == delayBetween * 2) {
+                state.targetPalette = LavaColors_p;
+                state.hue = 128;
+                state.hueRange = 64;
+            } else if (secondHand == delayBetween * 3) {
+                state.targetPalette = OceanColors_p;
+                state.hue = 128;
+                state.hueRange = 64;
+            } else if (secondHand == delayBetween * 4) {
+                state.targetPalette = ForestColors_p;
+                state.hue = state.random.next(255);
+                state.hueRange = 16;
             }
-            vTaskDelay(_modeParameters[MODE_DISSOLVE].delay);
         }
 
-        vTaskDelay(_modeParameters[MODE_DISSOLVE].delayBetween);
-        colorToggle = !colorToggle;
+        if (time - state.lastBlendTime >= 100) {
+            state.lastBlendTime = time;
+            nblendPaletteTowardPalette(state.currentPalette, state.targetPalette);
+        }
     }
+
+    fadeToBlackBy(leds, segment.length, fadeIntensity);
+    uint16_t position = state.random.next(segment.length);                      //Pick an LED at random.
+    leds[position] = ColorFromPalette(state.currentPalette, state.hue + state.random.next(state.hueRange)/4);
+    state.hue++;
+
+    return 10;                                                                  //100 FPS
 }
 
 /******************************************************************************/
 /*!
-  @brief    One LED at a time sparkles and fades away.
+  @brief    Meteor rain simulation.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
 */
 /******************************************************************************/
-void Ledstrip::sparkle() {
-    _fullColor = _modeParameters[MODE_SPARKLE].color2;
-    
-    _fadeToColor();
+uint16_t Ledstrip::_renderMeteorRain(Segment &segment, uint32_t time) {
+    CRGB* leds = segment.leds;
+    ModeParameters &parameters = segment.parameters;
+    uint8_t meteorSize = parameters.segmentSize;
+    uint8_t meteorTrailDecay = parameters.tailLength;
+    int32_t i = segment.state.index;
 
-    _waitUntilIdle();
-     
-    _mode = MODE_SPARKLE;
-    _state = _LOOPING;
-    
-    _l.logi("Start sparkle mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    /* Fade brightness of a random 40% of the LEDs one step, 32 LEDs per random mask */
+    uint32_t mask = 0;
+    for (uint16_t j = 0; j < segment.length; j++) {
+        if ((j & 31) == 0) {
+            mask = segment.state.random.bernoulliMask(102);                     //102/256 = 4 in 10
+        }
+        if (mask & 1) {
+            leds[j].fadeToBlackBy(meteorTrailDecay);
+        }
+        mask >>= 1;
+    }
+
+    /* Draw meteor */
+    for (uint8_t j = 0; j < meteorSize; j++) {
+        if ((i - j < segment.length) && (i - j >= 0)) {
+            leds[i-j] = parameters.color1;
+        }
+    }
+
+    segment.state.index++;
+    if (segment.state.index >= segment.length + meteorTrailDecay) {
+        segment.state.index = 0;
+    }
+    //TODO implement delayBetween and randomnessDelay
+
+    return parameters.delay;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. One LED at a time sparkles and fades away.
+  @brief    Waves of different colors. The palette blends into a random one
+            every PALETTE_CHANGE_TIME, starting from the rainbow palette.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
 */
 /******************************************************************************/
-void Ledstrip::__sparkle() {
-    uint8_t colorToggle = 0;
-    uint16_t randomIndex = 0;
-    uint16_t temp = 0;
-    uint16_t indexes[_highestPixelAddress];
-    
-    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        indexes[i] = i;
-    }
-    
-    while (1) {    
-        /* Shuffle order on randomized index */
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            randomIndex = random(i, _highestPixelAddress);                      //Generate a random index between i and n, index < i is already randomized
-            
-            /* Swap elements */
-            temp = indexes[i];
-            indexes[i] = indexes[randomIndex];
-            indexes[randomIndex] = temp;
-        }
-
-        /* Draw randomized leds */
-        float color1Portion = 0;
-        CRGB dotColor;
-        
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            _leds[indexes[i]] = _modeParameters[MODE_SPARKLE].color1;
+uint16_t Ledstrip::_renderColorWaves(Segment &segment, uint32_t time) {
+    CRGB* leds = segment.leds;
+    uint32_t elapsed = time - segment.state.startTime;
+    uint32_t paletteNumber = elapsed / PALETTE_CHANGE_TIME;
+    CRGBPalette16 palette = _getColorWavesPalette(segment, paletteNumber);
+    uint8_t wave1 = _beatSin8(4, time);
+    uint8_t wave2 = _beatSin8(3, time);
+    uint8_t wave3 = _beatSin8(2, time);
+    uint8_t wave4 = _beatSin8(1, time);
 
-            if (_modeParameters[MODE_SPARKLE].timeFade == 0) {
-                _showLeds();
-                vTaskDelay(_modeParameters[MODE_SPARKLE].delayBetween);
-                _leds[indexes[i]] = _modeParameters[MODE_SPARKLE].color2;
-                continue;
-            }
+    if (paletteNumber > 0) {
+        CRGBPalette16 previousPalette = _getColorWavesPalette(segment, paletteNumber - 1);
+        uint8_t progress = (elapsed % PALETTE_CHANGE_TIME) * 255 / PALETTE_CHANGE_TIME;
 
-            for (uint16_t timeStep = 0; timeStep < 100; timeStep++) {
-                color1Portion = (100-timeStep-1) * 1.0 / 100;
-                color1Portion = color1Portion / 2;
-  
-                dotColor = _blendColors(_modeParameters[MODE_SPARKLE].color1, color1Portion, _modeParameters[MODE_SPARKLE].color2);
-  
-                _leds[indexes[i]] = dotColor;
-  
-                _showLeds();
-                vTaskDelay(_modeParameters[MODE_SPARKLE].timeFade/100);
-            }
-            vTaskDelay(_modeParameters[MODE_SPARKLE].delayBetween);
+        for (uint8_t i = 0; i < 16; i++) {
+            palette[i] = blend(previousPalette[i], palette[i], progress);
         }
     }
+
+    for (uint16_t i = 0; i < segment.length; i++) {
+        leds[i] = ColorFromPalette(palette, i+wave1+wave2+wave3+wave4);
+    }
+
+    return 1000 / DEFAULT_FRAME_RATE;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Fireworks simulation.
+  @brief    MODE TEMPLATE TO BE IMPLEMENTED. Used by MODE_TEMPLATE_1 to
+            MODE_TEMPLATE_10.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
 */
 /******************************************************************************/
-void Ledstrip::fireworks() {
-    _fullColor = CRGB(0, 0, 0);
-    _fadeToColor();                                                             //Black background
-
-    _waitUntilIdle();
-     
-    _mode = MODE_FIREWORKS;
-    _state = _LOOPING;
-    
-    _l.logi("Start fireworks mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+uint16_t Ledstrip::_renderModeTemplate(Segment &segment, uint32_t time) {
+    return segment.parameters.delay;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. Random color blobs light up, then fade away. TODO IMPLEMENT
+  @brief    Color and drawing mode, the LEDs do not change after the entry
+            fade.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            FRAME_IDLE
 */
 /******************************************************************************/
-void Ledstrip::__fireworks() {
-    while (1) {
-        vTaskDelay(1000);
-        _showLeds();
-    }
+uint16_t Ledstrip::_renderStatic(Segment &segment, uint32_t time) {
+    return FRAME_IDLE;
 }
+#pragma endregion
+
 
+#pragma region System modes
 /******************************************************************************/
 /*!
-  @brief    Fire simulation.
+  @brief    Places the pulse before the start of the segment.
+  @param    segment             Segment to prepare
+  @param    time                Time the mode starts, in ms
 */
 /******************************************************************************/
-void Ledstrip::fire() {
-    _fullColor = CRGB(0, 0, 0);
-    _fadeToColor();                                                             //Black background
-
-    _waitUntilIdle();
-     
-    _mode = MODE_FIRE;
-    _state = _LOOPING;
-    
-    _l.logi("Start fire mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+void Ledstrip::_beginSystemPulses(Segment &segment, uint32_t time) {
+    segment.state.position = 20;                                                //Padding
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. Fire simulation.
+  @brief    White pulse moving between the ends of the segment.
+  @param    segment             Segment to render
+  @param    time                Time of the step, in ms
+  @returns  uint16_t            Time until the next step in ms
 */
 /******************************************************************************/
-void Ledstrip::__fire() {
-    const uint8_t COOLING = 120;
-    const uint8_t SPARKING = 100;
+uint16_t Ledstrip::_renderSystemPulses(Segment &segment, uint32_t time) {
+    CRGB* leds = segment.leds;
+    SegmentState &state = segment.state;
+    uint16_t padding = 20;
+    int32_t location = state.position - padding;
 
-    uint8_t heat[_highestPixelAddress];
-    int cooldown;
+    /* Draw background */
+    for (uint16_t i = 0; i < segment.length; i++) {
+        leds[i] = CRGB(0,0,0);
+    }
 
-    while (1) {
-        /* Cool down every cell a little */
-        for(uint16_t i = 0; i < _highestPixelAddress; i++) {
-            cooldown = random(0, (((COOLING-_modeParameters[MODE_FIRE].segmentSize) * 10) / _highestPixelAddress) + 2);
-            
-            if (cooldown > heat[i]) {
-                heat[i] = 0;
-            } else {
-                heat[i] = heat[i] - cooldown;
-            }
-        }
-       
-        /* Heat from each cell drifts 'up' and diffuses a little */
-        for(uint16_t k = _highestPixelAddress - 1; k >= 2; k--) {
-            heat[k] = (heat[k - 1] + heat[k - 2] + heat[k - 2]) / 3;
+    /* Draw tail */
+    CRGB tailColor;
+    CRGB color1 = CRGB (255,255,255);
+    CRGB color2 = CRGB (0,0,0);
+
+    for (uint8_t i = 0; i < padding; i++) {
+        uint8_t alpha = (padding - i) * 128 / padding;                          //Tail starts at half color 1
+
+        tailColor = _blendColors(color2, color1, alpha);
+
+        if (location - i >= 0 && location - i < segment.length) {
+            leds[location - i] = tailColor;
         }
-         
-        /* Randomly ignite new 'sparks' near the bottom */
-        if(random(255) < SPARKING) {
-            uint16_t y = random(_highestPixelAddress/10);
-            heat[y] = heat[y] + random(160,255);
+        if (location + i >= 0 && location + i < segment.length) {
+            leds[location + i] = tailColor;
         }
-      
-        /* Convert heat to LED colors */
-        for(uint16_t j = 0; j < _highestPixelAddress; j++) {
-            _leds[j] = _getHeatColor(heat[j], _modeParameters[MODE_FIRE].palette);
+    }
+
+    /* No need to wait if no scanline has been drawn */
+    bool isDrawn = false;
+    for (uint16_t i = 0; i < segment.length; i++) {
+        if (leds[i] != color2) {
+            isDrawn = true;
+            break;
         }
-      
-        _showLeds();
-        vTaskDelay(20);//_modeParameters[MODE_FIRE].delay); todo
     }
+
+    /* Change directions */
+    if (state.position >= segment.length + padding*2) {
+        state.direction = -1;
+    } else if (state.position == 0) {
+        state.direction = 1;
+    }
+    state.position += state.direction;
+
+    return isDrawn ? 50 : 1;
 }
+#pragma endregion
 
-/******************************************************************************/
-/*!
-  @brief    A sweep between two colors.
-*/
-/******************************************************************************/
-void Ledstrip::sweep() {
-    if (_modeParameters[MODE_SWEEP].useGradient1) {
-        _fadeToMultipleColors(0);
-    } else {
-        _fullColor = _modeParameters[MODE_SWEEP].color1;
-        _fadeToColor();        
+#pragma region Layers
+/******************************************************************************/
+/*!
+  @brief    Renders the next step of an animated layer.
+  @param    layer               Layer index
+  @returns  uint16_t            Time until the next step in ms, FRAME_IDLE if
+                                the animation ended
+*/
+/******************************************************************************/
+uint16_t Ledstrip::_renderLayer(uint8_t layer) {
+    switch (layer) {
+        case LAYER_ALARM:
+            return _renderAlarm();
+        case LAYER_POWER:
+            switch (_powerAnimation) {
+                case _POWER_FADE:
+                    return _renderPowerFade();
+                case _POWER_DISSOLVE:
+                    return _renderPowerDissolve();
+                case _POWER_SWEEP:
+                    return _renderPowerSweep();
+                case _POWER_DUAL_SWEEP:
+                case _POWER_MULTI_SWEEP:
+                    return _renderPowerDualSweep();
+                default:
+                    memset(_powerMask, _isOn ? 255 : 0, _highestPixelAddress);  //No animation, switch at once
+                    return FRAME_IDLE;
+            }
+        default:
+            return FRAME_IDLE;                                                  //Static layer, like the door light
     }
-    _waitUntilIdle();
-     
-    _mode = MODE_SWEEP;
-    _state = _LOOPING;
-    
-    _l.logi("Start sweep mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. A sweep between two colors.
+  @brief    Alarm layer. Flashes four times, then waits. If the alarm is on
+            for long, it flashes continuously.
+  @returns  uint16_t            Time until the next step in ms
 */
 /******************************************************************************/
-void Ledstrip::__sweep() {
-    float color1Portion = 0;
-    uint16_t animationLength = _highestPixelAddress + _modeParameters[MODE_SWEEP].fadeLength;
-    CRGB color1 = _modeParameters[MODE_SWEEP].color1;
-    CRGB color2 = _modeParameters[MODE_SWEEP].color2;
-    CRGB leds1[animationLength];
-    CRGB leds2[animationLength];
-    uint8_t colorPosition1 = 0;
-    uint8_t colorPosition2 = 255;
-    int8_t colorDirection1 = 1;
-    int8_t colorDirection2 = -1;
-    bool color1Main = false;
+uint16_t Ledstrip::_renderAlarm() {
+    Layer &layer = _layers[LAYER_ALARM];
+    bool isFlash = layer.step % 2 == 0;
 
-    while (1) {
-        if (_modeParameters[MODE_SWEEP].useGradient1) {
-            for (uint16_t i = 0; i < animationLength; i++) {
-                leds1[i] = _colorWheel((i*3 + colorPosition1) & 255);
-            }
-        } else {
-            for (uint16_t i = 0; i < animationLength; i++) {
-                leds1[i] = _modeParameters[MODE_SWEEP].color1;
-            }
-        }
-        if (_modeParameters[MODE_SWEEP].useGradient2) {
-            for (uint16_t i = 0; i < animationLength; i++) {
-                leds2[i] = _colorWheel((i*3 + colorPosition2) & 255);
-            }
-        } else {
-            for (uint16_t i = 0; i < animationLength; i++) {
-                leds2[i] = _modeParameters[MODE_SWEEP].color2;
-            }
-        }
+    layer.color = isFlash ? CRGB(255, 255, 255) : CRGB(0, 0, 0);
 
-        /* Animate */
-        for (uint16_t i = 0; i < animationLength; i++) {
-            for (uint8_t j = 0; j < _modeParameters[MODE_SWEEP].fadeLength; j++) {
-                color1Portion = (_modeParameters[MODE_SWEEP].fadeLength-j) * 1.0 / _modeParameters[MODE_SWEEP].fadeLength;
-                
-                int16_t ledIndex = i + j - _modeParameters[MODE_SWEEP].fadeLength;
-                if (ledIndex < 0 || ledIndex > _highestPixelAddress) {
-                    continue;
-                }
+    uint16_t period = isFlash ? 25 : 150;
+    layer.step++;
 
-                if (color1Main) {
-                    _leds[ledIndex] = _blendColors(leds1[i + j], color1Portion, leds2[i + j]);
-                } else {
-                    _leds[ledIndex] = _blendColors(leds2[i + j], color1Portion, leds1[i + j]);
-                }
-            }
-            _showLeds();
-            vTaskDelay(_modeParameters[MODE_SWEEP].delay);
-        }
+    if (layer.step == 8) {
+        layer.step = 0;
 
-        if (_modeParameters[MODE_SWEEP].useGradient1) {
-            colorPosition1 += colorDirection1;
-            if (colorPosition1 == 255 || colorPosition1 == 0) {
-                colorDirection1 = -colorDirection1;
-            }
-        }
-        if (_modeParameters[MODE_SWEEP].useGradient2) {
-            colorPosition2 += colorDirection2;
-            if (colorPosition2 == 255 || colorPosition2 == 0) {
-                colorDirection2 = -colorDirection2;
-            }
+        if (layer.cycle < 50) {
+            period += 750;
+            layer.cycle++;
         }
-
-        color1Main = !color1Main;
-        vTaskDelay(_modeParameters[MODE_SWEEP].delayBetween);
     }
+
+    return period;
 }
+#pragma endregion
 
+#pragma region Power functionality
 /******************************************************************************/
 /*!
-  @brief    Random color blobs light up, then fade away.
+  @brief    Starts the power animation. The power layer masks the segments,
+            the animation is rendered by the render task.
+  @param    state               Power state, true = on, false = off
 */
 /******************************************************************************/
-void Ledstrip::colorTwinkels() {
-    _fullColor = CRGB(0, 0, 0);
-    _fadeToColor();                                                             //Black background
+void Ledstrip::_startPowerAnimation(bool state) {
+    Layer &layer = _layers[LAYER_POWER];
 
-    _waitUntilIdle();
-     
-    _mode = MODE_COLOR_TWINKELS;
-    _state = _LOOPING;
-    
-    _l.logi("Start color twinkel mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    _isOn = state;
+
+    /* A running animation is cancelled, the next one continues from its mask */
+    if (!layer.isAnimated) {
+        memset(_powerMask, _isOn ? 0 : 255, _highestPixelAddress);
+    }
+
+    layer.isEnabled = true;
+    layer.isAnimated = true;
+    layer.step = 0;
+    layer.nextFrameTime = xTaskGetTickCount();
+    layer.startTime = pdTICKS_TO_MS(layer.nextFrameTime);
+
+    _l.logd("Start power animation " + String(_powerAnimation));
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. Random color blobs light up, then fade away. TODO test
+  @brief    Moves the power mask of the LED towards the power state. The mask
+            only moves in the direction of the power state, so an animation
+            that cancelled another one does not make LEDs jump back.
+  @param    index               LED index
+  @param    alpha               Progress of the LED, 0 = not started, 255 =
+                                done
 */
 /******************************************************************************/
-void Ledstrip::__colorTwinkels() {
-    uint8_t fadeIntensity = MAX_FADE_TIME+1 - _modeParameters[MODE_COLOR_TWINKELS].timeFade;    //Lower = slower fade rate.
-    int16_t hue = 50;                                                           //Starting hue.
-    uint16_t hueRange = 256;                                                    //Range of random #'s to use for hue
-    uint8_t secondHand;
-    uint8_t lastSecond = 99;                                                    // Static variable, means it's only defined once. This is our 'debounce' variable.
-
-    CRGBPalette16 currentPalette = CloudColors_p;
-    CRGBPalette16 targetPalette = CloudColors_p;
-    _modeParameters[MODE_COLOR_TWINKELS].palette = PALETTE_RANDOM;
-    if (_modeParameters[MODE_COLOR_TWINKELS].palette != PALETTE_RANDOM) {
-        switch (_modeParameters[MODE_COLOR_TWINKELS].palette) {
-            case PALETTE_CLOUD_COLORS:
-                currentPalette = CloudColors_p;
-                break;
-            case PALETTE_LAVA_COLORS:
-                currentPalette = LavaColors_p;
-                break;
-            case PALETTE_OCEAN_COLORS:
-                currentPalette = OceanColors_p;
-                break;
-            case PALETTE_FOREST_COLORS:
-                currentPalette = ForestColors_p;
-                break;
-        
-        default:
-            break;
-        }
-    }
-
-    while (1) {
-        secondHand = (millis() % (_modeParameters[MODE_COLOR_TWINKELS].delayBetween * 4) / 1000);
-        
-        if (_modeParameters[MODE_COLOR_TWINKELS].palette == PALETTE_RANDOM) {
-            if (lastSecond != secondHand) {                                     //Debounce to make sure we're not repeating an assignment.
-                lastSecond = secondHand;
-                _l.logd(String(lastSecond));
-                if (secondHand == _modeParameters[MODE_COLOR_TWINKELS].delayBetween) {
-                    targetPalette = CloudColors_p;
-                    hue = 192;
-                    hueRange = 256;
-                } else if (secondHand == _modeParameters[MODE_COLOR_TWINKELS].delayBetween * 2) {
-                    targetPalette = LavaColors_p;
-                    hue = 128;
-                    hueRange = 64;
-                } else if (secondHand == _modeParameters[MODE_COLOR_TWINKELS].delayBetween * 3) {
-                    targetPalette = OceanColors_p;
-                    hue = 128;
-                    hueRange = 64;
-                } else if (secondHand == _modeParameters[MODE_COLOR_TWINKELS].delayBetween * 4) {
-                    targetPalette = ForestColors_p;
-                    hue = random16(255);
-                    hueRange = 16;
-                }
-            }
-
-            EVERY_N_MILLISECONDS(100) {
-                nblendPaletteTowardPalette(currentPalette, targetPalette);
-            }
-        }
-
-        fadeToBlackBy(_leds, _highestPixelAddress, fadeIntensity);
-        uint16_t position = random16(_highestPixelAddress);                     //Pick an LED at random.
-        _leds[position] = ColorFromPalette(currentPalette, hue + random16(hueRange)/4);
-        hue++;
-
-        _showLeds();
-        vTaskDelay(1);//_modeParameters[MODE_COLOR_TWINKELS].delay);
+void Ledstrip::_stepPowerMask(uint16_t index, uint8_t alpha) {
+    if (_isOn) {
+        _powerMask[index] = max(_powerMask[index], alpha);
+    } else {
+        _powerMask[index] = min(_powerMask[index], (uint8_t) (255 - alpha));
     }
 }
 
 /******************************************************************************/
 /*!
-  @brief    Meteor rain simulation.
+  @brief    Fade power animation, a linear ramp over POWER_FADE_TIME. The
+            duration does not depend on how many frames are rendered.
+  @returns  uint16_t            Time until the next step in ms, FRAME_IDLE if
+                                done
 */
 /******************************************************************************/
-void Ledstrip::meteorRain() {
-    _fullColor = CRGB(0, 0, 0);
-    _fadeToColor();                                                             //Black background
+uint16_t Ledstrip::_renderPowerFade() {
+    Layer &layer = _layers[LAYER_POWER];
+    uint16_t progress = _getFadeProgress(pdTICKS_TO_MS(xTaskGetTickCount()) - layer.startTime, POWER_FADE_TIME);
+    uint8_t alpha = min(progress, (uint16_t) 255);                              //Progress of 1.0 is fully on/off
 
-    _waitUntilIdle();
-     
-    _mode = MODE_METEOR_RAIN;
-    _state = _LOOPING;
-    
-    _l.logi("Start color meteor mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
+        _stepPowerMask(i, alpha);
+    }
+
+    return progress == FADE_PROGRESS_END ? FRAME_IDLE : 1000 / DEFAULT_FRAME_RATE;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. Meteor rain simulation.
+  @brief    Dissolve power animation. Fades groups of random LEDs one after
+            the other, POWER_DISSOLVE_GROUP_STEPS steps each. The steps are
+            spread over POWER_DISSOLVE_TIME, a frame runs every step that is
+            due, so the duration does not depend on the number of LEDs.
+  @returns  uint16_t            Time until the next step in ms, FRAME_IDLE if
+                                done
 */
 /******************************************************************************/
-void Ledstrip::__meteorRain() {
-    uint8_t meteorSize = _modeParameters[MODE_METEOR_RAIN].segmentSize;
-    uint8_t meteorTrailDecay = _modeParameters[MODE_METEOR_RAIN].tailLength;
+uint16_t Ledstrip::_renderPowerDissolve() {
+    Layer &layer = _layers[LAYER_POWER];
 
-    while (1) {
-        /* Reset leds */
-        //for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        //    _leds[i] = CRGB(0, 0, 0);
-        //}
- 
-        for (uint16_t i = 0; i < _highestPixelAddress + meteorTrailDecay; i++) {
-            // fade brightness all LEDs one step
-            for(int j = 0; j < _highestPixelAddress; j++) {
-                if (random(10) > 5) {
-                    _leds[j].fadeToBlackBy(meteorTrailDecay);
-                }
-            }
-            
-            // draw meteor
-            for (int j = 0; j < meteorSize; j++) {
-                if ((i - j < _highestPixelAddress) && (i - j >= 0)) {
-                    _leds[i-j] = _modeParameters[MODE_METEOR_RAIN].color1;
-                }
-            }
-            
-            _showLeds();
-            vTaskDelay(_modeParameters[MODE_METEOR_RAIN].delay);
+    if (layer.step == 0) {
+        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
+            _powerIndexes[i] = i;
+        }
+        _shuffleIndexes(_powerIndexes, _highestPixelAddress, _random);
+    }
+
+    uint32_t numberOfGroups = (_highestPixelAddress + POWER_DISSOLVE_GROUP_SIZE - 1) / POWER_DISSOLVE_GROUP_SIZE;
+    uint32_t numberOfSteps = numberOfGroups * POWER_DISSOLVE_GROUP_STEPS;
+    uint32_t elapsed = min(pdTICKS_TO_MS(xTaskGetTickCount()) - layer.startTime, (uint32_t) POWER_DISSOLVE_TIME);
+    uint32_t lastStep = min(elapsed * numberOfSteps / POWER_DISSOLVE_TIME, numberOfSteps - 1);
+
+    for (uint32_t step = layer.step; step <= lastStep; step++) {
+        uint32_t i = (step / POWER_DISSOLVE_GROUP_STEPS) * POWER_DISSOLVE_GROUP_SIZE; //First LED of the group
+        uint8_t alpha = (step % POWER_DISSOLVE_GROUP_STEPS) * 255 / (POWER_DISSOLVE_GROUP_STEPS - 1);
+
+        for (uint8_t j = 0; j < POWER_DISSOLVE_GROUP_SIZE && i + j < _highestPixelAddress; j++) {
+            _stepPowerMask(_powerIndexes[i + j], alpha);
         }
-        //vTaskDelay(_modeParameters[MODE_METEOR_RAIN].delayBetween);
-        //vTaskDelay(_modeParameters[MODE_METEOR_RAIN].randomnessDelay);todo implement randomness delauy
     }
+    layer.step = lastStep + 1;
+
+    return lastStep == numberOfSteps - 1 ? FRAME_IDLE : 1000 / DEFAULT_FRAME_RATE;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Waves of different colors.
+  @brief    Sweep power animation, one LED per step.
+  @returns  uint16_t            Time until the next step in ms, FRAME_IDLE if
+                                done
 */
 /******************************************************************************/
-void Ledstrip::colorWaves() {
-    _fullColor = CRGB(0, 0, 0);
-    _fadeToColor();                                                             //Black background
+uint16_t Ledstrip::_renderPowerSweep() {
+    Layer &layer = _layers[LAYER_POWER];
+    uint16_t i = layer.step;
 
-    _waitUntilIdle();
-     
-    _mode = MODE_COLOR_WAVES;
-    _state = _LOOPING;
-    
-    _l.logi("Start color waves mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    for (uint8_t j = 0; j < POWER_SWEEP_FADE_LENGTH; j++) {
+        uint8_t alpha = (POWER_SWEEP_FADE_LENGTH - j) * 255 / POWER_SWEEP_FADE_LENGTH;
+
+        if (i + j < _highestPixelAddress) {
+            _stepPowerMask(i + j, alpha);
+        }
+    }
+    layer.step++;
+
+    return layer.step >= _highestPixelAddress ? FRAME_IDLE : 50;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. Waves of different colors.
+  @brief    Dual sweep power animation, from both ends to the middle. Also
+            used for the multi sweep.
+  @returns  uint16_t            Time until the next step in ms, FRAME_IDLE if
+                                done
 */
 /******************************************************************************/
-void Ledstrip::__colorWaves() {
-    CRGBPalette16 currentPalette = RainbowColors_p;
-    CRGBPalette16 targetPalette;
-    //TODO implement palette
+uint16_t Ledstrip::_renderPowerDualSweep() {
+    Layer &layer = _layers[LAYER_POWER];
+    uint16_t i = layer.step;
+    uint16_t middle = _highestPixelAddress / 2;
 
-    while (1) {
-        uint8_t wave1 = beatsin8(4, 0, 255);                                    //That's the same as beatsin8(9);
-        uint8_t wave2 = beatsin8(3, 0, 255);
-        uint8_t wave3 = beatsin8(2, 0, 255);
-        uint8_t wave4 = beatsin8(1, 0, 255);
+    /* Make sure every led is fully on/off */
+    if (i >= middle) {
+        memset(_powerMask, _isOn ? 255 : 0, _highestPixelAddress);
+        return FRAME_IDLE;
+    }
 
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            _leds[i] = ColorFromPalette(currentPalette, i+wave1+wave2+wave3+wave4); 
-        }
+    for (uint8_t j = 0; j < POWER_SWEEP_FADE_LENGTH; j++) {
+        uint8_t alpha = (POWER_SWEEP_FADE_LENGTH - j) * 255 / POWER_SWEEP_FADE_LENGTH;
+        int32_t right = _highestPixelAddress-1 - i - j;
 
-        EVERY_N_MILLISECONDS(100) {
-            nblendPaletteTowardPalette(currentPalette, targetPalette);          //Palette blending capability.
+        if (i + j < middle + 1) {
+            _stepPowerMask(i + j, alpha);
         }
-        
-        EVERY_N_SECONDS(5) {                                                    //Change the target palette to a random one every 5 seconds.
-            targetPalette = CRGBPalette16(
-                                            CHSV(random8(), 255, random8(128,255)),
-                                            CHSV(random8(), 255, random8(128,255)),
-                                            CHSV(random8(), 192, random8(128,255)),
-                                            CHSV(random8(), 255, random8(128,255))
-                                        );
+        if (right > middle) {
+            _stepPowerMask(right, alpha);
         }
-        
-        _showLeds();
-        vTaskDelay(1);
     }
+    layer.step++;
+
+    return 50;
 }
+#pragma endregion
 
+
+#pragma region Utilities
 /******************************************************************************/
 /*!
-  @brief    MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Rotates LEDs to the left in place, by reversing both parts and
+            then the whole array. Every LED is moved twice, whatever the
+            number of steps.
+  @param    leds                LEDs to rotate
+  @param    length              Number of LEDs
+  @param    steps               Steps (LEDs) to rotate
 */
 /******************************************************************************/
-void Ledstrip::modeTemplate1() {
-    _fullColor = CRGB(0, 0, 0);
-    _fadeToColor();                                                             //Black background
+void Ledstrip::_rotateLeft(CRGB leds[], uint16_t length, uint16_t steps) {
+    if (length == 0 || steps % length == 0) {
+        return;
+    }
+    steps %= length;
 
-    _waitUntilIdle();
-     
-    _mode = MODE_TEMPLATE_1;
-    _state = _LOOPING;
-    
-    _l.logi("Start MODE_TEMPLATE_1 mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    _reverseLeds(leds, steps);
+    _reverseLeds(&leds[steps], length - steps);
+    _reverseLeds(leds, length);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Reverses the order of the LEDs in place.
+  @param    leds                LEDs to reverse
+  @param    length              Number of LEDs
 */
 /******************************************************************************/
-void Ledstrip::__modeTemplate1() {
-
-    while (1) {
-
-        _showLeds();
-        vTaskDelay(1);
+void Ledstrip::_reverseLeds(CRGB leds[], uint16_t length) {
+    for (uint16_t i = 0, j = length - 1; i < j; i++, j--) {
+        CRGB temp = leds[i];
+        leds[i] = leds[j];
+        leds[j] = temp;
     }
 }
 
 /******************************************************************************/
 /*!
-  @brief    MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Shuffles the indexes, every order is equally likely.
+  @param    indexes             Indexes to shuffle
+  @param    length              Number of indexes
+  @param    random              Generator to shuffle with
 */
 /******************************************************************************/
-void Ledstrip::modeTemplate2() {
-    //_fullColor = CRGB(0, 0, 0);
-    //_fadeToColor();                                                             //Black background
-
-    //_waitUntilIdle();
-     
-    _mode = MODE_TEMPLATE_2;
-    _state = _LOOPING;
-    
-    _l.logi("Start MODE_TEMPLATE_2 mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+void Ledstrip::_shuffleIndexes(uint16_t indexes[], uint16_t length, Random &random) {
+    for (uint16_t i = 0; i < length; i++) {
+        uint16_t randomIndex = random.next(i, length);                               //Generate a random index between i and n, index < i is already randomized
+        
+        /* Swap elements */
+        uint16_t temp = indexes[i];
+        indexes[i] = indexes[randomIndex];
+        indexes[randomIndex] = temp;
+    }
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Generates a random CRGB type color.
+  @param    saturationPerc      The saturation percentage (0-100)
+  @returns  CRGB                The color
 */
 /******************************************************************************/
-void Ledstrip::__modeTemplate2() {
-    
-    while (1) {
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_TEMPLATE_2].delay);
+CRGB Ledstrip::_randomColor(uint8_t saturationPerc) {
+    uint8_t r = _random.next(0, 255);
+    uint8_t g = _random.next(0, 255);
+    uint8_t b = _random.next(0, 255);
+    uint16_t limit = (uint16_t) 765 - 765 * saturationPerc / 100;               //Calculate limit (for saturation)
+  
+    if (r + g + b > limit) {                                                    //If color exceeds limit, turn one channel 0
+        uint8_t randomRGB = _random.next(0, 2);
+        if (randomRGB == 0) {
+            r = 0;
+        }
+        if (randomRGB == 1) {
+            g = 0;
+        }
+        if (randomRGB == 2) {
+            b = 0;
+        }
     }
+    return CRGB (r, g, b);
 }
 
 /******************************************************************************/
 /*!
-  @brief    MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Blends two colors in fixed point. An alpha of 0 returns exactly
+            color 1, 255 exactly color 2.
+  @param    color1              First color
+  @param    color2              Second color
+  @param    alpha               Portion of color 2, 0 - 255
+  @returns  CRGB                Blended color
 */
 /******************************************************************************/
-void Ledstrip::modeTemplate3() {
-    //_fullColor = CRGB(0, 0, 0);
-    //_fadeToColor();                                                           //Black background
-
-    //_waitUntilIdle();
-     
-    _mode = MODE_TEMPLATE_3;
-    _state = _LOOPING;
-    
-    _l.logi("Start MODE_TEMPLATE_3 mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+CRGB Ledstrip::_blendColors(CRGB color1, CRGB color2, uint8_t alpha) {
+    return blendColors(color1, color2, alpha);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Blends two color arrays with an alpha per pixel. For one alpha
+            for all pixels, use _fadeColors().
+  @param    leds                Output colors, may be one of the inputs
+  @param    colors1             First colors
+  @param    colors2             Second colors
+  @param    alphas              Portion of the second color per pixel, 0 - 255
+  @param    length              Number of LEDs
 */
 /******************************************************************************/
-void Ledstrip::__modeTemplate3() {
-    
-    while (1) {
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_TEMPLATE_3].delay);
+void Ledstrip::_blendColors(CRGB leds[], const CRGB colors1[], const CRGB colors2[], const uint8_t alphas[], uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
+        leds[i] = _blendColors(colors1[i], colors2[i], alphas[i]);
     }
 }
 
 /******************************************************************************/
 /*!
-  @brief    MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Returns the progress of a fixed duration fade.
+  @param    elapsed             Time since the start of the fade, in ms
+  @param    duration            Duration of the fade, in ms
+  @returns  uint16_t            Progress, Q8.8 (0 - FADE_PROGRESS_END)
 */
 /******************************************************************************/
-void Ledstrip::modeTemplate4() {
-    //_fullColor = CRGB(0, 0, 0);
-    //_fadeToColor();                                                             //Black background
-
-    //_waitUntilIdle();
-     
-    _mode = MODE_TEMPLATE_4;
-    _state = _LOOPING;
-    
-    _l.logi("Start MODE_TEMPLATE_4 mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+uint16_t Ledstrip::_getFadeProgress(uint32_t elapsed, uint32_t duration) {
+    return getFadeProgress(elapsed, duration);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Linear interpolation between two color arrays, in fixed point.
+            Processes four pixels per iteration. At a progress of
+            FADE_PROGRESS_END the result is exactly the end colors. The
+            output may be the same array as one of the inputs.
+  @param    leds                Output colors
+  @param    from                Start colors
+  @param    to                  End colors
+  @param    progress            Progress, Q8.8 (0 - FADE_PROGRESS_END)
+  @param    length              Number of LEDs
 */
 /******************************************************************************/
-void Ledstrip::__modeTemplate4() {
-    
-    while (1) {
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_TEMPLATE_4].delay);
-    }
+void Ledstrip::_fadeColors(CRGB leds[], const CRGB from[], const CRGB to[], uint16_t progress, uint16_t length) {
+    fadeChannels((uint8_t*) leds, (const uint8_t*) from, (const uint8_t*) to, progress, length * sizeof(CRGB));
 }
 
 /******************************************************************************/
 /*!
-  @brief    MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Used to pick colors for rainbow method. Looked up in the color
+            wheel table.
+  @param    position            Position on wheel (0-255)
+  @returns  CRGB color          The color
 */
 /******************************************************************************/
-void Ledstrip::modeTemplate5() {
-    //_fullColor = CRGB(0, 0, 0);
-    //_fadeToColor();                                                             //Black background
-
-    //_waitUntilIdle();
-     
-    _mode = MODE_TEMPLATE_5;
-    _state = _LOOPING;
-    
-    _l.logi("Start MODE_TEMPLATE_5 mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+CRGB Ledstrip::_colorWheel(uint8_t position) {
+    return CRGB(COLOR_WHEEL_TABLE.red[position], COLOR_WHEEL_TABLE.green[position], COLOR_WHEEL_TABLE.blue[position]);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Sine wave of the specified beats per minute at the specified time,
+            like beatsin8() of FastLED but on the time of the step instead of
+            the system time.
+  @param    bpm                 Beats per minute
+  @param    time                Time, in ms
+  @returns  uint8_t             Value of the wave (0-255)
 */
 /******************************************************************************/
-void Ledstrip::__modeTemplate5() {
-    
-    while (1) {
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_TEMPLATE_5].delay);
-    }
+uint8_t Ledstrip::_beatSin8(uint8_t bpm, uint32_t time) {
+    uint16_t beat = (time * ((uint32_t) bpm << 8) * 280) >> 16;                //Same scale as beat16(), overflow wraps the phase
+    return sin8(beat >> 8);
 }
 
 /******************************************************************************/
 /*!
-  @brief    MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Function to start the render task.
 */
 /******************************************************************************/
-void Ledstrip::modeTemplate6() {
-    //_fullColor = CRGB(0, 0, 0);
-    //_fadeToColor();                                                             //Black background
+void Ledstrip::__startRenderTask(void* parameter) {
+    Ledstrip* ledRef = static_cast<Ledstrip *>(parameter);
 
-    //_waitUntilIdle();
-     
-    _mode = MODE_TEMPLATE_6;
-    _state = _LOOPING;
-    
-    _l.logi("Start MODE_TEMPLATE_6 mode");
+    ledRef->__render();
+}
+
+/******************************************************************************/
+/*!
+  @brief    Starts the task that renders the segments and layers, and its
+            message queue. The task runs as long as the strip, mode changes
+            are handed over as messages.
+*/
+/******************************************************************************/
+void Ledstrip::_startRenderTask() {
+    _renderQueue = xQueueCreate(RENDER_QUEUE_LENGTH, sizeof(RenderMessage));
+    _renderJoinMutex = xSemaphoreCreateMutex();
+    _renderJoinSemaphore = xSemaphoreCreateBinary();
     
     xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
+        Ledstrip::__startRenderTask,                                            //Task function
+        "RenderHandler",                                                        //Task name
         8000,                                                                   //Stack size in bytes
         this,                                                                   //Task parameter
         PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
+        &_renderTaskHandler,                                                    //Task handler
         CORE_NUMBER                                                             //Task CPU core
     );
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Task. Renders every segment and layer that reached its frame
+            deadline and presents the frame. Each segment has its own
+            deadline, so segments with different speeds share the same
+            frames. Layers are composited over the segments when the frame is
+            presented, so the segments keep running underneath them. Between
+            frames the task waits for messages, until the next deadline or,
+            when nothing is animated, until the next message.
 */
 /******************************************************************************/
-void Ledstrip::__modeTemplate6() {
-    
+void Ledstrip::__render() {
+    bool isRendered[MAX_NUMBER_OF_SEGMENTS];
+    bool isLayerRendered[NUMBER_OF_LAYERS];
+    uint16_t layerPeriods[NUMBER_OF_LAYERS];
+
+    uint32_t joinedMessage = 0;                                                 //Last message handled since the previous frame, 0 if none
+
     while (1) {
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_TEMPLATE_6].delay);
+        TickType_t now = xTaskGetTickCount();
+        bool isVisible = _isOn || _layers[LAYER_POWER].isAnimated;              //Nothing is rendered while the strip is off
+        bool isPresentNeeded = false;
+
+        for (uint8_t i = 0; i < _numberOfSegments; i++) {
+            Segment &segment = _segments[i];
+            isRendered[i] = false;
+
+            if (!isVisible) {
+                continue;
+            }
+
+            if (segment.state.phase != SEGMENT_IDLE && (int32_t) (now - segment.state.nextFrameTime) >= 0) {
+                if (!_renderSegment(segment, now)) {
+                    segment.state.phase = SEGMENT_IDLE;
+                }
+                isRendered[i] = true;
+                isPresentNeeded = true;
+            }
+
+            /* Both modes run during a transition, the crossfade moves on every frame */
+            if (segment.isTransitioning) {
+                _renderTransition(segment, now);
+                isPresentNeeded = true;
+            }
+        }
+
+        for (uint8_t i = 0; i < NUMBER_OF_LAYERS; i++) {
+            isLayerRendered[i] = false;
+
+            if (!isVisible || !_layers[i].isAnimated || (int32_t) (now - _layers[i].nextFrameTime) < 0) {
+                continue;
+            }
+
+            layerPeriods[i] = _renderLayer(i);
+            isLayerRendered[i] = true;
+            isPresentNeeded = true;
+        }
+
+        if (isPresentNeeded) {
+            _presentFrame();
+        }
+
+        /* Mode switch latency, from setMode() until the first frame of the mode is presented */
+        if (isPresentNeeded && _modeSwitchSendTime != 0) {
+            uint32_t switchTime = esp_timer_get_time() - _modeSwitchSendTime;
+            if (switchTime > _maxModeSwitchTime) {
+                _maxModeSwitchTime = switchTime;
+            }
+            _modeSwitchSendTime = 0;
+        }
+
+        /* The messages are applied in this frame, release the task that sent the last one */
+        if (joinedMessage != 0) {
+            _appliedRenderMessage = joinedMessage;
+            xSemaphoreGive(_renderJoinSemaphore);
+            joinedMessage = 0;
+        }
+
+        /* Schedule the next frames, deadlines are absolute so render time is part of the period */
+        now = xTaskGetTickCount();
+        TickType_t wakeTime = now + pdMS_TO_TICKS(FRAME_IDLE);
+        bool isFading = false;
+        bool isAnimated = false;
+
+        for (uint8_t i = 0; i < _numberOfSegments; i++) {
+            SegmentState &state = _segments[i].state;
+
+            if (isVisible && _segments[i].isTransitioning) {
+                isFading = true;
+                isAnimated = true;
+
+                TickType_t transitionFrameTime = now + pdMS_TO_TICKS(1000 / DEFAULT_FRAME_RATE);
+                if ((int32_t) (transitionFrameTime - wakeTime) < 0) {
+                    wakeTime = transitionFrameTime;
+                }
+            }
+
+            if (!isVisible || state.phase == SEGMENT_IDLE) {
+                continue;
+            }
+
+            /* Segments keep their own step times, a late segment catches up in the next frame */
+            if (isRendered[i]) {
+                _updateFrameHeadroom(state.nextFrameTime, now);
+            }
+
+            isAnimated = true;
+
+            if ((int32_t) (state.nextFrameTime - wakeTime) < 0) {
+                wakeTime = state.nextFrameTime;
+            }
+        }
+
+        for (uint8_t i = 0; i < NUMBER_OF_LAYERS; i++) {
+            Layer &layer = _layers[i];
+
+            if (isLayerRendered[i] && !_scheduleNextFrame(layer.nextFrameTime, layerPeriods[i], now)) {
+                layer.isAnimated = false;
+
+                if (i == LAYER_POWER) {
+                    _l.logd("End power animation");
+                    layer.isEnabled = !_isOn;                                   //Mask keeps the strip dark while off
+
+                    if (!_isOn && !_doorState) {
+                        _layers[LAYER_DOOR].isEnabled = false;
+                    }
+                }
+            }
+
+            if (!layer.isAnimated) {
+                continue;
+            }
+
+            isFading |= i == LAYER_POWER;                                       //Only reported by getState(), a command preempts the animation at the next frame
+            isAnimated = true;
+
+            if ((int32_t) (layer.nextFrameTime - wakeTime) < 0) {
+                wakeTime = layer.nextFrameTime;
+            }
+        }
+
+        if (!isAnimated) {
+            _state = _READY_TO_RUN;
+        } else {
+            _state = isFading ? _FADE_TO_MODE : _LOOPING;
+        }
+
+        /* Wait for the next deadline or message, all queued messages are handled before the next frame */
+        RenderMessage message;
+        TickType_t timeout = isAnimated ? max((int32_t) (wakeTime - now), (int32_t) 0) : portMAX_DELAY;
+
+        if (xQueueReceive(_renderQueue, &message, timeout) == pdTRUE) {
+            do {
+                _handleRenderMessage(message);
+                joinedMessage = message.sequence;                               //Messages are handled in order
+            } while (xQueueReceive(_renderQueue, &message, 0) == pdTRUE);
+        }
     }
 }
 
 /******************************************************************************/
 /*!
-  @brief    MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Moves the deadline of a segment or layer to the next frame.
+            Missed deadlines restart counting from now.
+  @param    nextFrameTime       Deadline to move, in ticks
+  @param    period              Time until the next frame in ms, 0 for as
+                                soon as possible
+  @param    now                 Current time, in ticks
+  @returns  bool                False if the period is FRAME_IDLE
 */
 /******************************************************************************/
-void Ledstrip::modeTemplate7() {
-    //_fullColor = CRGB(0, 0, 0);
-    //_fadeToColor();                                                             //Black background
+bool Ledstrip::_scheduleNextFrame(TickType_t &nextFrameTime, uint16_t period, TickType_t now) {
+    if (period == FRAME_IDLE) {
+        return false;
+    }
 
-    //_waitUntilIdle();
-     
-    _mode = MODE_TEMPLATE_7;
-    _state = _LOOPING;
-    
-    _l.logi("Start MODE_TEMPLATE_7 mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    if (period == 0) {
+        nextFrameTime = now;                                                    //Limited by the output, not a deadline
+        return true;
+    }
+
+    nextFrameTime += pdMS_TO_TICKS(period);
+
+    if (!_updateFrameHeadroom(nextFrameTime, now)) {
+        nextFrameTime = now;                                                    //Restart counting from now
+    }
+
+    return true;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Updates the frame deadline statistics with the next deadline.
+  @param    nextFrameTime       Deadline of the next frame, in ticks
+  @param    now                 Current time, in ticks
+  @returns  bool                False if the deadline is already missed
 */
 /******************************************************************************/
-void Ledstrip::__modeTemplate7() {
-    
-    while (1) {
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_TEMPLATE_7].delay);
+bool Ledstrip::_updateFrameHeadroom(TickType_t nextFrameTime, TickType_t now) {
+    int32_t headroom = (int32_t) (nextFrameTime - now);
+
+    if (headroom < 0) {
+        _missedFrameDeadlines++;
+        _frameHeadroom = 0;
+        return false;
+    }
+
+    if (headroom * portTICK_PERIOD_MS < _frameHeadroom) {
+        _frameHeadroom = headroom * portTICK_PERIOD_MS;
     }
+
+    return true;
 }
 
 /******************************************************************************/
 /*!
-  @brief    MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Hands a message over to the render task and waits until the frame
+            it applies to is presented. The render task handles messages at
+            frame boundaries, so a running animation is cancelled within one
+            frame. The wait is bounded by RENDER_JOIN_TIMEOUT.
+  @param    type                Message type
+  @param    value               Mode, power state, door state or brightness
+  @param    segment             Segment index or ALL_SEGMENTS, for modes
+  @returns  bool                True if the message was applied in time
 */
 /******************************************************************************/
-void Ledstrip::modeTemplate8() {
-    //_fullColor = CRGB(0, 0, 0);
-    //_fadeToColor();                                                             //Black background
+bool Ledstrip::_sendRenderMessage(uint8_t type, uint8_t value, uint8_t segment) {
+    RenderMessage message;
+    message.type = type;
+    message.value = value;
+    message.segment = segment;
 
-    //_waitUntilIdle();
-     
-    _mode = MODE_TEMPLATE_8;
-    _state = _LOOPING;
-    
-    _l.logi("Start MODE_TEMPLATE_8 mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    return _sendRenderMessage(message);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Hands the specified message over to the render task and waits
+            until the frame it applies to is presented, bounded by
+            RENDER_JOIN_TIMEOUT. The LEDs of the message are freed if it is
+            dropped, else by the render task.
+            Senders are joined one at a time through _renderJoinSemaphore,
+            the task notifications of the sending task are not used.
+  @param    message             Message, the send time and sequence are set
+  @returns  bool                True if the message was applied in time
 */
 /******************************************************************************/
-void Ledstrip::__modeTemplate8() {
-    
-    while (1) {
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_TEMPLATE_8].delay);
+bool Ledstrip::_sendRenderMessage(RenderMessage &message) {
+    if (_renderQueue == NULL) {
+        _l.loge("Render task not started");
+        free(message.leds);
+        return false;
+    }
+
+    if (xSemaphoreTake(_renderJoinMutex, pdMS_TO_TICKS(RENDER_MESSAGE_TIMEOUT + RENDER_JOIN_TIMEOUT)) != pdTRUE) {
+        _l.logw("Render task busy, message dropped");
+        free(message.leds);
+        return false;
+    }
+
+    /* Sequence 0 is no message, so it is skipped when the sequence wraps */
+    _renderMessageSequence = _renderMessageSequence == UINT32_MAX ? 1 : _renderMessageSequence + 1;
+    message.sequence = _renderMessageSequence;
+    message.sendTime = esp_timer_get_time();
+
+    xSemaphoreTake(_renderJoinSemaphore, 0);                                    //Drain the release of a join that timed out
+
+    if (xQueueSend(_renderQueue, &message, pdMS_TO_TICKS(RENDER_MESSAGE_TIMEOUT)) != pdTRUE) {
+        xSemaphoreGive(_renderJoinMutex);
+        _l.logw("Render queue full, message dropped");
+        free(message.leds);                                                     //Not handed over, so it is still owned here
+        return false;
     }
+
+    /* A late release of an earlier message can still come in, so the sequence decides */
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(RENDER_JOIN_TIMEOUT);
+    bool isApplied = false;
+
+    while (!(isApplied = (int32_t) (_appliedRenderMessage - message.sequence) >= 0)) {
+        int32_t timeLeft = deadline - xTaskGetTickCount();
+        if (timeLeft <= 0) {
+            break;
+        }
+        xSemaphoreTake(_renderJoinSemaphore, timeLeft);
+    }
+
+    xSemaphoreGive(_renderJoinMutex);
+
+    if (!isApplied) {
+        _l.logw("Render task did not apply message in time");
+    }
+
+    return isApplied;
 }
 
 /******************************************************************************/
 /*!
-  @brief    MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Handles a message in the render task, between two frames.
+  @param    message             Message to handle
 */
 /******************************************************************************/
-void Ledstrip::modeTemplate9() {
-    //_fullColor = CRGB(0, 0, 0);
-    //_fadeToColor();                                                             //Black background
+void Ledstrip::_handleRenderMessage(RenderMessage &message) {
+    switch (message.type) {
+        case RENDER_MESSAGE_SET_MODE:
+            _startMode(message.value, message.segment);
 
-    //_waitUntilIdle();
-     
-    _mode = MODE_TEMPLATE_9;
-    _state = _LOOPING;
-    
-    _l.logi("Start MODE_TEMPLATE_9 mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+            if (_isOn) {
+                _modeSwitchSendTime = message.sendTime;
+            }
+            break;
+        case RENDER_MESSAGE_SET_POWER:
+            if ((bool) message.value != _isOn) {
+                _startPowerAnimation(message.value);
+            }
+            break;
+        case RENDER_MESSAGE_DOOR_CHANGE:
+            if ((bool) message.value == _doorState) {
+                break;
+            }
+            _doorState = message.value;
+
+            if (_doorState) {
+                _handleDoorOpen();
+            } else {
+                _handleDoorClosed();
+            }
+            break;
+        case RENDER_MESSAGE_SET_BRIGHTNESS:
+            _setTargetBrightness(message.value);
+            break;
+        case RENDER_MESSAGE_DRAW:
+            memcpy(_leds, message.leds, min(_highestPixelAddress, _numberLeds) * sizeof(CRGB));
+            free(message.leds);
+            _presentFrame();
+            break;
+        case RENDER_MESSAGE_CONFIGURE_MODE:
+            _applyModeParameters(message.value, message.parameters, message.segment);
+            break;
+        default:
+            break;
+    }
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Adds a FastLED controller for every output. Each output drives a
+            slice of the output buffer, FastLED.show() clocks them out in
+            parallel (RMT channels), so the frame time depends on the longest
+            output instead of the whole strip. WS2801 strips use hardware SPI
+            and always have one output. The dithering of FastLED is disabled,
+            it only works when every frame is sent again.
 */
 /******************************************************************************/
-void Ledstrip::__modeTemplate9() {
-    
-    while (1) {
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_TEMPLATE_9].delay);
+void Ledstrip::_addOutputs() {
+    if (_driver == _WS2801) {
+        if (_numberOfOutputs > 1) {
+            _l.logw("WS2801 strips support one output, sending all LEDs over the first");
+        }
+        FastLED.addLeds<WS2801, LEDSTRIP_DATA_PIN, LEDSTRIP_CLOCK_PIN, RBG>(_tempLeds, _numberLeds);
+    } else {
+        uint16_t offset = 0;
+
+        /* Pins are template parameters, so every output has its own case */
+        for (uint8_t output = 0; output < _numberOfOutputs; output++) {
+            switch (output) {
+                case 0:
+                    _addOutput<LEDSTRIP_DATA_PIN>(offset, _outputLengths[output]);
+                    break;
+                case 1:
+                    _addOutput<LEDSTRIP_DATA_PIN_2>(offset, _outputLengths[output]);
+                    break;
+                case 2:
+                    _addOutput<LEDSTRIP_DATA_PIN_3>(offset, _outputLengths[output]);
+                    break;
+                case 3:
+                    _addOutput<LEDSTRIP_DATA_PIN_4>(offset, _outputLengths[output]);
+                    break;
+                case 4:
+                    _addOutput<LEDSTRIP_DATA_PIN_5>(offset, _outputLengths[output]);
+                    break;
+                case 5:
+                    _addOutput<LEDSTRIP_DATA_PIN_6>(offset, _outputLengths[output]);
+                    break;
+                case 6:
+                    _addOutput<LEDSTRIP_DATA_PIN_7>(offset, _outputLengths[output]);
+                    break;
+                case 7:
+                    _addOutput<LEDSTRIP_DATA_PIN_8>(offset, _outputLengths[output]);
+                    break;
+                default:
+                    break;
+            }
+
+            _l.logi("Output " + String(output + 1) + ": " + String(_outputLengths[output]) + " LEDs");
+            offset += _outputLengths[output];
+        }
     }
+
+    FastLED.setDither(DISABLE_DITHER);                                          //Dithering is done by the output stage, FastLED would dither its output a second time
 }
 
 /******************************************************************************/
 /*!
-  @brief    MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Adds a FastLED controller for one output of a clockless driver.
+  @param    offset              First LED of the output in the output buffer
+  @param    length              Number of LEDs of the output
 */
 /******************************************************************************/
-void Ledstrip::modeTemplate10() {
-    //_fullColor = CRGB(0, 0, 0);
-    //_fadeToColor();                                                           //Black background
+template <uint8_t DATA_PIN>
+void Ledstrip::_addOutput(uint16_t offset, uint16_t length) {
+    if (length == 0) {
+        return;
+    }
 
-    //_waitUntilIdle();
-     
-    _mode = MODE_TEMPLATE_10;
-    _state = _LOOPING;
-    
-    _l.logi("Start MODE_TEMPLATE_10 mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    if (_driver == _WS2812B) {
+        FastLED.addLeds<WS2812B, DATA_PIN, WS2812B_COLOR_ORDER>(&_tempLeds[offset], length);
+    } else if (_driver == _SK6812) {
+        FastLED.addLeds<WS2812B, DATA_PIN, RGB>((CRGB *) &_crgbwTempLeds[offset], getRGBWsize(length));
+    }
 }
 
 /******************************************************************************/
 /*!
-  @brief    Task. MODE TEMPLATE TO BE IMPLEMENTED.
+  @brief    Loads the pixel addressing from non-volatile memory and allocates
+            the pixel buffers for it.
 */
 /******************************************************************************/
-void Ledstrip::__modeTemplate10() {
+void Ledstrip::_loadPixelAddresses() {
+    _nvMemory.begin(NV_MEM_CONFIG);
+    String addressString = _nvMemory.getString("ledAddresses");
+    _nvMemory.end();
+
+    JsonDocument jsonParser;
     
-    while (1) {
-        _showLeds();
-        vTaskDelay(_modeParameters[MODE_TEMPLATE_10].delay);
+    if (addressString == "") {
+        _numberOfOutputs = 1;
+        _outputLengths[0] = _numberLeds;
+        _highestPixelAddress = _numberLeds;
+    } else {
+        deserializeJson(jsonParser, addressString);                             //Convert JSON string to object
+
+        _numberOfOutputs = _parseOutputs(jsonParser, _numberLeds, _outputLengths);
+        _highestPixelAddress = _getFrameSize(jsonParser);
+    }
+
+    if (!_allocateBuffers()) {
+        return;
     }
-}
-#pragma endregion
 
+    if (addressString == "") {
+        for (uint16_t i = 0; i < _numberLeds; i++) {
+            _ledAddresses[i] = i;
+        }
+    } else {
+        _parsePixelAddresses(jsonParser);
+    }
+
+    _compilePixelAddresses();
+}
 
-#pragma region System modes
 /******************************************************************************/
 /*!
-  @brief    Random color blobs light up, then fade away.
-  @param    color1          Color 1
-  @param    color2          Color 2
-  @param    delayBetween    Delay between fireworks (in ms)
+  @brief    Parses the output layout of the pixel addressing. An array of
+            arrays has one array per output, a flat array is one output. The
+            output lengths are clipped to the number of LEDs, LEDs without
+            address are added to the last output.
+  @param    addresses           JSON array with addresses
+  @param    numberOfLeds        Number of LEDs
+  @param    outputLengths       Number of LEDs per output, size: MAX_NUMBER_OF_OUTPUTS
+  @returns  uint8_t             Number of outputs
 */
 /******************************************************************************/
-void Ledstrip::systemPulses() {
-    _fullColor = CRGB(0, 0, 0);
-    _fadeToColor();                                                             //Black background
+uint8_t Ledstrip::_parseOutputs(JsonDocument &addresses, uint16_t numberOfLeds, uint16_t outputLengths[]) {
+    if (!addresses[0].is<JsonArray>()) {
+        outputLengths[0] = numberOfLeds;
+        return 1;
+    }
 
-    _waitUntilIdle();
-     
-    _mode = SYSTEM_MODE_PULSES;
-    _state = _LOOPING;
-    
-    _l.logi("Start pulses mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    uint8_t numberOfOutputs = min(addresses.size(), (size_t) MAX_NUMBER_OF_OUTPUTS);
+    uint16_t assignedLeds = 0;
+
+    for (uint8_t output = 0; output < numberOfOutputs; output++) {
+        outputLengths[output] = min(addresses[output].size(), (size_t) (numberOfLeds - assignedLeds));
+        assignedLeds += outputLengths[output];
+    }
+    outputLengths[numberOfOutputs - 1] += numberOfLeds - assignedLeds;
+
+    if (addresses.size() > MAX_NUMBER_OF_OUTPUTS) {
+        _l.logw("Too many outputs, using the first " + String(MAX_NUMBER_OF_OUTPUTS));
+    }
+
+    return numberOfOutputs;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Random color blobs light up, then fade away.
+  @brief    Returns the address of an output LED from the JSON addressing.
+            The outputs are consecutive, so index runs over all outputs.
+  @param    addresses           JSON array with addresses
+  @param    index               Index of the LED in the output buffer
+  @returns  uint16_t            Pixel address, 0 if not in the JSON
 */
 /******************************************************************************/
-void Ledstrip::__systemPulses() {
-    uint16_t padding = 20;
-    uint16_t segmentLocation = padding;                                         //Padding because there is where the leds will start to shine
-    int8_t segmentDirection = 1;
-    
-    while (1) {
-        /* Draw background */
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            _leds[i] = CRGB(0,0,0);
-        }
-
-        /* Draw tail */
-        float color1Portion = 0;
-        CRGB tailColor;
-        CRGB color1 = CRGB (255,255,255);
-        CRGB color2 = CRGB (0,0,0);
-        
-        for (uint8_t i = 0; i < padding; i++) {
-            color1Portion = (padding - i) * 1.0 / padding;
-            color1Portion = color1Portion / 2;
-            
-            tailColor = _blendColors(color1, color1Portion, color2);
-            
-            if (segmentLocation - padding - i >= 0) {
-                _leds[segmentLocation - padding - i] = tailColor;
-            }
-            if (segmentLocation - padding + i < _highestPixelAddress) {
-                _leds[segmentLocation - padding + i] = tailColor;
-            }
-        }
-        
-        _showLeds();
-
-        /* No need to wait if no scanline has been drawn */
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            /* If something is drawn, wait */
-            if (_leds[i] != color2) {
-                vTaskDelay(50);
-                break;
-            }
-        }
+uint16_t Ledstrip::_getJsonPixelAddress(JsonDocument &addresses, uint16_t index) {
+    if (!addresses[0].is<JsonArray>()) {
+        return addresses[index];
+    }
 
-        /* Change directions */
-        if (segmentLocation >= _highestPixelAddress + padding*2) {
-            segmentDirection = -1;
-        } else if (segmentLocation == 0) {
-            segmentDirection = 1;
+    for (uint8_t output = 0; output < _numberOfOutputs; output++) {
+        if (index < _outputLengths[output]) {
+            return addresses[output][index];
         }
-        segmentLocation += segmentDirection;
+        index -= _outputLengths[output];
     }
+
+    return 0;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Random color blobs light up, then fade away.
-  @param    color1          Color 1
-  @param    color2          Color 2
-  @param    delayBetween    X
+  @brief    Returns the number of pixels of the frame that the JSON addressing
+            needs, the highest address + 1, clipped to MAX_NUMBER_LEDS.
+  @param    addresses           JSON array with addresses
+  @returns  uint16_t            Number of pixels of the frame
 */
 /******************************************************************************/
-void Ledstrip::systemAlarm() {
-    _fullColor = CRGB(0, 0, 0);
-    _fadeToColor();                                                             //Black background
+uint16_t Ledstrip::_getFrameSize(JsonDocument &addresses) {
+    uint16_t highestAddress = 0;
 
-    _waitUntilIdle();
-     
-    _mode = SYSTEM_MODE_ALARM;
-    _state = _LOOPING;
-    
-    _l.logi("Start alarm mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "ModeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    for (uint16_t i = 0; i < _numberLeds; i++) {
+        uint16_t address = _getJsonPixelAddress(addresses, i);
+        if (highestAddress < address) {
+            highestAddress = address;
+        }
+    }
+
+    return min(highestAddress + 1, MAX_NUMBER_LEDS);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Random color blobs light up, then fade away.
+  @brief    Parses the pixel addresses of the output LEDs. Addresses outside
+            the allocated frame are clipped to the last pixel.
+  @param    addresses           JSON array with addresses
 */
 /******************************************************************************/
-void Ledstrip::__systemAlarm() {
-    uint8_t cycle = 0;
-
-    while (1) {
-        /* Flash and then wait */
-        for (uint8_t flash = 0; flash < 4; flash++) {
-            for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-                _leds[i] = CRGB(255, 255, 255);
-            }
-            _showLeds();
-            vTaskDelay(25);
-            for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-                _leds[i] = CRGB(0, 0, 0);
-            }
-            _showLeds();
-            vTaskDelay(150);
-        }
-
-        /* If alarm is on for long, flash continuously */
-        if (cycle < 50) {
-            vTaskDelay(750);
-            cycle++;
+void Ledstrip::_parsePixelAddresses(JsonDocument &addresses) {
+    for (uint16_t i = 0; i < _numberLeds; i++) {
+        _ledAddresses[i] = _getJsonPixelAddress(addresses, i);
+        if (_ledAddresses[i] >= _highestPixelAddress) {
+            _ledAddresses[i] = _highestPixelAddress - 1;
         }
     }
 }
-#pragma endregion
 
-#pragma region Power functionality
 /******************************************************************************/
 /*!
-  @brief    Start fade power animation.
+  @brief    Loads the segments and their modes. Every segment gets its own
+            part of the scratch buffer.
 */
 /******************************************************************************/
-void Ledstrip::_powerFade() {
-    _state = _POWER_FADE;
-    
-    _l.logd("Start powerFade mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "PowerHandler",                                                         //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+void Ledstrip::_loadSegments() {
+    uint8_t segmentModes[MAX_NUMBER_OF_SEGMENTS];
+
+    _nvMemory.begin(NV_MEM_CONFIG);
+    String segmentsString = _nvMemory.getString("segments", "[]");
+    uint8_t mode = _nvMemory.getUChar("mode", MODE_COLOR);
+    if (_nvMemory.getBytes("segmentModes", segmentModes, MAX_NUMBER_OF_SEGMENTS) != MAX_NUMBER_OF_SEGMENTS) {
+        memset(segmentModes, mode, MAX_NUMBER_OF_SEGMENTS);                     //Configured before segments existed
+    }
+    _nvMemory.end();
+
+    JsonDocument jsonParser;
+    deserializeJson(jsonParser, segmentsString);                                //Convert JSON string to object
+
+    uint16_t segmentLengths[MAX_NUMBER_OF_SEGMENTS];
+    _numberOfSegments = _parseSegments(jsonParser, segmentLengths);
+
+    uint16_t start = 0;
+    for (uint8_t i = 0; i < _numberOfSegments; i++) {
+        _segments[i].start = start;
+        _segments[i].length = segmentLengths[i];
+        _segments[i].mode = segmentModes[i];
+
+        /* Scratch memory grows with the segment length, plus the extra bytes of every segment */
+        size_t scratchOffset = start * SCRATCH_BYTES_PER_LED + i * (SCRATCH_EXTRA_BYTES + BUFFER_ALIGNMENT);
+        scratchOffset = (scratchOffset + BUFFER_ALIGNMENT - 1) & ~(BUFFER_ALIGNMENT - 1);
+        _segments[i].leds = &_leds[start];
+        _segments[i].scratch = _scratchBuffer + scratchOffset;
+
+        /* The outgoing mode uses the same parts of the transition buffers */
+        _outgoingSegments[i].start = start;
+        _outgoingSegments[i].length = segmentLengths[i];
+        _outgoingSegments[i].leds = &_transitionLeds[start];
+        _outgoingSegments[i].scratch = _transitionScratchBuffer + scratchOffset;
+        _segments[i].outgoing = &_outgoingSegments[i];
+
+        _l.logi("Segment " + String(i) + ": " + String(start) + " - " + String(start + segmentLengths[i] - 1));
+        start += segmentLengths[i];
+    }
 }
 
 /******************************************************************************/
 /*!
-  @brief   Fade power animation thread.
+  @brief    Loads the parameters of every mode, and the parameters of the
+            segments that run a mode with parameters of their own, from
+            non-volatile memory. Called before the render task starts.
 */
 /******************************************************************************/
-void Ledstrip::__powerFade() {
-    /* Fade */
-    float color1Portion = 0;
-    
-    for (uint16_t timeStep = 0; timeStep <= 100; timeStep++) {
-        color1Portion = timeStep * 1.0 / 100;
-            
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            if (_isOn) {
-                _leds[i] = _blendColors(_savedLeds[i], color1Portion, CRGB(0, 0, 0));
-            } else {
-                _leds[i] = _blendColors(CRGB(0, 0, 0), color1Portion, _savedLeds[i]);
+void Ledstrip::_loadModeParameters() {
+    for (uint8_t mode = 1; mode < NUM_MODES; mode++) {
+        _modeParameters[mode] = _memoryManager.loadModeParameters(mode);
+
+        for (uint8_t i = 0; i < _numberOfSegments; i++) {
+            if (_memoryManager.loadSegmentModeParameters(i, mode, _segmentModeParameters[i][mode])) {
+                _segmentModeOverrides[i] |= 1UL << mode;
             }
         }
-        _showLeds();
-        vTaskDelay(5);
     }
-    
-    _l.logd("End powerFade mode");
-    
-    _state = _READY_TO_RUN;
-    
-    _taskHandler = NULL;
-    vTaskDelete(_taskHandler);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Start dissolve power animation.
+  @brief    Parses the segment lengths. Lengths are clipped to the strip,
+            empty segments are skipped and LEDs after the last segment are
+            added to it. Without segments, the whole strip is one segment.
+  @param    segments            JSON array with segment lengths
+  @param    segmentLengths      Length per segment, size: MAX_NUMBER_OF_SEGMENTS
+  @returns  uint8_t             Number of segments
 */
 /******************************************************************************/
-void Ledstrip::_powerDissolve() {
-    _state = _POWER_DISSOLVE;
-    
-    _l.logd("Start powerDissolve mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "PowerHandler",                                                         //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+uint8_t Ledstrip::_parseSegments(JsonDocument &segments, uint16_t segmentLengths[]) {
+    uint8_t numberOfSegments = 0;
+    uint16_t start = 0;
+
+    for (uint8_t i = 0; i < segments.size() && numberOfSegments < MAX_NUMBER_OF_SEGMENTS; i++) {
+        uint16_t length = min((uint16_t) segments[i], (uint16_t) (_highestPixelAddress - start));
+        if (length == 0) {
+            continue;
+        }
+        segmentLengths[numberOfSegments] = length;
+        numberOfSegments++;
+        start += length;
+    }
+
+    if (numberOfSegments == 0) {
+        segmentLengths[0] = _highestPixelAddress;
+        return 1;
+    }
+
+    segmentLengths[numberOfSegments - 1] += _highestPixelAddress - start;
+
+    return numberOfSegments;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Dissolve power animation thread.
+  @brief    Allocates the pixel buffers for the current number of LEDs and
+            driver in one arena. The arena is placed in PSRAM when available.
+            Only the output buffer of the configured driver is allocated.
+  @returns  bool                True if success
 */
 /******************************************************************************/
-void Ledstrip::__powerDissolve() {
-    uint16_t randomIndex = 0;
-    uint16_t temp = 0;
-    uint16_t indexes[_highestPixelAddress];
-    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        indexes[i] = i;
+bool Ledstrip::_allocateBuffers() {
+    size_t frameSize = _highestPixelAddress * sizeof(CRGB);
+    size_t outputSize = _numberLeds * (_driver == _SK6812 ? sizeof(CRGBW) : sizeof(CRGB));
+
+    _bufferArenaSize = 0;
+    _bufferArenaUsed = 0;
+    
+    size_t scratchSize = _highestPixelAddress * SCRATCH_BYTES_PER_LED + MAX_NUMBER_OF_SEGMENTS * (SCRATCH_EXTRA_BYTES + BUFFER_ALIGNMENT);
+
+    size_t ditherSize = TEMPORAL_DITHERING ? _numberLeds * 3 : 0;
+
+    /* Arena size: addresses, runs, 4 frames, power mask and indexes, scratch, transition canvas and scratch, dither errors and the output buffer, all aligned */
+    size_t sizes[] = {_numberLeds * sizeof(uint16_t), _numberLeds * sizeof(PixelRun), frameSize, frameSize, frameSize, frameSize, _highestPixelAddress, _highestPixelAddress * sizeof(uint16_t), scratchSize, frameSize, scratchSize, ditherSize, outputSize};
+    for (uint8_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        _bufferArenaSize += (sizes[i] + BUFFER_ALIGNMENT - 1) & ~(BUFFER_ALIGNMENT - 1);
     }
-        
-    /* Shuffle order on randomized index */
-    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        randomIndex = random(i, _highestPixelAddress);                                      //Generate a random index between i and n, index < i is already randomized
-        
-        /* Swap elements */
-        temp = indexes[i];
-        indexes[i] = indexes[randomIndex];
-        indexes[randomIndex] = temp;
+
+    if (psramFound()) {
+        _bufferArena = (uint8_t *) heap_caps_calloc(1, _bufferArenaSize, MALLOC_CAP_SPIRAM);
+    }
+    if (_bufferArena == NULL) {
+        _bufferArena = (uint8_t *) heap_caps_calloc(1, _bufferArenaSize, MALLOC_CAP_8BIT);
+    }
+    if (_bufferArena == NULL) {
+        _l.logfe("Could not allocate " + String(_bufferArenaSize) + " bytes for the pixel buffers");
+        return false;
     }
 
-    /* Draw randomized leds */
-    float color1Portion = 0;
-    CRGB dotColor;
+    _l.logi("Pixel buffer arena: " + String(_bufferArenaSize) + " bytes" + (psramFound() ? " (PSRAM)" : ""));
 
-    for (uint16_t i = 0; i < _highestPixelAddress; i += 3) {
-        for (uint16_t timeStep = 0; timeStep <= 10; timeStep++) {
-            color1Portion = timeStep * 1.0 / 10;
-            
-            if (_isOn) {
-                dotColor = _blendColors(_savedLeds[indexes[i]], color1Portion, CRGB(0, 0, 0));
-            } else {
-                dotColor = _blendColors(CRGB(0, 0, 0), color1Portion, _savedLeds[indexes[i]]);
-            }
+    _ledAddresses = (uint16_t *) _carveBuffer(_numberLeds * sizeof(uint16_t), "_ledAddresses");
+    _pixelRuns = (PixelRun *) _carveBuffer(_numberLeds * sizeof(PixelRun), "_pixelRuns");
+    _leds = (CRGB *) _carveBuffer(frameSize, "_leds");
+    _frameBuffers[0] = (CRGB *) _carveBuffer(frameSize, "_frameBuffers[0]");
+    _frameBuffers[1] = (CRGB *) _carveBuffer(frameSize, "_frameBuffers[1]");
+    _snapshot = (CRGB *) _carveBuffer(frameSize, "_snapshot");
+    _powerMask = _carveBuffer(_highestPixelAddress, "_powerMask");
+    _powerIndexes = (uint16_t *) _carveBuffer(_highestPixelAddress * sizeof(uint16_t), "_powerIndexes");
+    _layers[LAYER_POWER].alpha = _powerMask;
+    _scratchBuffer = _carveBuffer(scratchSize, "_scratchBuffer");
+    _transitionLeds = (CRGB *) _carveBuffer(frameSize, "_transitionLeds");
+    _transitionScratchBuffer = _carveBuffer(scratchSize, "_transitionScratchBuffer");
 
-            uint8_t j = 0;
-            while (j < 3 && i+j < _highestPixelAddress) {
-                _leds[indexes[i+j]] = dotColor;
-                j++;
-            }
-            _showLeds();
-        }
+    if (TEMPORAL_DITHERING) {
+        _ditherErrors = _carveBuffer(ditherSize, "_ditherErrors");
     }
 
-    _l.logd("End powerDissolve mode");
-    
-    _state = _READY_TO_RUN;
-    
-    _taskHandler = NULL;
-    vTaskDelete(_taskHandler);
+    if (_driver == _SK6812) {
+        _crgbwTempLeds = (CRGBW *) _carveBuffer(outputSize, "_crgbwTempLeds");
+        _outputBuffer = (uint8_t *) _crgbwTempLeds;
+    } else {
+        _tempLeds = (CRGB *) _carveBuffer(outputSize, "_tempLeds");
+        _outputBuffer = (uint8_t *) _tempLeds;
+    }
+    _outputBufferSize = outputSize;
+
+    return true;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Start sweep power animation.
+  @brief    Takes the next buffer from the pixel buffer arena.
+  @param    size                Size of the buffer, in bytes
+  @param    name                Name of the buffer, for logging the footprint
+  @returns  uint8_t*            Pointer to the buffer
 */
 /******************************************************************************/
-void Ledstrip::_powerSweep() {
-    _state = _POWER_SWEEP;
-    
-    _l.logd("Start powerSweep mode");
+uint8_t* Ledstrip::_carveBuffer(size_t size, const char* name) {
+    uint8_t* buffer = _bufferArena + _bufferArenaUsed;
+    _bufferArenaUsed += (size + BUFFER_ALIGNMENT - 1) & ~(BUFFER_ALIGNMENT - 1);
+
+    _l.logi(String(name) + ": " + String(size) + " bytes", false);
     
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "PowerHandler",                                                         //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+    return buffer;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Sweep power animation thread.
+  @brief    Compiles the pixel addresses into runs, so the output stage can
+            use block copies for contiguous parts of the strip. Only the
+            scattered pixels are gathered through _ledAddresses.
 */
 /******************************************************************************/
-void Ledstrip::__powerSweep() {
-    /* Draw randomized leds */
-    float color1Portion = 0;
-
-    uint8_t fadeLength = 5;
-    
-    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        for (uint8_t j = 0; j < fadeLength; j++) {
-            color1Portion = (fadeLength-j) * 1.0 / fadeLength;
-
-            if (i + j < _highestPixelAddress) {
-                if (_isOn) {
-                    _leds[i + j] = _blendColors(_savedLeds[i + j], color1Portion, CRGB(0, 0, 0));
-                } else {
-                    _leds[i + j] = _blendColors(CRGB(0, 0, 0), color1Portion, _savedLeds[i + j]);
-                }
-            }
-        }
-        _showLeds();
-        vTaskDelay(50);
-    }
-  
-    _l.logd("End powerSweep mode");
-    
-    _state = _READY_TO_RUN;
-
-    _taskHandler = NULL;
-    vTaskDelete(_taskHandler);
+void Ledstrip::_compilePixelAddresses() {
+    _numberOfPixelRuns = compilePixelRuns(_ledAddresses, _numberLeds, _pixelRuns);
+    _l.logd("Compiled pixel addressing into " + String(_numberOfPixelRuns) + " runs");
 }
 
 /******************************************************************************/
 /*!
-  @brief    Start dual sweep power animation.
+  @brief    Returns the table of the specified heat palette. Palettes that
+            are not a heat palette use the yellow red palette.
+  @param    palette             Color palette
+  @returns  ColorTable*         Color per temperature
 */
 /******************************************************************************/
-void Ledstrip::_powerDualSweep() {
-    _state = _POWER_DUAL_SWEEP;
-    
-    _l.logd("Start powerDualSweep mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "PowerHandler",                                                         //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+const ColorTable* Ledstrip::_getHeatTable(uint8_t palette) {
+    if (palette < PALETTE_YELLOW_RED || palette >= PALETTE_YELLOW_RED + NUMBER_OF_HEAT_PALETTES) {
+        palette = PALETTE_YELLOW_RED;
+    }
+    return &HEAT_TABLES[palette - PALETTE_YELLOW_RED];
 }
 
 /******************************************************************************/
 /*!
-  @brief    Dual sweep power animation thread.
+  @brief    Calculates the color position of the gradient mode.
+  @param    steps               Steps (LEDs) of loop
+  @param    parameters          Parameters of the gradient
+  @param    colorPosition       Color position of the first LED
+  @returns  uint8_t             Color position
 */
 /******************************************************************************/
-void Ledstrip::__powerDualSweep() {
-    /* Draw randomized leds */
-    float color1Portion = 0;
-
-    uint8_t fadeLength = 5;
-    
-    for (uint16_t i = 0; i < _highestPixelAddress/2; i++) {
-        for (uint8_t j = 0; j < fadeLength; j++) {
-            color1Portion = (fadeLength-j) * 1.0 / fadeLength;
-
-            if (i + j < _highestPixelAddress/2+1) {
-                if (_isOn) {
-                    _leds[i + j] = _blendColors(_savedLeds[i + j], color1Portion, CRGB(0, 0, 0));
-                } else {
-                    _leds[i + j] = _blendColors(CRGB(0, 0, 0), color1Portion, _savedLeds[i + j]);
-                }
-            }
-        }
+uint8_t Ledstrip::_getGradientColorPosition(uint16_t step, ModeParameters &parameters, uint8_t colorPosition) {
+    uint8_t colorMultiplier = MAX_WAVE_LENGTH+1 - parameters.waveLength;
+    uint8_t range = parameters.maxColorPos - parameters.minColorPos;
+    if (range == 0) range++;
 
-        for (uint8_t j = 0; j < fadeLength; j++) {
-            color1Portion = (fadeLength-j) * 1.0 / fadeLength;
+    colorPosition = (step * colorMultiplier + colorPosition) & 255;
 
-            if (_highestPixelAddress-1 - i - j > _highestPixelAddress/2) {
-                if (_isOn) {
-                    _leds[_highestPixelAddress-1 - i - j] = _blendColors(_savedLeds[_highestPixelAddress-1 - i - j], color1Portion, CRGB(0, 0, 0));
-                } else {
-                    _leds[_highestPixelAddress-1 - i - j] = _blendColors(CRGB(0, 0, 0), color1Portion, _savedLeds[_highestPixelAddress-1 - i - j]);
-                }
-            }
-        }
-        _showLeds();
-        vTaskDelay(50);
-    }
-    
-    /* Make sure every led is fully on/off */
-    if (_isOn) {
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            _leds[i] = _savedLeds[i];
+    if (colorPosition < parameters.minColorPos) {
+        uint8_t diff = parameters.minColorPos - colorPosition;
+        colorPosition = parameters.minColorPos + (diff % (2 * range));
+        if (colorPosition > parameters.maxColorPos) {
+            colorPosition = parameters.maxColorPos - (colorPosition - parameters.maxColorPos);
         }
-    } else {
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            _leds[i] = CRGB(0, 0, 0);
+    } else if (colorPosition > parameters.maxColorPos) {
+        uint8_t diff = colorPosition - parameters.maxColorPos;
+        colorPosition = parameters.maxColorPos - (diff % (2 * range));
+        if (colorPosition < parameters.minColorPos) {
+            colorPosition = parameters.minColorPos + (parameters.minColorPos - colorPosition);
         }
     }
-    _showLeds();
-  
-    _l.logd("End powerDualSweep mode");
-    
-    _state = _READY_TO_RUN;
 
-    _taskHandler = NULL;
-    vTaskDelete(_taskHandler);
+    return colorPosition;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Start multi sweep power animation.
+  @brief    Returns the step a seekable mode is at, the number of periods
+            since the mode started.
+  @param    segment             Segment
+  @param    time                Time, in ms
+  @param    period              Time of one step in ms, 0 runs like 1
+  @returns  uint32_t            Step, 0 at the start of the mode
 */
 /******************************************************************************/
-void Ledstrip::_powerMultiSweep() {
-    _state = _POWER_MULTI_SWEEP;
-    
-    _l.logd("Start powerMultiSweep mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "PowerHandler",                                                         //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+uint32_t Ledstrip::_getModeStep(Segment &segment, uint32_t time, uint16_t period) {
+    return (time - segment.state.startTime) / max(period, (uint16_t) 1);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Multi sweep power animation thread.
+  @brief    Returns the time until the next step of a seekable mode, so the
+            steps stay on the grid of the start of the mode.
+  @param    segment             Segment
+  @param    time                Time, in ms
+  @param    period              Time of one step in ms, 0 runs like 1
+  @returns  uint16_t            Time until the next step in ms
 */
 /******************************************************************************/
-void Ledstrip::__powerMultiSweep() {
-    /* Draw randomized leds */
-    float color1Portion = 0;
-
-    uint8_t fadeLength = 5;
-    
-    for (uint16_t i = 0; i < _highestPixelAddress/2; i++) {
-        for (uint8_t j = 0; j < fadeLength; j++) {
-            color1Portion = (fadeLength-j) * 1.0 / fadeLength;
-
-            if (i + j < _highestPixelAddress/2+1) {
-                if (_isOn) {
-                    _leds[i + j] = _blendColors(_savedLeds[i + j], color1Portion, CRGB(0, 0, 0));
-                } else {
-                    _leds[i + j] = _blendColors(CRGB(0, 0, 0), color1Portion, _savedLeds[i + j]);
-                }
-            }
-        }
-
-        for (uint8_t j = 0; j < fadeLength; j++) {
-            color1Portion = (fadeLength-j) * 1.0 / fadeLength;
+uint16_t Ledstrip::_getTimeToNextStep(Segment &segment, uint32_t time, uint16_t period) {
+    period = max(period, (uint16_t) 1);
+    return period - (time - segment.state.startTime) % period;
+}
 
-            if (_highestPixelAddress-1 - i - j > _highestPixelAddress/2) {
-                if (_isOn) {
-                    _leds[_highestPixelAddress-1 - i - j] = _blendColors(_savedLeds[_highestPixelAddress-1 - i - j], color1Portion, CRGB(0, 0, 0));
-                } else {
-                    _leds[_highestPixelAddress-1 - i - j] = _blendColors(CRGB(0, 0, 0), color1Portion, _savedLeds[_highestPixelAddress-1 - i - j]);
-                }
-            }
-        }
-        _showLeds();
-        vTaskDelay(50);
-    }
-    
-    /* Make sure every led is fully on/off */
-    if (_isOn) {
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            _leds[i] = _savedLeds[i];
-        }
-    } else {
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            _leds[i] = CRGB(0, 0, 0);
-        }
+/******************************************************************************/
+/*!
+  @brief    Returns the position of a value that moves one position per step
+            from low to high and back.
+  @param    steps               Steps, the position is low at 0
+  @param    low                 Lowest position
+  @param    high                Highest position
+  @returns  uint8_t             Position
+*/
+/******************************************************************************/
+uint8_t Ledstrip::_getBouncePosition(uint32_t steps, uint8_t low, uint8_t high) {
+    if (high <= low) {
+        return low;
     }
-    _showLeds();
-  
-    _l.logd("End powerMultiSweep mode");
-    
-    _state = _READY_TO_RUN;
 
-    _taskHandler = NULL;
-    vTaskDelete(_taskHandler);
-}
-#pragma endregion
+    uint16_t range = high - low;
+    uint16_t phase = steps % (2 * range);
 
+    return low + (phase <= range ? phase : 2 * range - phase);
+}
 
-#pragma region Utilities
 /******************************************************************************/
 /*!
-  @brief    Rotate LEDs to the left.
-  @param    steps               Steps (LEDs) to rotate
+  @brief    Returns a palette of the color waves mode. Random palettes are
+            generated from the seed of the segment and their number, so the
+            palette at any time is known without the previous ones.
+  @param    segment             Segment
+  @param    number              Number of the palette, 0 is the rainbow
+  @returns  CRGBPalette16       Palette
 */
 /******************************************************************************/
-void Ledstrip::_rotateLeft(uint8_t steps) {
-    for (uint8_t step = 0; step < steps; step++) {
-        CRGB temp = _leds[0];
-        for (uint16_t i = 0; i < _highestPixelAddress-1; i++){
-            _leds[i] = _leds[i + 1];
-        }
+CRGBPalette16 Ledstrip::_getColorWavesPalette(Segment &segment, uint32_t number) {
+    if (number == 0) {
+        return RainbowColors_p;
+    }
+
+    Random random(segment.state.seed ^ (number * 0x9E3779B9));                  //Golden ratio, spreads the seeds of successive palettes
+    CHSV colors[4];
 
-        _leds[_highestPixelAddress-1] = temp;
+    for (uint8_t i = 0; i < 4; i++) {
+        colors[i].hue = random.next(256);
+        colors[i].saturation = i == 2 ? 192 : 255;
+        colors[i].value = random.next(128, 255);
     }
+
+    return CRGBPalette16(colors[0], colors[1], colors[2], colors[3]);
 }
+#pragma endregion
 
+#pragma region Frame pipeline
 /******************************************************************************/
 /*!
-  @brief    Rotate LEDs to the right.
-  @param    steps               Steps (LEDs) to rotate
+  @brief    Hands the current LEDs over to the output task. The frame is
+            composited into the back frame buffer, after which the buffers are
+            swapped as soon as the output task released the front frame. The
+            calling task can calculate the next frame while the output task is
+            still sending this one to the strip. Frames that are identical to
+            the previous frame are not sent again. If the front frame is not
+            released in time, the frame is dropped instead of swapped, so the
+            frame the output task reads is never written.
+  @param    force               If true, the frame is sent even if it did not
+                                change
 */
 /******************************************************************************/
-void Ledstrip::_rotateRight(uint8_t steps) {
-    CRGB temp[steps];                                                           //Temporary array
-    
-    /* Copying last d elements in the temporary array */
-    for (uint16_t i = _highestPixelAddress - steps; i < _highestPixelAddress; i++) {
-        temp[i - (_highestPixelAddress - steps)] = _leds[i];
-    }
+void Ledstrip::_presentFrame(bool force) {
+    uint8_t backFrame = !_frontFrame;
+    size_t frameSize = _highestPixelAddress * sizeof(CRGB);
+    _compositeFrame(_frameBuffers[backFrame]);
 
-    /* 
-     * Shift first (n-d) elements to the right by 
-     * d places in the specified array
-     */
-    for (int16_t i = _highestPixelAddress - steps - 1; i >= 0; i--) {
-        _leds[i + steps] = _leds[i];
+    /* Skip frames that are identical to the last presented frame */
+    if (!force && !_forceNextFrame && memcmp(_frameBuffers[backFrame], _frameBuffers[_frontFrame], frameSize) == 0) {
+        _framesSkipped++;
+        return;
     }
-    
-    /* 
-     * Place the elements of the temporary array
-     * in the first d places of the specified array
-     */
-    for (uint8_t i = 0; i < steps; i++) {
-        _leds[i] = temp[i];
+
+    /* Fence, wait until the output task is done with the front frame */
+    if (xSemaphoreTake(_frameFence, pdMS_TO_TICKS(FRAME_FENCE_TIMEOUT)) != pdTRUE) {
+        _l.logw("Output task did not release frame in time");
+        _forceNextFrame = true;                                                 //Not swapped, the next frame is rendered into the same back frame and sent
+        return;
     }
+
+    _forceNextFrame = false;
+    _frontFrame = backFrame;
+    xTaskNotify(_outputTaskHandler, OUTPUT_NOTIFY_FRAME, eSetBits);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Generates a random CRGB type color.
-  @param    saturationPerc      The saturation percentage (0-100)
-  @returns  CRGB                The color
+  @brief    Composites the enabled layers over _leds into the specified frame,
+            in one pass. _leds itself is not changed, so the segments keep
+            their state under the layers.
+  @param    frame               Frame to write, size: _highestPixelAddress
 */
 /******************************************************************************/
-CRGB Ledstrip::_randomColor(uint8_t saturationPerc) {
-    uint8_t r = random(0, 255);
-    uint8_t g = random(0, 255);
-    uint8_t b = random(0, 255);
-    uint16_t limit = (uint16_t) 765 - 765 * saturationPerc / 100;               //Calculate limit (for saturation)
-  
-    if (r + g + b > limit) {                                                    //If color exceeds limit, turn one channel 0
-        uint8_t randomRGB = random(0, 2);
-        if (randomRGB == 0) {
-            r = 0;
+void Ledstrip::_compositeFrame(CRGB frame[]) {
+    Layer* layers[NUMBER_OF_LAYERS];
+    uint8_t numberOfLayers = 0;
+    const CRGB* source = _leds;
+
+    for (uint8_t i = 0; i < _numberOfSegments; i++) {
+        if (_segments[i].isTransitioning || _segments[i].state.rotation != 0) {
+            _resolveSegments(frame);                                            //Layers are composited over the visible segments
+            source = frame;
+            break;
         }
-        if (randomRGB == 1) {
-            g = 0;
+    }
+
+    for (uint8_t i = 0; i < NUMBER_OF_LAYERS; i++) {
+        if (_layers[i].isEnabled) {
+            layers[numberOfLayers] = &_layers[i];
+            numberOfLayers++;
         }
-        if (randomRGB == 2) {
-            b = 0;
+    }
+
+    if (numberOfLayers == 0) {
+        if (source != frame) {
+            memcpy(frame, _leds, _highestPixelAddress * sizeof(CRGB));
+        }
+        return;
+    }
+
+    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
+        CRGB color = source[i];
+
+        for (uint8_t j = 0; j < numberOfLayers; j++) {
+            Layer &layer = *layers[j];
+
+            switch (layer.blendOperation) {
+                case BLEND_OVER:
+                    color = blend(color, layer.color, layer.opacity);
+                    break;
+                case BLEND_MULTIPLY:
+                    color = blend(color, CRGB(scale8(color.r, layer.color.r), scale8(color.g, layer.color.g), scale8(color.b, layer.color.b)), layer.opacity);
+                    break;
+                case BLEND_ADD:
+                    color += CRGB(scale8(layer.color.r, layer.opacity), scale8(layer.color.g, layer.opacity), scale8(layer.color.b, layer.opacity));
+                    break;
+                case BLEND_MASK:
+                    color.nscale8(layer.alpha != NULL ? layer.alpha[i] : layer.opacity);
+                    break;
+                default:
+                    break;
+            }
         }
+
+        frame[i] = color;
     }
-    return CRGB (r, g, b);
 }
 
 /******************************************************************************/
 /*!
-  @brief    Set mode based on number.
-  @param    mode                Mode to switch to
+  @brief    Writes the segments into the specified frame as they are visible.
+            The rotation offset of a segment is applied while copying, as at
+            most a few contiguous runs, and segments that are in a transition
+            are crossfaded from their outgoing mode.
+  @param    frame               Frame to write, size: _highestPixelAddress
 */
 /******************************************************************************/
-CRGB Ledstrip::_blendColors(CRGB color1, float color1Portion, CRGB color2) {
-    float portion2 = 1.0 - color1Portion;
-    uint8_t r = round(color1[0] * color1Portion * 1.0 + color2[0] * portion2 * 1.0);
-    uint8_t g = round(color1[1] * color1Portion * 1.0 + color2[1] * portion2 * 1.0);
-    uint8_t b = round(color1[2] * color1Portion * 1.0 + color2[2] * portion2 * 1.0);
-    
-    return CRGB (r, g, b);
-}
+void Ledstrip::_resolveSegments(CRGB frame[]) {
+    for (uint8_t i = 0; i < _numberOfSegments; i++) {
+        Segment &segment = _segments[i];
+        Segment &outgoing = *segment.outgoing;
+        CRGB* output = &frame[segment.start];
+        uint16_t length = segment.length;
+        uint16_t run;
 
-/******************************************************************************/
-/*!
-  @brief    For calculating parallel strip and showing
-*/
-/******************************************************************************/
-void Ledstrip::_showLeds() {
-    if (_isOn || _state < NUM_POWER_ANIMATIONS) {
-        if (_driver == _SK6812) {
-            for (uint8_t i = 0; i < _numberLeds; i++) {
-                _crgbwTempLeds[i] = CRGBtoCRGBW(_leds[_ledAddresses[i]]);
-            }
-        } else {
-            for (uint8_t i = 0; i < _numberLeds; i++) {
-                _tempLeds[i] = _leds[_ledAddresses[i]];
+        /* Visible LED j is leds[(j + rotation) % length], a run ends where one of the canvases wraps */
+        for (uint16_t j = 0; j < length; j += run) {
+            uint16_t to = (j + segment.state.rotation) % length;
+            run = length - max(j, to);
+
+            if (!segment.isTransitioning) {
+                memcpy(&output[j], &segment.leds[to], run * sizeof(CRGB));
+                continue;
             }
+
+            uint16_t from = (j + outgoing.state.rotation) % length;
+            run = min(run, (uint16_t) (length - from));
+            _fadeColors(&output[j], &outgoing.leds[from], &segment.leds[to], segment.transitionProgress, run);
         }
-        FastLED.show();
-    } else {
-        _l.logd("Leds not updated because the strip is off");
     }
 }
 
 /******************************************************************************/
 /*!
-  @brief    Used to pick colors for rainbow method.
-  @param    position            Position on wheel (0-255)
-  @returns  CRGB color          The color
+  @brief    Copies the specified frame into the output buffer of the driver,
+            applying the pixel addressing and color correction.
+  @param    frame               Frame to copy
 */
 /******************************************************************************/
-CRGB Ledstrip::_colorWheel(uint8_t position) {
-    if (position < 85) {
-        return CRGB (position * 3, 255 - position * 3, 0);
-    } else if (position < 170) {
-        position -= 85;
-        return CRGB (255 - position * 3, 0, position * 3);
+void Ledstrip::_remapFrame(CRGB frame[]) {
+    if (_driver == _SK6812) {
+        _remapRuns(_crgbwTempLeds, frame);
     } else {
-        position -= 170;
-        return CRGB (0, position * 3, 255 - position * 3);
+        _remapRuns(_tempLeds, frame);
     }
 }
 
 /******************************************************************************/
 /*!
-  @brief    Function to start the different threads.
+  @brief    Copies the specified frame into the specified output buffer, run
+            by run. Color correction and dithering are done in the same pass,
+            so every output pixel is touched once. With identity correction
+            tables, copy runs are block copies.
+  @param    output              Output buffer (CRGB or CRGBW)
+  @param    frame               Frame to copy
 */
 /******************************************************************************/
-void Ledstrip::__startModeTask(void* parameter) {
-    Ledstrip* ledRef = static_cast<Ledstrip *>(parameter);
-
-    switch (ledRef->_state) {
-        case _POWER_FADE:
-            ledRef->__powerFade();
-            break;
-        case _POWER_DISSOLVE:
-            ledRef->__powerDissolve();
-            break;
-        case _POWER_SWEEP:
-            ledRef->__powerSweep();
-            break;
-        case _POWER_DUAL_SWEEP:
-            ledRef->__powerDualSweep();
-            break;
-        case _POWER_MULTI_SWEEP:
-            ledRef->__powerMultiSweep();
-            break;
-
-        case _FADE_BRIGHTNESS:
-            ledRef->__fadeBrightness();
-            break;
-        case _FADE_TO_SINGLE_COLOR:
-            ledRef->__fadeToColor();
-            break;
-        case _FADE_TO_MULTIPLE_COLOR:
-            ledRef->__fadeToMultipleColors();
-            break;
-        default:
-            break;
+template <typename T>
+void Ledstrip::_remapRuns(T output[], CRGB frame[]) {
+    if (!_isColorCorrected) {
+        remapRuns<false, false>(output, frame, _pixelRuns, _numberOfPixelRuns, _ledAddresses, *_colorLut, _ditherErrors);
+        _ditherResidue = false;                                                 //Identity tables have no fractions
+        return;
     }
 
-    if (ledRef->_state == _LOOPING) {
-        switch (ledRef->_mode) {
-            case MODE_FADE:
-                ledRef->__fade();
-                break;
-            case MODE_GRADIENT:
-                ledRef->__gradient();
-                break;
-            case MODE_BLINK:
-                ledRef->__blink();
-                break;
-            case MODE_SCAN:
-                ledRef->__scan();
-                break;
-            case MODE_THEATER:
-                ledRef->__theater();
-                break;
-            case MODE_SINE:
-                ledRef->__sine();
-                break;
-            case MODE_BOUNCING_BALLS:
-                ledRef->__bouncingBalls();
-                break;
-            case MODE_DISSOLVE:
-                ledRef->__dissolve();
-                break;
-            case MODE_SPARKLE:
-                ledRef->__sparkle();
-                break;
-            case MODE_FIREWORKS:
-                ledRef->__fireworks();
-                break;
-            case MODE_FIRE:
-                ledRef->__fire();
-                break;
-            case MODE_SWEEP:
-                ledRef->__sweep();
-                break;
-            case MODE_COLOR_TWINKELS:
-                ledRef->__colorTwinkels();
-                break;
-            case MODE_METEOR_RAIN:
-                ledRef->__meteorRain();
-                break;
-            case MODE_COLOR_WAVES:
-                ledRef->__colorWaves();
-                break;
-            case MODE_TEMPLATE_1:
-                ledRef->__modeTemplate1();
-                break;
-            case MODE_TEMPLATE_2:
-                ledRef->__modeTemplate2();
-                break;
-            case MODE_TEMPLATE_3:
-                ledRef->__modeTemplate3();
-                break;
-            case MODE_TEMPLATE_4:
-                ledRef->__modeTemplate4();
-                break;
-            case MODE_TEMPLATE_5:
-                ledRef->__modeTemplate5();
-                break;
-            case MODE_TEMPLATE_6:
-                ledRef->__modeTemplate6();
-                break;
-            case MODE_TEMPLATE_7:
-                ledRef->__modeTemplate7();
-                break;
-            case MODE_TEMPLATE_8:
-                ledRef->__modeTemplate8();
-                break;
-            case MODE_TEMPLATE_9:
-                ledRef->__modeTemplate9();
-                break;
-            case MODE_TEMPLATE_10:
-                ledRef->__modeTemplate10();
-                break;
-
-            case SYSTEM_MODE_PULSES:
-                ledRef->__systemPulses();
-                break;
-            case SYSTEM_MODE_ALARM:
-                ledRef->__systemAlarm();
-                break;
-            default:
-                break;
-        }
-    }
+    _ditherResidue = remapRuns<true, TEMPORAL_DITHERING>(output, frame, _pixelRuns, _numberOfPixelRuns, _ledAddresses, *_colorLut, _ditherErrors) != 0;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Wait until strip is finished critical system tasks.
+  @brief    Copies the specified frame into the snapshot. Readers retry when
+            the sequence changed during their copy, so the output task never
+            waits for them.
+  @param    frame               Frame to publish
 */
 /******************************************************************************/
-void Ledstrip::_waitUntilIdle() {
-    if (_state == _LOOPING) {
-        vTaskDelete(_taskHandler);
-        _taskHandler = NULL;
-        _l.logd("Ended looping mode");
-        
-        vTaskDelay(10);                                                          //Otherwise program gets stuck
-        _state = _READY_TO_RUN;
-    }
-    
-    while (_state != _READY_TO_RUN && _state != _WAIT_FOR_DOOR_CLOSED) {
-        vTaskDelay(1);
-    }
+void Ledstrip::_publishSnapshot(CRGB frame[]) {
+    _snapshotSequence++;                                                        //Odd, write in progress
+    __sync_synchronize();
+    memcpy(_snapshot, frame, _highestPixelAddress * sizeof(CRGB));
+    __sync_synchronize();
+    _snapshotSequence++;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Saves the current led states of the strip.
+  @brief    Function to start the output thread.
 */
 /******************************************************************************/
-void Ledstrip::_saveLeds() {
-    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        _savedLeds[i] = _leds[i];
-    }
+void Ledstrip::__startOutputTask(void* parameter) {
+    Ledstrip* ledRef = static_cast<Ledstrip *>(parameter);
+    ledRef->__output();
 }
 
 /******************************************************************************/
 /*!
-  @brief    Saves the current led states of the strip.
+  @brief    Task. Waits for presented frames and sends them to the strip.
+            With temporal dithering, a static frame is sent again while it
+            has fractions left, up to DITHER_REFRESH_FRAMES times, and while
+            the brightness ramps. The fence is
+            held while the front frame is read, so it cannot be swapped
+            during a refresh.
 */
 /******************************************************************************/
-void Ledstrip::_loadPixelAddresses() {
-    _nvMemory.begin(NV_MEM_CONFIG);
-    String addressString = _nvMemory.getString("ledAddresses");
-    _nvMemory.end();
-    
-    if (addressString == "") {
-        for (uint16_t i = 0; i < _numberLeds; i++) {
-            _ledAddresses[i] = i;
+void Ledstrip::__output() {
+    bool isBrightnessFading = false;
+    uint8_t ditherRefreshes = 0;                                                //Times the last frame is sent again for its fractions
+
+    while (1) {
+        /* While the last frame has dither fractions or the brightness ramps, it is refreshed at the default frame rate */
+        bool isDithering = _ditherResidue && ditherRefreshes < DITHER_REFRESH_FRAMES;
+        TickType_t timeout = isDithering || isBrightnessFading ? pdMS_TO_TICKS(1000 / DEFAULT_FRAME_RATE) : portMAX_DELAY;
+        uint32_t notification = 0;
+
+        xTaskNotifyWait(0, UINT32_MAX, &notification, timeout);
+        bool isNewFrame = (notification & OUTPUT_NOTIFY_FRAME) != 0;
+        
+        if (!isNewFrame && xSemaphoreTake(_frameFence, 0) != pdTRUE) {
+            continue;                                                           //Frames are being swapped, a new frame is coming
+        }
+
+        isBrightnessFading = _updateOutputBrightness();
+        ditherRefreshes = isNewFrame || isBrightnessFading ? 0 : ditherRefreshes + 1;
+
+        int64_t startTime = esp_timer_get_time();
+        _remapFrame(_frameBuffers[_frontFrame]);
+        uint32_t remapTime = esp_timer_get_time() - startTime;
+
+        if (isNewFrame) {
+            _publishSnapshot(_frameBuffers[_frontFrame]);
         }
-        _highestPixelAddress = _numberLeds;
-        return;
-    }
         
-    JsonDocument jsonParser;
-    deserializeJson(jsonParser, addressString);  //Convert JSON string to object
-    
-    _highestPixelAddress = 0;
-    for (uint16_t i = 0; i < _numberLeds; i++) {
-        _ledAddresses[i] = (uint16_t) jsonParser[i];
-        if (_highestPixelAddress < _ledAddresses[i]) {
-            _highestPixelAddress = _ledAddresses[i];
+        xSemaphoreGive(_frameFence);                                            //Front frame is consumed, back frame can be swapped in
+
+        if (remapTime > _maxRemapTime) {
+            _maxRemapTime = remapTime;
         }
+
+        _outputDriver->show(_outputBuffer, _outputBufferSize);
+        _framesSent++;
     }
-    _highestPixelAddress += 1;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Calculates the heat color for the specified temperature and
-            pallete.
-  @param    temperature         Color temperature
-  @param    palette             Color palette
-  @returns  CRGB color          The color
+  @brief    Sets the brightness the output task ramps to. The brightness is
+            applied by the output stage, so it does not change the frames of
+            the modes and no frames are rendered for it.
+  @param    brightness          Brightness to ramp to
 */
 /******************************************************************************/
-CRGB Ledstrip::_getHeatColor(uint8_t temperature, uint8_t palette) {
-    /* Scale 'heat' down from 0-255 to 0-191 */
-    uint8_t t192 = round((temperature/255.0) * 191);
-   
-    /* Calculate ramp up */
-    uint8_t heatramp = t192 & 0x3F;                                             //0..63
-    heatramp <<= 2;                                                             //scale up to 0..252
-
-    if (palette == PALETTE_YELLOW_RED) {
-        if (t192 > 0x80) {               
-            return CRGB(255, 255, heatramp);                                    //Hottest
-        } else if (t192 > 0x40) {          
-            return CRGB(255, heatramp, 0);                                      //Middle
-        }
-        return CRGB(heatramp, 0, 0);                                            //Coolest
-    }
-
-    if (palette == PALETTE_PURPLE_BLUE) {
-        if (t192 > 0x80) {
-            return CRGB(255, heatramp, 255);                                    //Hottest
-        } else if (t192 > 0x40) {
-            return CRGB(heatramp, 0, 255);                                      //Middle
-        }
-        return CRGB(0, 0, heatramp);                                            //Coolest
-    }
-
-    if (palette == PALETTE_GREEN_BLUE) {
-        if (t192 > 0x80) {
-            return CRGB(heatramp, 255, 255);                                    //Hottest
-        } else if (t192 > 0x40) {
-            return CRGB(0, heatramp, 255);                                      //Middle
-        }
-        return CRGB(0, 0, heatramp);                                            //Coolest
-    }
+void Ledstrip::_setTargetBrightness(uint8_t brightness) {
+    _brightness = brightness;
 
-    if (palette == PALETTE_BLUE_GREEN) {
-        if (t192 > 0x80) {
-            return CRGB(heatramp, 255, 255);                                    //Hottest
-        } else if (t192 > 0x40) {
-            return CRGB(0, 255, heatramp);                                      //Middle
-        }
-        return CRGB(0, heatramp, 0);                                            //Coolest
+    if (_outputTaskHandler != NULL) {
+        xTaskNotify(_outputTaskHandler, OUTPUT_NOTIFY_BRIGHTNESS, eSetBits);
     }
 }
 
 /******************************************************************************/
 /*!
-  @brief    Calculates the color position of the gradient mode.
-  @param    steps               Steps (LEDs) of loop
-  @returns  uint8_t             Color position
+  @brief    Moves the brightness of the driver towards the target brightness,
+            a linear ramp over BRIGHTNESS_FADE_TIME from the brightness at
+            the moment the target changed. Called by the output task for
+            every frame it sends.
+  @returns  bool                True while the brightness is not at the target
 */
 /******************************************************************************/
-uint8_t Ledstrip::_getGradientColorPosition(uint8_t step) {
-    uint8_t colorMultiplier = MAX_WAVE_LENGTH+1 - _modeParameters[MODE_GRADIENT].waveLength;
-    uint8_t range = _modeParameters[MODE_GRADIENT].maxColorPos - _modeParameters[MODE_GRADIENT].minColorPos;
-    if (range == 0) range++;
-
-    uint8_t colorPosition = (step * colorMultiplier + _modeParameters[MODE_GRADIENT].colorPosition) & 255;
+bool Ledstrip::_updateOutputBrightness() {
+    uint8_t target = _brightness;
+    uint32_t now = pdTICKS_TO_MS(xTaskGetTickCount());
 
-    if (colorPosition < _modeParameters[MODE_GRADIENT].minColorPos) {
-        uint8_t diff = _modeParameters[MODE_GRADIENT].minColorPos - colorPosition;
-        colorPosition = _modeParameters[MODE_GRADIENT].minColorPos + (diff % (2 * range));
-        if (colorPosition > _modeParameters[MODE_GRADIENT].maxColorPos) {
-            colorPosition = _modeParameters[MODE_GRADIENT].maxColorPos - (colorPosition - _modeParameters[MODE_GRADIENT].maxColorPos);
-        }
-    } else if (colorPosition > _modeParameters[MODE_GRADIENT].maxColorPos) {
-        uint8_t diff = colorPosition - _modeParameters[MODE_GRADIENT].maxColorPos;
-        colorPosition = _modeParameters[MODE_GRADIENT].maxColorPos - (diff % (2 * range));
-        if (colorPosition < _modeParameters[MODE_GRADIENT].minColorPos) {
-            colorPosition = _modeParameters[MODE_GRADIENT].minColorPos + (_modeParameters[MODE_GRADIENT].minColorPos - colorPosition);
-        }
+    if (target != _brightnessFadeTo) {
+        _brightnessFadeFrom = _outputBrightness;                                //A new target continues from the current brightness
+        _brightnessFadeTo = target;
+        _brightnessFadeStartTime = now;
     }
+
+    uint16_t progress = _getFadeProgress(now - _brightnessFadeStartTime, BRIGHTNESS_FADE_TIME);
+    _outputBrightness = _brightnessFadeFrom + (((int32_t) _brightnessFadeTo - _brightnessFadeFrom) * progress >> 8);
+    _outputDriver->setBrightness(_outputBrightness);
+
+    return progress != FADE_PROGRESS_END;
 }
 #pragma endregion
 
@@ -2911,8 +3332,20 @@ uint8_t Ledstrip::getDriver() {
 
 /******************************************************************************/
 /*!
-  @brief    Returns whether the ledstrip is available.
-  @returns  bool                True if strip is available for commands
+  @brief    Returns the number of outputs (data pins) of the ledstrip.
+  @returns  uint8_t             Number of outputs
+*/
+/******************************************************************************/
+uint8_t Ledstrip::getNumberOfOutputs() {
+    return _numberOfOutputs;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns whether the ledstrip is available. Commands do not have
+            to wait for it, they preempt a running crossfade or power
+            animation at the next frame.
+  @returns  bool                False while a crossfade or power animation runs
 */
 /******************************************************************************/
 bool Ledstrip::isAvailable() {
@@ -2946,25 +3379,69 @@ String Ledstrip::getPixelAddressing() {
 
 /******************************************************************************/
 /*!
-  @brief    Returns a list of pixel values. 0 when is off 1 when is on.
-  @returns  String              JSON string of pixel values
+  @brief    Returns the last sent frame as hex string, 6 characters (RRGGBB)
+            per pixel.
+  @returns  String              Hex string of pixel values
 */
 /******************************************************************************/
 String Ledstrip::getPixels() {
-    String jsonString = "[";
+    static const char hexDigits[] = "0123456789ABCDEF";
     
-    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        if (_leds[i] == CRGB (0,0,0)) {
-            jsonString += "1";
-        } else {
-            jsonString += "0";
+    if (_snapshot == NULL) {
+        return "";
+    }
+
+    CRGB* pixels = new CRGB[_highestPixelAddress];
+    uint16_t numberOfPixels = getPixels(pixels, _highestPixelAddress);
+
+    String hexString;
+    hexString.reserve(numberOfPixels * 6);
+
+    for (uint16_t i = 0; i < numberOfPixels; i++) {
+        char hex[7];
+        for (uint8_t c = 0; c < 3; c++) {
+            hex[c * 2] = hexDigits[pixels[i].raw[c] >> 4];
+            hex[c * 2 + 1] = hexDigits[pixels[i].raw[c] & 0x0F];
         }
+        hex[6] = '\0';
+        hexString += hex;
+    }
+
+    delete[] pixels;
+    return hexString;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Copies the last sent frame. The copy is consistent, it is retried
+            when the output task published a frame during the copy.
+  @param    pixels              Buffer for the pixels
+  @param    size                Size of the buffer, in pixels
+  @returns  size_t              Number of copied pixels
+*/
+/******************************************************************************/
+size_t Ledstrip::getPixels(CRGB pixels[], uint16_t size) {
+    if (_snapshot == NULL) {
+        return 0;
+    }
+
+    uint16_t numberOfPixels = min(size, _highestPixelAddress);
+    uint32_t sequence;
+
+    while (1) {
+        sequence = _snapshotSequence;
+        __sync_synchronize();
+        
+        if ((sequence & 1) == 0) {
+            memcpy(pixels, _snapshot, numberOfPixels * sizeof(CRGB));
+            __sync_synchronize();
 
-        if (i < _highestPixelAddress-1) {
-            jsonString += ", ";
+            if (sequence == _snapshotSequence) {
+                return numberOfPixels;
+            }
         }
+        vTaskDelay(1);                                                          //Frame is being published
     }
-    jsonString += "]";
 }
 
 /******************************************************************************/
@@ -2979,12 +3456,50 @@ bool Ledstrip::getPower() {
 
 /******************************************************************************/
 /*!
-  @brief    Returns the mode of the ledstrip.
+  @brief    Returns the mode of the ledstrip, the mode of the first segment.
   @returns  uint8_t             Mode ID
 */
 /******************************************************************************/
 uint8_t Ledstrip::getMode() {
-    return _mode;
+    return _segments[0].mode;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns the mode of the specified segment.
+  @param    segment             Segment index
+  @returns  uint8_t             Mode ID
+*/
+/******************************************************************************/
+uint8_t Ledstrip::getSegmentMode(uint8_t segment) {
+    if (segment >= _numberOfSegments) {
+        return _segments[0].mode;
+    }
+    return _segments[segment].mode;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns the number of segments.
+  @returns  uint8_t             Number of segments
+*/
+/******************************************************************************/
+uint8_t Ledstrip::getNumberOfSegments() {
+    return _numberOfSegments;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns the segments configuration.
+  @returns  String              JSON array with segment lengths
+*/
+/******************************************************************************/
+String Ledstrip::getSegments() {
+    _nvMemory.begin(NV_MEM_CONFIG);
+    String segments = _nvMemory.getString("segments", "[]");
+    _nvMemory.end();
+
+    return segments;
 }
 
 /******************************************************************************/
@@ -3006,237 +3521,86 @@ uint8_t Ledstrip::getPowerAnimation() {
 uint8_t Ledstrip::getBrightness() {
     return _brightness;
 }
-#pragma endregion
 
-#pragma region Setters
 /******************************************************************************/
 /*!
-  @brief    Sets the brightness of the strip.
-  @param    brightness          Brightness to set
+  @brief    Returns the number of frames sent to the strip since boot.
+  @returns  uint32_t            Number of sent frames
 */
 /******************************************************************************/
-void Ledstrip::setBrightness(uint8_t brightness) {
-    _brightness = brightness;
-    _fadeBrightness();
+uint32_t Ledstrip::getFramesSent() {
+    return _framesSent;
 }
-#pragma endregion
 
-#pragma region Faders
 /******************************************************************************/
 /*!
-  @brief    Fade to the specified brightness.
+  @brief    Returns the number of frames that were not sent to the strip,
+            because they were identical to the previous frame.
+  @returns  uint32_t            Number of skipped frames
 */
 /******************************************************************************/
-void Ledstrip::_fadeBrightness() {
-    if (_brightness == FastLED.getBrightness()) {
-        return;
-    }
-
-    _waitUntilIdle();
-        
-    _state = _FADE_BRIGHTNESS;
-    
-    _l.logd("Start fadeBrightness mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "FadeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+uint32_t Ledstrip::getFramesSkipped() {
+    return _framesSkipped;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Fade to the specified brightness.
+  @brief    Returns the number of missed frame deadlines since boot.
+  @returns  uint32_t            Number of missed deadlines
 */
 /******************************************************************************/
-void Ledstrip::__fadeBrightness() {
-    uint8_t currBrightness = FastLED.getBrightness();
-    int8_t dir = 0;
-
-    /* Calculate if current brightness is greater or smaller than the specified brightness */
-    if (currBrightness < _brightness) {
-        dir = 1;
-    } else if (currBrightness > _brightness) {
-        dir = -1;
-    }
-
-    while (currBrightness != _brightness) {
-        currBrightness += dir;
-        FastLED.setBrightness(currBrightness);
-        FastLED.show();
-
-        if (currBrightness == 0 || currBrightness == MAX_BRIGHTNESS) {
-            break;
-        }
-        vTaskDelay(BRIGHTNESS_DELAY);
-    }
-
-    _l.logd("End fadeBrightness mode");
-    _state = _READY_TO_RUN;
-
-    _taskHandler = NULL;
-    vTaskDelete(_taskHandler);
+uint32_t Ledstrip::getMissedFrameDeadlines() {
+    return _missedFrameDeadlines;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Fade from multiple colors to one single color.
+  @brief    Returns the smallest time left before a frame deadline since the
+            current animation started. 0 if a deadline was missed.
+  @returns  uint16_t            Frame headroom, in ms
 */
 /******************************************************************************/
-void Ledstrip::_fadeToColor() {
-    _waitUntilIdle();
-
-    _state = _FADE_TO_SINGLE_COLOR;
-    
-    _l.logd("Start fadeToColor mode");
-        
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "FadeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+uint16_t Ledstrip::getFrameHeadroom() {
+    return _frameHeadroom;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Fade from multiple colors to one single color.
+  @brief    Returns the longest time the output stage took to remap, correct
+            and dither a frame.
+  @returns  uint32_t            Max remap time, in us
 */
 /******************************************************************************/
-void Ledstrip::__fadeToColor() {
-    int8_t directions[_highestPixelAddress][3] = {0};                           //For colorshifting, rgb
-    uint16_t numDone = 0;
-    
-    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        for (uint8_t colorChan = 0; colorChan < 3; colorChan++) {               //Set directions for slowly shifting to right number
-            if (_fullColor[colorChan] < _leds[i][colorChan]) {
-                directions[i][colorChan] = -1;
-            } else if (_fullColor[colorChan] > _leds[i][colorChan]) {
-                directions[i][colorChan] = 1;
-            }
-        }
-    }
-    
-    while (numDone < _highestPixelAddress) {
-        numDone = 0;
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            if (_fullColor[0] == _leds[i][0] && _fullColor[1] == _leds[i][1] && _fullColor[2] == _leds[i][2]) {
-                numDone++;
-            }
-             
-            /* If color is not the specified color, shift rgb numbers towards color */
-            for (uint8_t colorChan = 0; colorChan < 3; colorChan++) {
-                if (_fullColor[colorChan] != _leds[i][colorChan]) {
-                    _leds[i][colorChan] += directions[i][colorChan];
-                }
-            }
-        }
-        _showLeds();
-        vTaskDelay(COLOR_DELAY);
-    }
-
-    _l.logd("End fadeToColor mode");
-    
-    _state = _READY_TO_RUN;
-
-    _taskHandler = NULL;
-    vTaskDelete(_taskHandler);
+uint32_t Ledstrip::getMaxRemapTime() {
+    return _maxRemapTime;
 }
 
 /******************************************************************************/
 /*!
-  @brief    Fade from one single color to multiple colors.
-  @param    desiredColorPos         Color position to fade to
-  @param    fadeToGradientColors    When true, the gradient wavelength etc. is
-                                    used
+  @brief    Returns the longest time from a mode change until the first frame
+            of the mode was presented.
+  @returns  uint32_t            Max mode switch time, in us
 */
 /******************************************************************************/
-void Ledstrip::_fadeToMultipleColors(uint8_t desiredColorPos, bool fadeToGradientColors) {
-    _waitUntilIdle();
-
-    _desiredColorPos = desiredColorPos;
-    _fadeToGradientColors = desiredColorPos;
-
-    _state = _FADE_TO_MULTIPLE_COLOR;
-    
-    _l.logd("Start fadeToMultipleColors mode");
-    
-    xTaskCreatePinnedToCore(
-        Ledstrip::__startModeTask,                                              //Task function
-        "FadeHandler",                                                          //Task name
-        8000,                                                                   //Stack size in bytes
-        this,                                                                   //Task parameter
-        PRIORITY,                                                               //Task priority
-        &_taskHandler,                                                          //Task handler
-        CORE_NUMBER                                                             //Task CPU core
-    );
+uint32_t Ledstrip::getMaxModeSwitchTime() {
+    return _maxModeSwitchTime;
 }
+#pragma endregion
 
+#pragma region Setters
 /******************************************************************************/
 /*!
-  @brief    Fade from one single color to multiple colors.
+  @brief    Sets the brightness of the strip. The output stage ramps to it,
+            while the modes keep running.
+  @param    brightness          Brightness to set
 */
 /******************************************************************************/
-void Ledstrip::__fadeToMultipleColors() {
-    CRGB desiredColors[_highestPixelAddress];
-    int8_t directions[_highestPixelAddress][3] = {0};                           //For colorshifting, rgb
-    uint16_t numDone = 0;
-
-    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        if (_fadeToGradientColors) {
-            uint8_t colorPosition = _getGradientColorPosition(i);
-            desiredColors[i] = _colorWheel(colorPosition);
-            desiredColors[_highestPixelAddress-1 - i] = _colorWheel(colorPosition);
-            continue;
-        }
-
-        desiredColors[i] = _colorWheel((i + _desiredColorPos) & 255);
-        desiredColors[_highestPixelAddress-1 - i] = _colorWheel((i + _desiredColorPos) & 255);
-    }
-        
-    for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-        for (uint8_t colorChan = 0; colorChan < 3; colorChan++) {               //Set directions for slowly shifting to right number
-            if (desiredColors[i][colorChan] < _leds[i][colorChan]) {
-                directions[i][colorChan] = -1;
-            } else if (desiredColors[i][colorChan] > _leds[i][colorChan]) {
-                directions[i][colorChan] = 1;
-            }
-        }
-    }
-    
-    while (numDone < _highestPixelAddress) {
-        numDone = 0;
-        for (uint16_t i = 0; i < _highestPixelAddress; i++) {
-            if (desiredColors[i][0] == _leds[i][0] && desiredColors[i][1] == _leds[i][1] && desiredColors[i][2] == _leds[i][2]) {
-                numDone++;
-            }
-
-            for (uint8_t colorChan = 0; colorChan < 3; colorChan++) {
-                if (desiredColors[i][colorChan] != _leds[i][colorChan]) {
-                    _leds[i][colorChan] += directions[i][colorChan];
-                }
-            }
-        }
-        _showLeds();
-        vTaskDelay(COLOR_DELAY);
-    }
-    
-    _l.logd("End fadeToMultipleColors mode");
-    
-    _state = _READY_TO_RUN;
-
-    _taskHandler = NULL;
-    vTaskDelete(_taskHandler);
+void Ledstrip::setBrightness(uint8_t brightness) {
+    _sendRenderMessage(RENDER_MESSAGE_SET_BRIGHTNESS, brightness);
 }
+#pragma endregion
 
+#pragma region Conversions
 /******************************************************************************/
 /*!
   @brief    Converts the specified CRGB color into CRGBW.
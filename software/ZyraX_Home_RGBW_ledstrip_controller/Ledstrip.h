@@ -30,158 +30,393 @@
 #include "Preferences.h"                                                        //For non-volatile memory functionality
 #include "Configuration.h"                                                      //For configuration variables and global constants
 #include "Logger.h"                                                             //For printing and saving logs
+#include "esp_heap_caps.h"                                                      //For allocating the pixel buffers in PSRAM
+#include "ColorCorrection.h"                                                    //For the gamma and white point correction tables
+#include "PixelKernels.h"                                                       //For the blend, fade and remap kernels
+#include "ColorTables.h"                                                        //For the color wheel and heat palette tables
+#include "esp_timer.h"                                                          //For measuring the output stage
+#include "FastLedOutputDriver.h"                                                //For sending the frames
+#include "Random.h"                                                             //For the random numbers of the effects
+#include "esp_random.h"                                                         //For hardware random seeds
 
 
 #define CORE_NUMBER             1
 #define PRIORITY                2
+#define OUTPUT_CORE_NUMBER      0                                               //Output task runs on the other core, so frames are clocked out while the next one is calculated
+#define OUTPUT_PRIORITY         3
 
+/* Notification bits of the output task */
+#define OUTPUT_NOTIFY_FRAME     (1UL << 0)                                      //New front frame
+#define OUTPUT_NOTIFY_BRIGHTNESS (1UL << 1)                                     //Target brightness changed, the last frame is sent again while it ramps
+
+#define BUFFER_ALIGNMENT        4                                               //Alignment of the buffers in the pixel buffer arena
+#define SCRATCH_BYTES_PER_LED   6                                               //Per LED working set of the animations, sizes the ball and pixel fade pools
+#define SCRATCH_EXTRA_BYTES     (2 * UINT8_MAX * sizeof(CRGB))                  //Fixed part per segment, so short segments still fit their pools
+
+
+/* Segment phases */
+#define SEGMENT_RUNNING         0
+#define SEGMENT_IDLE            1                                               //Static mode, nothing left to render
+
+#define ALL_SEGMENTS            UINT8_MAX
+#define FRAME_IDLE              UINT16_MAX                                      //Returned by a render function of a static mode
+#define MAX_STEPS_PER_FRAME     128                                             //Steps a segment catches up in one frame, the rest is skipped
+#define PALETTE_CHANGE_TIME     5000                                            //Time the color waves blend into the next random palette, in ms
+
+struct SegmentState {
+    uint8_t phase = SEGMENT_IDLE;
+    TickType_t nextFrameTime = 0;                                               //Time of the next step of the mode, in ticks
+    uint32_t startTime = 0;                                                     //Time the mode started, in ms
+    uint32_t seed = 0;                                                          //Seed of the generator, for modes that derive their random values from the time
+    uint16_t index = 0;                                                         //Current LED or step of the animation
+    uint16_t position = 0;                                                      //Location of a moving segment
+    uint16_t rotation = 0;                                                      //Rotation offset of the canvas, LED i shows leds[(i + rotation) % length]
+    int8_t direction = 1;
+    bool toggle = false;
+    uint8_t colorPosition1 = 0;
+    uint8_t colorPosition2 = 255;
+    int8_t colorDirection1 = 1;
+    int8_t colorDirection2 = -1;
+    uint8_t cycle = 0;
+    uint8_t numberOfElements = 0;                                               //Elements that fit in the scratch memory
+    uint8_t numberOfActiveElements = 0;                                         //Elements that are running, like fading LEDs
+    uint32_t nextElementTime = 0;                                               //Start of the next element, in ms
+    int16_t hue = 50;
+    uint16_t hueRange = 256;
+    uint8_t lastSecond = 99;
+    uint32_t lastBlendTime = 0;                                                 //In ms
+    CRGBPalette16 currentPalette;
+    CRGBPalette16 targetPalette;
+    Random random;                                                              //Generator of the mode, seeded when the mode starts
+};
+
+class Ledstrip;
+struct Segment;
+
+/* Entry colors, the colors the canvas of a segment starts with when its mode starts */
+#define ENTRY_COLORS_NONE                0                                      //Mode starts on the current colors
+#define ENTRY_COLORS_BLACK               1
+#define ENTRY_COLORS_COLOR1              2
+#define ENTRY_COLORS_COLOR1_GRADIENT     3                                      //Color 1, or the gradient if gradient 1 is used
+#define ENTRY_COLORS_COLOR2              4
+#define ENTRY_COLORS_COLOR2_GRADIENT     5                                      //Color 2, or the gradient if gradient 2 is used
+#define ENTRY_COLORS_COLOR_WHEEL         6                                      //Color of the color position on the color wheel
+#define ENTRY_COLORS_GRADIENT            7                                      //Gradient between the min and max color position
+
+/* Slots of the mode registry, modes up to the last template use their ID as slot */
+#define MODE_SLOT_DRAWING           0                                           //Drawing mode, also used for unknown modes
+#define MODE_SLOT_SYSTEM_PULSES     (MODE_TEMPLATE_10 + 1)
+#define NUMBER_OF_MODE_SLOTS        (MODE_TEMPLATE_10 + 2)
+
+/* Mode descriptor, an entry of the mode registry */
+struct Mode {
+    uint8_t id;
+    const char* name;
+    uint8_t entryColors;
+    void (Ledstrip::*begin)(Segment &segment, uint32_t time);                   //Prepares the state when the mode starts, NULL if not needed
+    uint16_t (Ledstrip::*renderFrame)(Segment &segment, uint32_t time);         //Renders the step at the time in ms, returns the time until the next step in ms
+    uint32_t parameterFlags;                                                    //Configurable parameters, PARAMETER_* flags
+    bool isSeekable;                                                            //Frame only depends on the time since the start, so only the step at the frame time is rendered
+};
+
+struct Segment {
+    uint16_t start = 0;                                                         //First logical address
+    uint16_t length = 0;
+    uint8_t mode = MODE_COLOR;
+    const Mode* activeMode = NULL;                                              //Object of mode, resolved when the mode starts
+    ModeParameters parameters;                                                  //Copy of the mode parameters, so every segment has its own state
+    SegmentState state;
+    CRGB* leds = NULL;                                                          //Canvas the mode renders into
+    uint8_t* scratch = NULL;                                                    //Part of the scratch buffer of this segment
+
+    /* Transition, the outgoing mode keeps running on its own canvas while it is crossfaded into the mode */
+    Segment* outgoing = NULL;                                                   //Outgoing mode, renders into _transitionLeds
+    bool isTransitioning = false;
+    uint32_t transitionStartTime = 0;                                           //In ms
+    uint16_t transitionProgress = 0;                                            //Portion of the mode in the crossfade, Q8.8
+};
+
+/* Layer blend operations */
+#define BLEND_OVER              0                                               //Layer color over the frame, by opacity
+#define BLEND_MULTIPLY          1                                               //Frame tinted by the layer color, by opacity
+#define BLEND_ADD               2                                               //Layer color added to the frame, by opacity
+#define BLEND_MASK              3                                               //Frame scaled by the alpha of every pixel
+
+/* Overlay layers, composited over the segments in this order */
+#define LAYER_DOOR              0
+#define LAYER_ALARM             1
+#define LAYER_POWER             2
+#define NUMBER_OF_LAYERS        3
+
+#define POWER_SWEEP_FADE_LENGTH 5
+#define POWER_DISSOLVE_GROUP_SIZE 3                                             //LEDs that fade together
+#define POWER_DISSOLVE_GROUP_STEPS 11                                           //Steps of the fade of a group
+
+struct Layer {
+    bool isEnabled = false;
+    uint8_t blendOperation = BLEND_OVER;
+    uint8_t opacity = 255;
+    CRGB color = CRGB(0, 0, 0);
+    uint8_t* alpha = NULL;                                                      //Alpha per pixel of a mask layer, size: _highestPixelAddress
+    bool isAnimated = false;                                                    //Rendered by the render task until the animation ends
+    TickType_t nextFrameTime = 0;                                               //Deadline of the next frame, in ticks
+    uint16_t step = 0;                                                          //Current step of the animation
+    uint8_t cycle = 0;
+    uint32_t startTime = 0;                                                     //Start of a fixed duration animation, in ms
+};
+
+/* Render messages, handed over to the render task and handled between frames */
+#define RENDER_MESSAGE_SET_MODE         0
+#define RENDER_MESSAGE_SET_POWER        1
+#define RENDER_MESSAGE_DOOR_CHANGE      2
+#define RENDER_MESSAGE_SET_BRIGHTNESS   3
+#define RENDER_MESSAGE_DRAW             4                                       //Copy the drawn LEDs into _leds and present them
+#define RENDER_MESSAGE_CONFIGURE_MODE   5
+
+#define RENDER_QUEUE_LENGTH     8
+
+struct RenderMessage {
+    uint8_t type;
+    uint8_t value;                                                              //Mode, power state, door state or brightness
+    uint8_t segment;
+    ModeParameters parameters;                                                  //Parameters of a configured mode
+    CRGB* leds = NULL;                                                          //Drawn LEDs, owned by the message and freed when it is handled or dropped
+    int64_t sendTime;                                                           //In us, for measuring the mode switch latency
+    uint32_t sequence;                                                          //Number of the message, its sender waits until it is applied
+};
+
+#define BALL_GRAVITY            (-9.81)
+#define BALL_START_HEIGHT       10
+
+/* Fade of one LED of the dissolve and sparkle modes, pooled in the scratch memory */
+struct PixelFade {
+    uint32_t startTime;                                                         //In ms, the LED holds the start color until then
+    uint16_t led;
+    uint16_t duration;                                                          //In ms
+    CRGB from;
+    CRGB to;
+};
+
+struct Ball {
+    float impactVelocity;
+    float dampening;
+    uint32_t lastBounceTime;                                                    //In ms
+    CRGB color;
+};
 
 class Ledstrip {
+  friend class ModeBenchmark;                                                   //Host benchmark, software/host
+
   public:
     Ledstrip();
+    void setOutputDriver(OutputDriver* driver);
     void initialize();
     
     /* Direct functions */
-    void setPower(bool state, bool startMode = true);
+    void setPower(bool state);
     void doorHandler(bool state);
     void setPowerAnimation(uint8_t animation);
-    void setPixelAddressing(String addressesJson, uint16_t numberOfLeds);
+    bool setPixelAddressing(String addressesJson, uint16_t numberOfLeds);
     
     /* Modes */
-    void setMode(uint8_t mode);
-    void configureMode(uint8_t mode, ModeParameters parameters, bool save = true);
-    
+    void setMode(uint8_t mode, uint8_t segment = ALL_SEGMENTS);
+    void configureMode(uint8_t mode, ModeParameters parameters, bool save = true, uint8_t segment = ALL_SEGMENTS);
+    bool setSegments(String segmentsJson);
     void drawPixels(CRGB leds[]);
-    void color();
-    void fade();
-    void gradient();
-    void blink();
-    void scan();
-    void theater();
-    void sine();
-    void bouncingBalls();
-    void dissolve();
-    void sparkle();
-    void fireworks();
-    void fire();
-    void sweep();
-    void colorTwinkels();
-    void meteorRain();
-    void colorWaves();
-    void modeTemplate1();
-    void modeTemplate2();
-    void modeTemplate3();
-    void modeTemplate4();
-    void modeTemplate5();
-    void modeTemplate6();
-    void modeTemplate7();
-    void modeTemplate8();
-    void modeTemplate9();
-    void modeTemplate10();
-
-    void systemPulses();
-    void systemAlarm();
 
     /* Getters */
     bool isAvailable();
     uint8_t getState();
     String getPixelAddressing();
     String getPixels();
+    size_t getPixels(CRGB pixels[], uint16_t size);
     uint16_t getNumberOfLeds();
     uint8_t getDriver();
+    uint8_t getNumberOfOutputs();
     bool getPower();
     uint8_t getMode();
+    uint8_t getSegmentMode(uint8_t segment);
+    uint8_t getNumberOfSegments();
+    String getSegments();
     uint8_t getPowerAnimation();
     uint8_t getBrightness();
+    uint32_t getFramesSent();
+    uint32_t getFramesSkipped();
+    uint32_t getMissedFrameDeadlines();
+    uint16_t getFrameHeadroom();
+    uint32_t getMaxRemapTime();
+    uint32_t getMaxModeSwitchTime();
 
     /* Setters */
     void setBrightness(uint8_t brightness);
 
     /* Utility functions */
     CRGBW CRGBtoCRGBW(CRGB color);
+    static uint32_t getModeParameterFlags(uint8_t mode);
     
   private:
+    bool _allocateBuffers();
+    uint8_t* _carveBuffer(size_t size, const char* name);
+    void _addOutputs();
+    template <uint8_t DATA_PIN> void _addOutput(uint16_t offset, uint16_t length);
     void _loadPixelAddresses();
+    uint8_t _parseOutputs(JsonDocument &addresses, uint16_t numberOfLeds, uint16_t outputLengths[]);
+    uint16_t _getJsonPixelAddress(JsonDocument &addresses, uint16_t index);
+    uint16_t _getFrameSize(JsonDocument &addresses);
+    void _parsePixelAddresses(JsonDocument &addresses);
+    void _compilePixelAddresses();
     void _handleDoorOpen();
     void _handleDoorClosed();
+    void _loadSegments();
+    void _loadModeParameters();
+    uint8_t _parseSegments(JsonDocument &segments, uint16_t segmentLengths[]);
     
-    void _rotateLeft(uint8_t steps = 1);
-    void _rotateRight(uint8_t steps = 1);
+    void _rotateLeft(CRGB leds[], uint16_t length, uint16_t steps = 1);
+    void _reverseLeds(CRGB leds[], uint16_t length);
     CRGB _randomColor(uint8_t saturationPerc = 100);
-    CRGB _blendColors(CRGB color1, float color1Portion, CRGB color2);
+    CRGB _blendColors(CRGB color1, CRGB color2, uint8_t alpha);
+    void _blendColors(CRGB leds[], const CRGB colors1[], const CRGB colors2[], const uint8_t alphas[], uint16_t length);
+    uint16_t _getFadeProgress(uint32_t elapsed, uint32_t duration);
+    void _fadeColors(CRGB leds[], const CRGB from[], const CRGB to[], uint16_t progress, uint16_t length);
     CRGB _colorWheel(uint8_t position);
-    CRGB _getHeatColor(uint8_t temperature, uint8_t pallete);
-    uint8_t _getGradientColorPosition(uint8_t step);
-
-    /* Modes (threads) */
-    void __fade();
-    void __gradient();
-    void __blink();
-    void __scan();
-    void __theater();
-    void __sine();
-    void __bouncingBalls();
-    void __dissolve();
-    void __sparkle();
-    void __fireworks();
-    void __fire();
-    void __sweep();
-    void __colorTwinkels();
-    void __meteorRain();
-    void __colorWaves();
-    void __modeTemplate1();
-    void __modeTemplate2();
-    void __modeTemplate3();
-    void __modeTemplate4();
-    void __modeTemplate5();
-    void __modeTemplate6();
-    void __modeTemplate7();
-    void __modeTemplate8();
-    void __modeTemplate9();
-    void __modeTemplate10();
+    uint8_t _beatSin8(uint8_t bpm, uint32_t time);
+    const ColorTable* _getHeatTable(uint8_t palette);
+    uint8_t _getGradientColorPosition(uint16_t step, ModeParameters &parameters, uint8_t colorPosition);
+    uint32_t _getModeStep(Segment &segment, uint32_t time, uint16_t period);
+    uint16_t _getTimeToNextStep(Segment &segment, uint32_t time, uint16_t period);
+    uint8_t _getBouncePosition(uint32_t steps, uint8_t low, uint8_t high);
+    CRGBPalette16 _getColorWavesPalette(Segment &segment, uint32_t number);
+    void _shuffleIndexes(uint16_t indexes[], uint16_t length, Random &random);
 
-    
-    void __systemPulses();
-    void __systemAlarm();
-
-    /* Power (on/off) animations */
-    void _powerFade();
-    void _powerDissolve();
-    void _powerSweep();
-    void _powerDualSweep();
-    void _powerMultiSweep();
-
-    /* Power (on/off) animations (threads) */
-    void __powerFade();
-    void __powerDissolve();
-    void __powerSweep();
-    void __powerDualSweep();
-    void __powerMultiSweep();
+    /* Segments */
+    void _startMode(uint8_t mode, uint8_t segment);
+    void _startModes();
+    void _startSegment(Segment &segment);
+    void _applyModeParameters(uint8_t mode, ModeParameters &parameters, uint8_t segment);
+    const ModeParameters& _getModeParameters(uint8_t mode, uint8_t segment);
+    void _startTransition(Segment &segment, uint32_t time);
+    bool _renderTransition(Segment &segment, TickType_t now);
+    void _resetRotation(Segment &segment);
+    void _resolveSegments(CRGB frame[]);
+    static const Mode* _findMode(uint8_t mode);
+    void _setEntryColors(Segment &segment);
+    bool _renderSegment(Segment &segment, TickType_t now);
+
+    /* Pixel fades, LEDs of a segment that fade at the same time */
+    size_t _getPixelFadesOffset(Segment &segment);
+    void _startPixelFade(Segment &segment, uint16_t led, CRGB from, CRGB to, uint32_t startTime, uint16_t duration);
+    bool _renderPixelFades(Segment &segment, uint32_t time);
+    uint16_t _getPixelFadesPeriod(Segment &segment, uint32_t time);
+
+    /* Modes, prepare the state of the segment when the mode starts */
+    void _beginScan(Segment &segment, uint32_t time);
+    void _beginTheater(Segment &segment, uint32_t time);
+    void _beginBouncingBalls(Segment &segment, uint32_t time);
+    void _beginPixelFades(Segment &segment, uint32_t time);
+    void _beginFire(Segment &segment, uint32_t time);
+    void _beginColorTwinkels(Segment &segment, uint32_t time);
+    void _beginSystemPulses(Segment &segment, uint32_t time);
+
+    /* Modes, render the step of the segment at the time in ms and return the time until the next step in ms */
+    uint16_t _renderFade(Segment &segment, uint32_t time);
+    uint16_t _renderGradient(Segment &segment, uint32_t time);
+    uint16_t _renderBlink(Segment &segment, uint32_t time);
+    uint16_t _renderScan(Segment &segment, uint32_t time);
+    uint16_t _renderTheater(Segment &segment, uint32_t time);
+    uint16_t _renderSine(Segment &segment, uint32_t time);
+    uint16_t _renderBouncingBalls(Segment &segment, uint32_t time);
+    uint16_t _renderDissolve(Segment &segment, uint32_t time);
+    uint16_t _renderSparkle(Segment &segment, uint32_t time);
+    uint16_t _renderFireworks(Segment &segment, uint32_t time);
+    uint16_t _renderFire(Segment &segment, uint32_t time);
+    uint16_t _renderSweep(Segment &segment, uint32_t time);
+    uint16_t _renderColorTwinkels(Segment &segment, uint32_t time);
+    uint16_t _renderMeteorRain(Segment &segment, uint32_t time);
+    uint16_t _renderColorWaves(Segment &segment, uint32_t time);
+    uint16_t _renderModeTemplate(Segment &segment, uint32_t time);
+    uint16_t _renderStatic(Segment &segment, uint32_t time);
+
+    uint16_t _renderSystemPulses(Segment &segment, uint32_t time);
+
+    /* Overlay layers, render one step of the layer and return the time until the next step in ms */
+    uint16_t _renderLayer(uint8_t layer);
+    uint16_t _renderAlarm();
+    void _startPowerAnimation(bool state);
+    void _stepPowerMask(uint16_t index, uint8_t alpha);
+    uint16_t _renderPowerFade();
+    uint16_t _renderPowerDissolve();
+    uint16_t _renderPowerSweep();
+    uint16_t _renderPowerDualSweep();
 
     /* System functions */
-    static void __startModeTask(void* parameter);
-    void _waitUntilIdle();
-    void _saveLeds();
+    static void __startRenderTask(void* parameter);
+    void _startRenderTask();
+    void __render();
+    bool _scheduleNextFrame(TickType_t &nextFrameTime, uint16_t period, TickType_t now);
+    bool _updateFrameHeadroom(TickType_t nextFrameTime, TickType_t now);
+    bool _sendRenderMessage(uint8_t type, uint8_t value, uint8_t segment = ALL_SEGMENTS);
+    bool _sendRenderMessage(RenderMessage &message);
+    void _handleRenderMessage(RenderMessage &message);
 
-    void _fadeBrightness();
-    void _fadeToColor();
-    void _fadeToMultipleColors(uint8_t desiredColorPos, bool fadeToGradientColors = false);
-    
-    void __fadeBrightness();
-    void __fadeToColor();
-    void __fadeToMultipleColors();
+    /* Frame pipeline */
+    static void __startOutputTask(void* parameter);
+    void __output();
+    void _presentFrame(bool force = false);
+    void _compositeFrame(CRGB frame[]);
+    void _remapFrame(CRGB frame[]);
+    void _publishSnapshot(CRGB frame[]);
+    void _setTargetBrightness(uint8_t brightness);
+    bool _updateOutputBrightness();
+    template <typename T> void _remapRuns(T output[], CRGB frame[]);
 
-    /* Show functions */
-    void _showLeds();
+    /* Strip state, buffers are allocated in the pixel buffer arena */
+    uint8_t* _bufferArena = NULL;
+    size_t _bufferArenaSize = 0;
+    size_t _bufferArenaUsed = 0;
 
-    /* Strip state */
-    uint16_t _ledAddresses[MAX_NUMBER_LEDS];
-    CRGB _leds[MAX_NUMBER_LEDS];
-    CRGB _savedLeds[MAX_NUMBER_LEDS];
+    uint16_t* _ledAddresses = NULL;                                             //Size: _numberLeds
+    PixelRun* _pixelRuns = NULL;                                                //Compiled _ledAddresses, at most one run per LED
+    uint16_t _numberOfPixelRuns;
+    CRGB* _leds = NULL;                                                         //Size: _highestPixelAddress
+    uint8_t* _powerMask = NULL;                                                 //Alpha of the power layer, size: _highestPixelAddress
+    uint16_t* _powerIndexes = NULL;                                             //Dissolve order of the power animation, size: _highestPixelAddress
+    uint8_t* _scratchBuffer = NULL;                                             //Working memory of the running animations, too big for the task stack on long strips
+    CRGB* _transitionLeds = NULL;                                               //Canvas of the outgoing modes, size: _highestPixelAddress
+    uint8_t* _transitionScratchBuffer = NULL;                                   //Working memory of the outgoing modes, same layout as _scratchBuffer
 
-    CRGB _tempLeds[MAX_NUMBER_LEDS];
-    CRGBW _crgbwTempLeds[MAX_NUMBER_LEDS];
-    CRGB *_ledsPointer = (CRGB *) &_crgbwTempLeds[0];                           //Make pointer to array
+    CRGB* _tempLeds = NULL;                                                     //Output buffer for RGB drivers, size: _numberLeds
+    CRGBW* _crgbwTempLeds = NULL;                                               //Output buffer for RGBW drivers, size: _numberLeds
+    uint8_t* _outputBuffer = NULL;                                              //_tempLeds or _crgbwTempLeds, for the output driver
+    size_t _outputBufferSize = 0;
+    const ColorLut* _colorLut = &COLOR_LUTS[_WS2801];                           //Correction tables of the driver, applied by the remap
+    bool _isColorCorrected = true;                                              //False for identity tables (gamma 1.0, no white point), copy runs are then block copies
+    uint8_t* _ditherErrors = NULL;                                              //Accumulated fraction per output channel, size: 3 * _numberLeds
+    volatile bool _ditherResidue = false;                                       //Last frame had fractions, so it is refreshed to dither them
+    
+    /* Frame pipeline */
+    CRGB* _frameBuffers[2] = {NULL, NULL};                                      //Front frame is read by the output task, back frame is written by _presentFrame()
+    volatile uint8_t _frontFrame = 0;
+    SemaphoreHandle_t _frameFence = NULL;                                       //Given by the output task when the front frame is copied into the output buffer
+    TaskHandle_t _outputTaskHandler = NULL;
+    FastLedOutputDriver _fastLedOutputDriver;
+    OutputDriver* _outputDriver = &_fastLedOutputDriver;
+    bool _forceNextFrame = true;                                                //Sends the next frame even if it did not change, like the first frame after boot
+    volatile uint32_t _framesSent = 0;
+    volatile uint32_t _framesSkipped = 0;
+    CRGB* _snapshot = NULL;                                                     //Last sent frame, for reading outside the render tasks
+    volatile uint32_t _snapshotSequence = 0;                                    //Seqlock of _snapshot, odd while it is written
+    volatile uint32_t _maxRemapTime = 0;                                        //Longest remap, correction and dithering of a frame, in us
+    volatile uint32_t _maxModeSwitchTime = 0;                                   //Longest time from setMode() to the first frame of the mode, in us
+
+    /* Brightness ramp, owned by the output task */
+    uint8_t _outputBrightness = 0;                                              //Brightness the driver applies to the frames
+    uint8_t _brightnessFadeFrom = 0;
+    uint8_t _brightnessFadeTo = 0;
+    uint32_t _brightnessFadeStartTime = 0;                                      //In ms
+
+    /* Frame deadline statistics, since boot */
+    uint32_t _missedFrameDeadlines = 0;
+    uint16_t _frameHeadroom = UINT16_MAX;                                       //Smallest time left before a deadline, in ms
     
     /* Pins */
     uint8_t _dataPin;
@@ -189,29 +424,43 @@ class Ledstrip {
     uint8_t _driver;
     uint16_t _numberLeds;
     uint16_t _highestPixelAddress;
+    uint8_t _numberOfOutputs = 1;
+    uint16_t _outputLengths[MAX_NUMBER_OF_OUTPUTS];                             //Number of LEDs per data pin, the outputs are consecutive in the output buffer
     
     /* States */
     bool _isOn;
     bool _wasOn;
-    uint8_t _brightness;
+    volatile uint8_t _brightness;                                               //Target brightness, the output task ramps to it
     uint8_t _prevBrightness;
-    uint8_t _mode;
-    uint8_t _prevMode;
-    CRGB _fullColor;
-    CRGB _prevColor;
     uint8_t _powerAnimation;
     bool _doorState;
 
     uint8_t _state;
+    int64_t _modeSwitchSendTime = 0;                                            //Send time of the last mode change, 0 when its first frame is presented, in us
+
+    /* Segments, consecutive parts of the strip with their own mode */
+    Segment _segments[MAX_NUMBER_OF_SEGMENTS];
+    Segment _outgoingSegments[MAX_NUMBER_OF_SEGMENTS];                          //Outgoing mode of every segment during a transition
+    uint8_t _numberOfSegments = 1;
+
+    /* Overlay layers, composited over the segments without changing _leds */
+    Layer _layers[NUMBER_OF_LAYERS];
+    Random _random;                                                             //Generator of the layers and utilities
 
-    /* Temporary system variables*/
-    uint8_t _desiredColorPos;
-    bool _fadeToGradientColors;
+    /* Mode registry, looked up by slot */
+    static const Mode _modes[NUMBER_OF_MODE_SLOTS];
 
-    /* Mode parameters */ 
-    ModeParameters _modeParameters[NUM_MODES]; 
+    /* Mode parameters, owned by the render task */
+    ModeParameters _modeParameters[NUM_MODES];
+    ModeParameters _segmentModeParameters[MAX_NUMBER_OF_SEGMENTS][NUM_MODES];   //Parameters of a mode on one segment, used instead of _modeParameters
+    uint32_t _segmentModeOverrides[MAX_NUMBER_OF_SEGMENTS] = {0};               //Modes with parameters of their own per segment, bit per mode ID
     
-    TaskHandle_t _taskHandler = NULL;                                           //One taskhandler, one task at a time
+    TaskHandle_t _renderTaskHandler = NULL;                                     //Render task renders all segments and layers, runs as long as the strip
+    QueueHandle_t _renderQueue = NULL;                                          //Messages for the render task
+    SemaphoreHandle_t _renderJoinMutex = NULL;                                  //One sender at a time waits for its message
+    SemaphoreHandle_t _renderJoinSemaphore = NULL;                              //Given by the render task when messages are applied
+    uint32_t _renderMessageSequence = 0;                                        //Sequence of the last sent message, under _renderJoinMutex
+    volatile uint32_t _appliedRenderMessage = 0;                                //Sequence of the last applied message
 
     Logger _l;
 
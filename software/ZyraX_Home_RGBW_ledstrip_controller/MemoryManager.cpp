@@ -113,167 +113,95 @@ ModeParameters MemoryManager::loadModeParameters(uint8_t mode) {
 
 /******************************************************************************/
 /*!
-  @brief    Generates a JSON string based on the specified mode parameter.
+  @brief    Appends the JSON string of the specified mode parameter to the
+            parameter list of the mode.
+  @param    jsonString          JSON string of the mode
   @param    parameterName       Name of the parameter
   @param    parameterValue      Value of the parameter
   @param    isString            True if value is string
-  @returns  String              Parameter JSON string
 */
 /******************************************************************************/
-String MemoryManager::_generateModeParameterJsonString(String parameterName, String parameterValue, bool isString) {
-    String jsonString = "{\"name\":\"" + String(parameterName) + "\", ";
+void MemoryManager::_appendModeParameterJsonString(String &jsonString, String parameterName, String parameterValue, bool isString) {
+    if (!jsonString.endsWith("[")) {
+        jsonString += ",";
+    }
+
+    jsonString += "{\"name\":\"" + parameterName + "\", ";
     if (isString) {
-        jsonString += "\"value\":\"" + String(parameterValue) + "\"}";
+        jsonString += "\"value\":\"" + parameterValue + "\"}";
     } else {
-        jsonString += "\"value\":" + String(parameterValue) + "}";
+        jsonString += "\"value\":" + parameterValue + "}";
     }
-    return jsonString;
 }
 
 /******************************************************************************/
 /*!
   @brief    Returns the JSON string of the specified mode.
   @param    mode                Mode ID
+  @param    parameterFlags      Parameters of the mode, PARAMETER_* flags
   @returns  String              JSON string of the mode
 */
 /******************************************************************************/
-String MemoryManager::getModeJsonString(uint8_t mode) {
+String MemoryManager::getModeJsonString(uint8_t mode, uint32_t parameterFlags) {
     ModeParameters parameters = loadModeParameters(mode);
-    uint8_t numberOfParameters = getnumberOfModeParameters(mode);
-    uint8_t parameterCount = 0;
     String jsonString = "{\"mode\":" + String(mode) + ", \"parameters\": [";
+    char colorString[8] = {0};                                                  //#rrggbb
 
-    if (modeHasParameter(mode, PARAMETER_NAME_MIN_COLOR_POS)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_MIN_COLOR_POS, String(parameters.minColorPos));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_MIN_COLOR_POS) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_MIN_COLOR_POS, String(parameters.minColorPos));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_MAX_COLOR_POS)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_MAX_COLOR_POS, String(parameters.maxColorPos));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_MAX_COLOR_POS) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_MAX_COLOR_POS, String(parameters.maxColorPos));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_COLOR1)) {
-        char colorString[7] = {0};
+    if (parameterFlags & PARAMETER_COLOR1) {
         sprintf(colorString, "#%06x", rgbToHex(parameters.color1));
-
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_COLOR1, String(colorString), true);
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_COLOR1, String(colorString), true);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_COLOR2)) {
-        char colorString[7] = {0};
+    if (parameterFlags & PARAMETER_COLOR2) {
         sprintf(colorString, "#%06x", rgbToHex(parameters.color2));
-
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_COLOR2, String(colorString), true);
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_COLOR2, String(colorString), true);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_USE_GRADIENT1)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_USE_GRADIENT1, String(parameters.useGradient1));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_USE_GRADIENT1) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_USE_GRADIENT1, String(parameters.useGradient1));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_USE_GRADIENT2)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_USE_GRADIENT2, String(parameters.useGradient2));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_USE_GRADIENT2) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_USE_GRADIENT2, String(parameters.useGradient2));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_SEGMENT_SIZE)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_SEGMENT_SIZE, String(parameters.segmentSize));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_SEGMENT_SIZE) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_SEGMENT_SIZE, String(parameters.segmentSize));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_TAIL_LENGTH)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_TAIL_LENGTH, String(parameters.tailLength));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_TAIL_LENGTH) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_TAIL_LENGTH, String(parameters.tailLength));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_WAVE_LENGTH)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_WAVE_LENGTH, String(parameters.waveLength));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_WAVE_LENGTH) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_WAVE_LENGTH, String(parameters.waveLength));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_TIME_FADE)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_TIME_FADE, String(parameters.timeFade));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_TIME_FADE) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_TIME_FADE, String(parameters.timeFade));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_DELAY)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_DELAY, String(parameters.delay));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_DELAY) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_DELAY, String(parameters.delay));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_DELAY_BETWEEN)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_DELAY_BETWEEN, String(parameters.delayBetween));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_DELAY_BETWEEN) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_DELAY_BETWEEN, String(parameters.delayBetween));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_RANDOMNESS_DELAY)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_RANDOMNESS_DELAY, String(parameters.randomnessDelay));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_RANDOMNESS_DELAY) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_RANDOMNESS_DELAY, String(parameters.randomnessDelay));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_INTENSITY)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_INTENSITY, String(parameters.intensity));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_INTENSITY) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_INTENSITY, String(parameters.intensity));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_DIRECTION)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_DIRECTION, String(parameters.direction));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_DIRECTION) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_DIRECTION, String(parameters.direction));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_NUMBER_OF_ELEMENTS)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_NUMBER_OF_ELEMENTS, String(parameters.numberOfElements));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_NUMBER_OF_ELEMENTS) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_NUMBER_OF_ELEMENTS, String(parameters.numberOfElements));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_PALETTE)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_PALETTE, String(parameters.palette));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_PALETTE) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_PALETTE, String(parameters.palette));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_FADE_LENGTH)) {
-        jsonString += _generateModeParameterJsonString(PARAMETER_NAME_FADE_LENGTH, String(parameters.fadeLength));
-        if (parameterCount < numberOfParameters-1) {
-            jsonString += ",";
-        }
-        parameterCount++;
+    if (parameterFlags & PARAMETER_FADE_LENGTH) {
+        _appendModeParameterJsonString(jsonString, PARAMETER_NAME_FADE_LENGTH, String(parameters.fadeLength));
     }
 
     jsonString += "]}";
@@ -285,72 +213,132 @@ String MemoryManager::getModeJsonString(uint8_t mode) {
   @brief    Saved the specified mode parameters to the non-volatile memory.
   @param    mode                Mode ID
   @param    parameters          Mode parameters to write
+  @param    parameterFlags      Parameters of the mode, PARAMETER_* flags
 */
 /******************************************************************************/
-void MemoryManager::writeModeParameters(uint8_t mode, ModeParameters parameters) {
+void MemoryManager::writeModeParameters(uint8_t mode, ModeParameters parameters, uint32_t parameterFlags) {
     String modeString = String(mode);
 
     /* Load states from non-volatile memory (names maximum 16 chars) */
     _nvMemory.begin(NV_MEM_CONFIG);
 
-    if (modeHasParameter(mode, PARAMETER_NAME_MIN_COLOR_POS)) {
+    if (parameterFlags & PARAMETER_MIN_COLOR_POS) {
         _nvMemory.putUChar(String("minColorPos_" + modeString).c_str(), parameters.minColorPos);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_MAX_COLOR_POS)) {
+    if (parameterFlags & PARAMETER_MAX_COLOR_POS) {
         _nvMemory.putUChar(String("maxColorPos_" + modeString).c_str(), parameters.maxColorPos);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_COLOR1)) {
+    if (parameterFlags & PARAMETER_COLOR1) {
         _nvMemory.putString(String("color1_" + modeString).c_str(), _crgbToString(parameters.color1));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_COLOR2)) {
+    if (parameterFlags & PARAMETER_COLOR2) {
         _nvMemory.putString(String("color2_" + modeString).c_str(), _crgbToString(parameters.color2));
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_USE_GRADIENT1)) {
+    if (parameterFlags & PARAMETER_USE_GRADIENT1) {
         _nvMemory.putBool(String("useGradient1_" + modeString).c_str(), parameters.useGradient1);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_USE_GRADIENT2)) {
+    if (parameterFlags & PARAMETER_USE_GRADIENT2) {
         _nvMemory.putBool(String("useGradient2_" + modeString).c_str(), parameters.useGradient2);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_SEGMENT_SIZE)) {
+    if (parameterFlags & PARAMETER_SEGMENT_SIZE) {
         _nvMemory.putUChar(String("segmentSize_" + modeString).c_str(), parameters.segmentSize);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_TAIL_LENGTH)) {
+    if (parameterFlags & PARAMETER_TAIL_LENGTH) {
         _nvMemory.putUChar(String("tailLength_" + modeString).c_str(), parameters.tailLength);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_WAVE_LENGTH)) {
+    if (parameterFlags & PARAMETER_WAVE_LENGTH) {
         _nvMemory.putUChar(String("waveLength_" + modeString).c_str(), parameters.waveLength);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_TIME_FADE)) {
+    if (parameterFlags & PARAMETER_TIME_FADE) {
         _nvMemory.putUShort(String("timeFade_" + modeString).c_str(), parameters.timeFade);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_DELAY)) {
+    if (parameterFlags & PARAMETER_DELAY) {
         _nvMemory.putUShort(String("delay_" + modeString).c_str(), parameters.delay);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_DELAY_BETWEEN)) {
+    if (parameterFlags & PARAMETER_DELAY_BETWEEN) {
         _nvMemory.putUShort(String("delayBetween_" + modeString).c_str(), parameters.delayBetween);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_RANDOMNESS_DELAY)) {
+    if (parameterFlags & PARAMETER_RANDOMNESS_DELAY) {
         _nvMemory.putUChar(String("randomDelay_" + modeString).c_str(), parameters.randomnessDelay);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_INTENSITY)) {
+    if (parameterFlags & PARAMETER_INTENSITY) {
         _nvMemory.putUShort(String("intensity_" + modeString).c_str(), parameters.intensity);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_DIRECTION)) {
+    if (parameterFlags & PARAMETER_DIRECTION) {
         _nvMemory.putUShort(String("direction_" + modeString).c_str(), parameters.direction);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_NUMBER_OF_ELEMENTS)) {
+    if (parameterFlags & PARAMETER_NUMBER_OF_ELEMENTS) {
         _nvMemory.putUShort(String("numElems_" + modeString).c_str(), parameters.numberOfElements);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_PALETTE)) {
+    if (parameterFlags & PARAMETER_PALETTE) {
         _nvMemory.putUShort(String("palette_" + modeString).c_str(), parameters.palette);
     }
-    if (modeHasParameter(mode, PARAMETER_NAME_FADE_LENGTH)) {
+    if (parameterFlags & PARAMETER_FADE_LENGTH) {
         _nvMemory.putUShort(String("fadeLength_" + modeString).c_str(), parameters.fadeLength);
     }
     
     _nvMemory.end();
 }
 
+/******************************************************************************/
+/*!
+  @brief    Loads the parameters of the specified mode for one segment. They
+            are stored as one entry per segment and mode, so a segment with
+            its own parameters does not need an entry per parameter.
+  @param    segment             Segment index
+  @param    mode                Mode ID
+  @param    parameters          Loaded parameters, unchanged if not found
+  @returns  bool                True if the segment has its own parameters
+*/
+/******************************************************************************/
+bool MemoryManager::loadSegmentModeParameters(uint8_t segment, uint8_t mode, ModeParameters &parameters) {
+    ModeParameters loadedParameters;
+    String key = "segParams_" + String(segment) + "_" + String(mode);
+
+    _nvMemory.begin(NV_MEM_CONFIG);
+    size_t size = _nvMemory.getBytes(key.c_str(), &loadedParameters, sizeof(loadedParameters));
+    _nvMemory.end();
+
+    if (size != sizeof(loadedParameters)) {
+        return false;                                                           //Not configured, or saved by another firmware version
+    }
+
+    parameters = loadedParameters;
+    return true;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Saves the parameters of the specified mode for one segment.
+  @param    segment             Segment index
+  @param    mode                Mode ID
+  @param    parameters          Mode parameters to write
+*/
+/******************************************************************************/
+void MemoryManager::writeSegmentModeParameters(uint8_t segment, uint8_t mode, ModeParameters parameters) {
+    String key = "segParams_" + String(segment) + "_" + String(mode);
+
+    _nvMemory.begin(NV_MEM_CONFIG);
+    _nvMemory.putBytes(key.c_str(), &parameters, sizeof(parameters));
+    _nvMemory.end();
+}
+
+/******************************************************************************/
+/*!
+  @brief    Removes the parameters of the specified mode for one segment, so
+            the segment uses the parameters of the mode again.
+  @param    segment             Segment index
+  @param    mode                Mode ID
+*/
+/******************************************************************************/
+void MemoryManager::removeSegmentModeParameters(uint8_t segment, uint8_t mode) {
+    String key = "segParams_" + String(segment) + "_" + String(mode);
+
+    _nvMemory.begin(NV_MEM_CONFIG);
+    _nvMemory.remove(key.c_str());
+    _nvMemory.end();
+}
+
 /******************************************************************************/
 /*!
   @brief    Creates a folder when the folder doesn't yet exist.
@@ -598,361 +586,4 @@ String MemoryManager::_crgbToString(CRGB color) {
 /******************************************************************************/
 uint32_t MemoryManager::rgbToHex(CRGB color) {
     return ((color.r & 0xff) << 16) + ((color.g & 0xff) << 8) + (color.b & 0xff);
-}
-
-/******************************************************************************/
-/*!
-  @brief    Returns the number of mode parameters for the specified mode.
-  @param    mode                Mode ID
-  @returns  uint8_t             Number of parameters
-*/
-/******************************************************************************/
-uint8_t MemoryManager::getnumberOfModeParameters(uint8_t mode) {
-    String parameterNames[] = {
-        PARAMETER_NAME_MIN_COLOR_POS,
-        PARAMETER_NAME_MAX_COLOR_POS,
-        PARAMETER_NAME_COLOR1,
-        PARAMETER_NAME_COLOR2,
-        PARAMETER_NAME_USE_GRADIENT1,
-        PARAMETER_NAME_USE_GRADIENT2,
-        PARAMETER_NAME_SEGMENT_SIZE,
-        PARAMETER_NAME_TAIL_LENGTH,
-        PARAMETER_NAME_WAVE_LENGTH,
-        PARAMETER_NAME_TIME_FADE,
-        PARAMETER_NAME_DELAY,
-        PARAMETER_NAME_DELAY_BETWEEN,
-        PARAMETER_NAME_RANDOMNESS_DELAY,
-        PARAMETER_NAME_INTENSITY,
-        PARAMETER_NAME_DIRECTION,
-        PARAMETER_NAME_NUMBER_OF_ELEMENTS,
-        PARAMETER_NAME_PALETTE,
-        PARAMETER_NAME_FADE_LENGTH
-    };
-
-    uint8_t numberOfParameters = 0;
-    for (uint8_t i = 0; i < NUMBER_OF_MODE_PARAMETERS; i++) {
-        if (modeHasParameter(mode, parameterNames[i])) {
-            numberOfParameters++;
-        }
-    }
-
-    return numberOfParameters;
-}
-
-/******************************************************************************/
-/*!
-  @brief    Returns wether the specified mode has the specified mode parameter.
-  @param    mode                Mode ID
-  @param    parameterName       Name of the parameter
-  @returns  bool                True if mode has the specified parameter
-*/
-/******************************************************************************/
-bool MemoryManager::modeHasParameter(uint8_t mode, String parameterName) {
-    switch (mode) {
-        case MODE_COLOR:
-            if (parameterName == PARAMETER_NAME_COLOR1) {
-                return true;
-            }
-            return false;
-
-        case MODE_FADE:
-            if (parameterName == PARAMETER_NAME_DELAY) {
-                return true;
-            }
-            return false;
-
-        case MODE_GRADIENT:
-            if (parameterName == PARAMETER_NAME_MIN_COLOR_POS) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_MAX_COLOR_POS) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_WAVE_LENGTH) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY) {
-                return true;
-            }
-            return false;
-
-        case MODE_BLINK:
-            if (parameterName == PARAMETER_NAME_COLOR1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_COLOR2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY) {
-                return true;
-            }
-            return false;
-
-        case MODE_SCAN:
-            if (parameterName == PARAMETER_NAME_COLOR1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_COLOR2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_SEGMENT_SIZE) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_TAIL_LENGTH) {
-                return true;
-            }
-            return false;
-
-        case MODE_THEATER:
-            if (parameterName == PARAMETER_NAME_COLOR1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_COLOR2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DIRECTION) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_SEGMENT_SIZE) {
-                return true;
-            }
-            return false;
-
-        case MODE_SINE:
-            if (parameterName == PARAMETER_NAME_COLOR1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_COLOR2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DIRECTION) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_WAVE_LENGTH) {
-                return true;
-            }
-            return false;
-
-        case MODE_BOUNCING_BALLS:
-            if (parameterName == PARAMETER_NAME_COLOR1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_COLOR2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_NUMBER_OF_ELEMENTS) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_SEGMENT_SIZE) {
-                return true;
-            }
-            return false;
-
-        case MODE_DISSOLVE:
-            if (parameterName == PARAMETER_NAME_COLOR1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_COLOR2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_TIME_FADE) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY_BETWEEN) {
-                return true;
-            }
-            return false;
-
-        case MODE_SPARKLE:
-            if (parameterName == PARAMETER_NAME_COLOR1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_COLOR2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_INTENSITY) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY_BETWEEN) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_TIME_FADE) {
-                return true;
-            }
-            return false;
-
-        case MODE_FIREWORKS:
-            if (parameterName == PARAMETER_NAME_PALETTE) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY_BETWEEN) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_RANDOMNESS_DELAY) {
-                return true;
-            }
-            return false;
-        
-        case MODE_FIRE:
-            if (parameterName == PARAMETER_NAME_PALETTE) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_SEGMENT_SIZE) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY) {
-                return true;
-            }
-            return false;
-        
-        case MODE_SWEEP:
-            if (parameterName == PARAMETER_NAME_COLOR1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_COLOR2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT2) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_FADE_LENGTH) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY_BETWEEN) {
-                return true;
-            }
-            return false;
-
-        case MODE_COLOR_TWINKELS:
-            if (parameterName == PARAMETER_NAME_PALETTE) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_TIME_FADE) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY_BETWEEN) {
-                return true;
-            }
-            return false;
-            
-        case MODE_METEOR_RAIN:
-            if (parameterName == PARAMETER_NAME_COLOR1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_USE_GRADIENT1) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_SEGMENT_SIZE) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_TAIL_LENGTH) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_DELAY_BETWEEN) {
-                return true;
-            }
-            if (parameterName == PARAMETER_NAME_RANDOMNESS_DELAY) {
-                return true;
-            }
-            return false;
-
-        case MODE_COLOR_WAVES:
-            if (parameterName == PARAMETER_NAME_PALETTE) {
-                return true;
-            }
-            return false;
-
-        case MODE_TEMPLATE_1:
-            return false;
-        case MODE_TEMPLATE_2:
-            return false;
-        case MODE_TEMPLATE_3:
-            return false;
-        case MODE_TEMPLATE_4:
-            return false;
-        case MODE_TEMPLATE_5:
-            return false;
-        case MODE_TEMPLATE_6:
-            return false;
-            
-        case MODE_TEMPLATE_7:
-            return false;
-        
-        case MODE_TEMPLATE_8:
-            return false;
-            
-        case MODE_TEMPLATE_9:
-            return false;
-        
-        case MODE_TEMPLATE_10:
-            return false;
-        default:
-            return false;
-    }
 }
\ No newline at end of file
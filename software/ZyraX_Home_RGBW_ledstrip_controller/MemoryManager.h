@@ -28,8 +28,11 @@ class MemoryManager {
         MemoryManager();
         bool initialize();
         ModeParameters loadModeParameters(uint8_t mode);
-        String getModeJsonString(uint8_t mode);
-        void writeModeParameters(uint8_t mode, ModeParameters parameters);
+        String getModeJsonString(uint8_t mode, uint32_t parameterFlags);
+        void writeModeParameters(uint8_t mode, ModeParameters parameters, uint32_t parameterFlags);
+        bool loadSegmentModeParameters(uint8_t segment, uint8_t mode, ModeParameters &parameters);
+        void writeSegmentModeParameters(uint8_t segment, uint8_t mode, ModeParameters parameters);
+        void removeSegmentModeParameters(uint8_t segment, uint8_t mode);
         bool createFolderIfNotExists(String path);
         bool getSdMounted();
 
@@ -40,11 +43,9 @@ class MemoryManager {
         bool copyFile(String filePath, String copyPath);
         String joinPaths(String path1, String path2, String path3="");
         uint32_t rgbToHex(CRGB color);
-        bool modeHasParameter(uint8_t mode, String parameterName);
-        uint8_t getnumberOfModeParameters(uint8_t mode);
         
     private:
-        String _generateModeParameterJsonString(String parameterName, String parameterValue, bool isString=false);
+        void _appendModeParameterJsonString(String &jsonString, String parameterName, String parameterValue, bool isString=false);
         bool _checkFileSystemStructure();
         bool _checkDirectory(String directory);
         bool _checkFile(String filePath, String defaultFilePath = "");
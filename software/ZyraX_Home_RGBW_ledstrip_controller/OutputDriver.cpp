@@ -0,0 +1,124 @@
+/******************************************************************************/
+/*
+ * File:    OutputDriver.cpp
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * Class:   OutputDriver, RecordingOutputDriver
+ * 
+ * Brief:   Output drivers for the frames of the Ledstrip output stage. The
+ *          recording driver keeps the last frame in memory and/or appends
+ *          every frame to a binary file, so frames can be inspected without
+ *          a strip.
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#include "OutputDriver.h"
+#include "string.h"                                                             //For memcpy
+#include "time.h"                                                               //For the monotonic frame timestamps, on the ESP32 and on a host
+
+/******************************************************************************/
+/*!
+  @brief    Constructor.
+  @param    buffer              Buffer for the last frame, NULL for none
+  @param    bufferSize          Size of the buffer, in bytes
+*/
+/******************************************************************************/
+RecordingOutputDriver::RecordingOutputDriver(uint8_t buffer[], size_t bufferSize) {
+    _buffer = buffer;
+    _bufferSize = bufferSize;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Opens a file to append every frame to.
+  @param    path                Path of the file
+  @returns  bool                True if success
+*/
+/******************************************************************************/
+bool RecordingOutputDriver::open(const char* path) {
+    close();
+    _file = fopen(path, "ab");
+    return _file != NULL;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Closes the recording file.
+*/
+/******************************************************************************/
+void RecordingOutputDriver::close() {
+    if (_file == NULL) {
+        return;
+    }
+    fclose(_file);
+    _file = NULL;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Records the output buffer.
+  @param    pixels              Output buffer
+  @param    size                Size of the output buffer, in bytes
+*/
+/******************************************************************************/
+void RecordingOutputDriver::show(const uint8_t pixels[], size_t size) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    _lastFrameTime = (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    _numberOfFrames++;
+
+    if (_buffer != NULL) {
+        memcpy(_buffer, pixels, size < _bufferSize ? size : _bufferSize);
+    }
+
+    if (_file != NULL) {
+        uint32_t frameSize = size;
+        fwrite(&_lastFrameTime, sizeof(_lastFrameTime), 1, _file);
+        fwrite(&frameSize, sizeof(frameSize), 1, _file);
+        fwrite(&_brightness, sizeof(_brightness), 1, _file);
+        fwrite(pixels, 1, size, _file);
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Sets the brightness, stored with every recorded frame.
+  @param    brightness          Brightness
+*/
+/******************************************************************************/
+void RecordingOutputDriver::setBrightness(uint8_t brightness) {
+    _brightness = brightness;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns the brightness.
+  @returns  uint8_t             Brightness
+*/
+/******************************************************************************/
+uint8_t RecordingOutputDriver::getBrightness() {
+    return _brightness;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns the number of recorded frames.
+  @returns  uint32_t            Number of frames
+*/
+/******************************************************************************/
+uint32_t RecordingOutputDriver::getNumberOfFrames() {
+    return _numberOfFrames;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns the time of the last recorded frame.
+  @returns  uint64_t            Timestamp of the monotonic clock, in us (since
+                                boot on the ESP32)
+*/
+/******************************************************************************/
+uint64_t RecordingOutputDriver::getLastFrameTime() {
+    return _lastFrameTime;
+}
@@ -0,0 +1,60 @@
+/******************************************************************************/
+/*
+ * File:    OutputDriver.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * Class:   OutputDriver, RecordingOutputDriver
+ * 
+ * Brief:   Output drivers for the frames of the Ledstrip output stage. The
+ *          recording driver keeps the last frame in memory and/or appends
+ *          every frame to a binary file, so frames can be inspected without
+ *          a strip. Only uses the C library, so the drivers also build on a
+ *          host (see software/host). The FastLED driver is in
+ *          FastLedOutputDriver.h.
+ * 
+ *          Recording file format, per frame (little endian):
+ *          uint64_t timestamp (us), uint32_t size (bytes), uint8_t
+ *          brightness, followed by the output buffer (RGB pixels, GRBW
+ *          pixels for SK6812 strips).
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef OUTPUT_DRIVER_H
+#define OUTPUT_DRIVER_H
+#include "stdint.h"                                                             //For size defined int types
+#include "stddef.h"                                                             //For the size_t type
+#include "stdio.h"                                                              //For writing recordings, also to VFS paths like /sdcard
+
+class OutputDriver {
+  public:
+    virtual ~OutputDriver() {}
+
+    virtual void show(const uint8_t pixels[], size_t size) = 0;
+    virtual void setBrightness(uint8_t brightness) = 0;
+    virtual uint8_t getBrightness() = 0;
+};
+
+class RecordingOutputDriver : public OutputDriver {
+  public:
+    RecordingOutputDriver(uint8_t buffer[] = NULL, size_t bufferSize = 0);
+    bool open(const char* path);
+    void close();
+
+    void show(const uint8_t pixels[], size_t size) override;
+    void setBrightness(uint8_t brightness) override;
+    uint8_t getBrightness() override;
+
+    uint32_t getNumberOfFrames();
+    uint64_t getLastFrameTime();
+
+  private:
+    uint8_t* _buffer;                                                           //Last frame, optional
+    size_t _bufferSize;
+    FILE* _file = NULL;                                                         //Recording, optional
+    uint8_t _brightness = 255;
+    uint32_t _numberOfFrames = 0;
+    uint64_t _lastFrameTime = 0;                                                //In us
+};
+#endif
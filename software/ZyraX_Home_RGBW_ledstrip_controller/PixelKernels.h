@@ -0,0 +1,350 @@
+/******************************************************************************/
+/*
+ * File:    PixelKernels.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * 
+ * Brief:   Per-pixel kernels of the modes and the output stage: fixed point
+ *          blends and fades, compiling the pixel addressing into runs and
+ *          the color corrected remap. Only uses the C library and works on
+ *          any color type with r, g and b members (CRGB, CRGBW), so the
+ *          kernels also build on a host (see software/host).
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+#include "stdint.h"                                                             //For size defined int types
+#include "string.h"                                                             //For memmove and memcpy
+
+/* Pixel run types */
+#define PIXEL_RUN_COPY          0                                               //Consecutive addresses, block copy
+#define PIXEL_RUN_REVERSE       1                                               //Descending addresses, reversed copy
+#define PIXEL_RUN_REPEAT        2                                               //Same address repeated, fill
+#define PIXEL_RUN_GATHER        3                                               //Scattered addresses, gather through the address table
+
+#define MIN_PIXEL_RUN_LENGTH    4                                               //Shorter runs are added to a gather run
+
+/* Fixed duration fades, progress is Q8.8 so the end is exact */
+#define FADE_PROGRESS_END       256                                             //Progress of 1.0, the fade is at its end colors
+#define FADE_CHANNELS_PER_ITERATION 12                                          //Four RGB pixels
+
+struct PixelRun {
+    uint8_t type;
+    uint16_t length;                                                            //Number of output pixels
+    uint16_t source;                                                            //First logical address, for gather runs first index in the address table
+};
+
+struct ColorLut {
+    uint16_t red[256];                                                          //8.8 fixed point
+    uint16_t green[256];
+    uint16_t blue[256];
+};
+
+/******************************************************************************/
+/*!
+  @brief    Blends two colors in fixed point. An alpha of 0 returns exactly
+            color 1, 255 exactly color 2.
+  @param    color1              First color
+  @param    color2              Second color
+  @param    alpha               Portion of color 2, 0 - 255
+  @returns  C                   Blended color
+*/
+/******************************************************************************/
+template <typename C>
+static inline C blendColors(const C& color1, const C& color2, uint8_t alpha) {
+    uint16_t weight = alpha + (alpha >> 7);                                     //0 - 256, so 255 is the full second color
+
+    return C(
+        color1.r + (((int32_t) color2.r - color1.r) * weight >> 8),
+        color1.g + (((int32_t) color2.g - color1.g) * weight >> 8),
+        color1.b + (((int32_t) color2.b - color1.b) * weight >> 8)
+    );
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns the progress of a fixed duration fade.
+  @param    elapsed             Time since the start of the fade, in ms
+  @param    duration            Duration of the fade, in ms
+  @returns  uint16_t            Progress, Q8.8 (0 - FADE_PROGRESS_END)
+*/
+/******************************************************************************/
+static inline uint16_t getFadeProgress(uint32_t elapsed, uint32_t duration) {
+    if (elapsed >= duration) {
+        return FADE_PROGRESS_END;
+    }
+    return (elapsed << 8) / duration;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Linear interpolation between two channel arrays, in fixed point.
+            Processes four RGB pixels per iteration. At a progress of
+            FADE_PROGRESS_END the result is exactly the end channels. The
+            output may be the same array as one of the inputs.
+  @param    out                 Output channels
+  @param    from                Start channels
+  @param    to                  End channels
+  @param    progress            Progress, Q8.8 (0 - FADE_PROGRESS_END)
+  @param    size                Number of channels
+*/
+/******************************************************************************/
+static inline void fadeChannels(uint8_t out[], const uint8_t from[], const uint8_t to[], uint16_t progress, uint32_t size) {
+    if (progress >= FADE_PROGRESS_END) {
+        if (out != to) {
+            memmove(out, to, size);
+        }
+        return;
+    }
+
+    uint32_t i = 0;
+
+    /* The inner loop is unrolled */
+    for (; i + FADE_CHANNELS_PER_ITERATION <= size; i += FADE_CHANNELS_PER_ITERATION) {
+        for (uint8_t j = 0; j < FADE_CHANNELS_PER_ITERATION; j++) {
+            out[i + j] = from[i + j] + (((int32_t) to[i + j] - from[i + j]) * progress >> 8);
+        }
+    }
+
+    for (; i < size; i++) {
+        out[i] = from[i] + (((int32_t) to[i] - from[i]) * progress >> 8);
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Compiles pixel addresses into runs, so the output stage can use
+            block copies for contiguous parts of the strip. Only the
+            scattered pixels are gathered through the address table.
+  @param    addresses           Logical address per output LED
+  @param    numberLeds          Number of output LEDs
+  @param    runs                Compiled runs, size: numberLeds
+  @returns  uint16_t            Number of runs
+*/
+/******************************************************************************/
+static inline uint16_t compilePixelRuns(const uint16_t addresses[], uint16_t numberLeds, PixelRun runs[]) {
+    uint16_t numberOfRuns = 0;
+    uint16_t i = 0;
+
+    while (i < numberLeds) {
+        uint16_t copyLength = 1;
+        uint16_t reverseLength = 1;
+        uint16_t repeatLength = 1;
+
+        while (i + copyLength < numberLeds && addresses[i + copyLength] == addresses[i + copyLength - 1] + 1) {
+            copyLength++;
+        }
+        while (i + reverseLength < numberLeds && addresses[i + reverseLength] + 1 == addresses[i + reverseLength - 1]) {
+            reverseLength++;
+        }
+        while (i + repeatLength < numberLeds && addresses[i + repeatLength] == addresses[i]) {
+            repeatLength++;
+        }
+
+        PixelRun run;
+        run.type = PIXEL_RUN_COPY;
+        run.length = copyLength;
+        run.source = addresses[i];
+
+        if (reverseLength > run.length) {
+            run.type = PIXEL_RUN_REVERSE;
+            run.length = reverseLength;
+        }
+        if (repeatLength > run.length) {
+            run.type = PIXEL_RUN_REPEAT;
+            run.length = repeatLength;
+        }
+
+        /* Short runs are cheaper as part of a gather run */
+        if (run.length < MIN_PIXEL_RUN_LENGTH) {
+            if (numberOfRuns > 0 && runs[numberOfRuns - 1].type == PIXEL_RUN_GATHER) {
+                runs[numberOfRuns - 1].length++;
+            } else {
+                runs[numberOfRuns].type = PIXEL_RUN_GATHER;
+                runs[numberOfRuns].length = 1;
+                runs[numberOfRuns].source = i;
+                numberOfRuns++;
+            }
+            i++;
+            continue;
+        }
+
+        runs[numberOfRuns] = run;
+        numberOfRuns++;
+        i += run.length;
+    }
+
+    return numberOfRuns;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Rounds an 8.8 fixed point channel value down or up, based on the
+            fractions accumulated in previous frames. Over successive frames
+            the average output is the fixed point value.
+  @param    value               Channel value, 8.8 fixed point
+  @param    error               Accumulated fraction of the channel
+  @returns  uint8_t             Output value
+*/
+/******************************************************************************/
+static inline uint8_t ditherChannel(uint16_t value, uint8_t& error) {
+    uint16_t sum = (value & 0xFF) + error;
+    error = sum & 0xFF;
+    return (value >> 8) + (sum >> 8);                                           //Cannot overflow, full scale has no fraction
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns whether correction tables leave every color as it is,
+            like with a gamma of 1.0 and no white point correction.
+  @param    lut                 Correction tables
+  @returns  bool                True if the tables are an identity
+*/
+/******************************************************************************/
+static inline bool isIdentityLut(const ColorLut& lut) {
+    for (uint16_t i = 0; i < 256; i++) {
+        if (lut.red[i] != i << 8 || lut.green[i] != i << 8 || lut.blue[i] != i << 8) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Writes a color corrected pixel to the output buffer. With
+            temporal dithering, the error pointer is moved to the next pixel.
+            Without correction the color is copied as it is. The white
+            channel of CRGBW output is not written.
+  @param    output              Output pixel (CRGB or CRGBW)
+  @param    color               Color from the frame
+  @param    lut                 Correction tables
+  @param    errors              Dither errors of the pixel
+  @returns  uint8_t             Fractions of the pixel, 0 if none
+*/
+/******************************************************************************/
+template <bool correct, bool dither, typename T, typename C>
+static inline uint8_t correctPixel(T& output, const C& color, const ColorLut& lut, uint8_t*& errors) {
+    if (!correct) {
+        output.r = color.r;
+        output.g = color.g;
+        output.b = color.b;
+        return 0;
+    }
+
+    uint16_t red = lut.red[color.r];
+    uint16_t green = lut.green[color.g];
+    uint16_t blue = lut.blue[color.b];
+
+    if (!dither) {
+        output.r = (red + 128) >> 8;
+        output.g = (green + 128) >> 8;
+        output.b = (blue + 128) >> 8;
+        return 0;
+    }
+
+    output.r = ditherChannel(red, errors[0]);
+    output.g = ditherChannel(green, errors[1]);
+    output.b = ditherChannel(blue, errors[2]);
+    errors += 3;
+
+    return (red | green | blue) & 0xFF;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Copies consecutive pixels without correction, channel by channel
+            if the output has another layout (CRGBW).
+  @param    output              Output pixels
+  @param    source              First pixel to copy
+  @param    length              Number of pixels
+*/
+/******************************************************************************/
+template <typename T, typename C>
+static inline void copyPixels(T output[], const C source[], uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
+        output[i].r = source[i].r;
+        output[i].g = source[i].g;
+        output[i].b = source[i].b;
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Copies consecutive pixels of the same layout as a block.
+  @param    output              Output pixels
+  @param    source              First pixel to copy
+  @param    length              Number of pixels
+*/
+/******************************************************************************/
+template <typename C>
+static inline void copyPixels(C output[], const C source[], uint16_t length) {
+    memcpy(output, source, length * sizeof(C));
+}
+
+/******************************************************************************/
+/*!
+  @brief    Copies a frame into an output buffer, run by run. Color correction
+            and dithering are done in the same pass, so every output pixel is
+            touched once. Without correction, copy runs are block copies.
+  @param    output              Output buffer (CRGB or CRGBW)
+  @param    frame               Frame to copy
+  @param    runs                Compiled pixel addressing
+  @param    numberOfRuns        Number of runs
+  @param    addresses           Address table, for the gather runs
+  @param    lut                 Correction tables, unused without correction
+  @param    errors              Dither errors, 3 per output LED, unused without dithering
+  @returns  uint8_t             Not 0 if the frame had fractions to dither
+*/
+/******************************************************************************/
+template <bool correct, bool dither, typename T, typename C>
+static uint8_t remapRuns(T output[], const C frame[], const PixelRun runs[], uint16_t numberOfRuns, const uint16_t addresses[], const ColorLut& lut, uint8_t errors[]) {
+    uint8_t residue = 0;
+    T* out = output;
+
+    for (uint16_t r = 0; r < numberOfRuns; r++) {
+        const PixelRun& run = runs[r];
+
+        /* Source of a gather run is an index in the address table, not a pixel */
+        if (run.type == PIXEL_RUN_GATHER) {
+            for (uint16_t i = 0; i < run.length; i++) {
+                residue |= correctPixel<correct, dither>(out[i], frame[addresses[run.source + i]], lut, errors);
+            }
+            out += run.length;
+            continue;
+        }
+
+        const C* source = &frame[run.source];
+
+        switch (run.type) {
+            case PIXEL_RUN_COPY:
+                if (!correct) {
+                    copyPixels(out, source, run.length);
+                    break;
+                }
+                for (uint16_t i = 0; i < run.length; i++) {
+                    residue |= correctPixel<correct, dither>(out[i], source[i], lut, errors);
+                }
+                break;
+            case PIXEL_RUN_REVERSE:
+                for (uint16_t i = 0; i < run.length; i++) {
+                    residue |= correctPixel<correct, dither>(out[i], *(source - i), lut, errors);
+                }
+                break;
+            case PIXEL_RUN_REPEAT:
+                for (uint16_t i = 0; i < run.length; i++) {
+                    residue |= correctPixel<correct, dither>(out[i], *source, lut, errors);
+                }
+                break;
+            default:
+                break;
+        }
+        out += run.length;
+    }
+
+    return residue;
+}
+#endif
@@ -0,0 +1,85 @@
+/******************************************************************************/
+/*
+ * File:    Random.cpp
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * 
+ * Brief:   Fast pseudo random number generator for the effects (xorshift32).
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#include "Random.h"
+
+/******************************************************************************/
+/*!
+  @brief    Constructor.
+  @param    seed                Seed of the generator
+*/
+/******************************************************************************/
+Random::Random(uint32_t seed) {
+    this->seed(seed);
+}
+
+/******************************************************************************/
+/*!
+  @brief    Restarts the sequence of the generator. The same seed gives the
+            same sequence.
+  @param    seed                Seed, 0 is replaced by RANDOM_DEFAULT_SEED
+*/
+/******************************************************************************/
+void Random::seed(uint32_t seed) {
+    _state = seed != 0 ? seed : RANDOM_DEFAULT_SEED;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Fills the buffer with random bytes, four bytes per number.
+  @param    buffer              Buffer to fill
+  @param    length              Number of bytes
+*/
+/******************************************************************************/
+void Random::randomBytes(uint8_t buffer[], size_t length) {
+    size_t i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        uint32_t value = next();
+        buffer[i] = value;
+        buffer[i + 1] = value >> 8;
+        buffer[i + 2] = value >> 16;
+        buffer[i + 3] = value >> 24;
+    }
+
+    if (i < length) {
+        uint32_t value = next();
+        for (; i < length; i++) {
+            buffer[i] = value;
+            value >>= 8;
+        }
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns 32 random bits, each set with the specified probability.
+            Used to pick a random part of 32 LEDs at once.
+  @param    probability         Probability of a set bit, in 1/256
+  @returns  uint32_t            Mask
+*/
+/******************************************************************************/
+uint32_t Random::bernoulliMask(uint8_t probability) {
+    uint32_t mask = 0;
+
+    for (uint8_t i = 0; i < 32; i += 4) {
+        uint32_t value = next();
+
+        for (uint8_t j = 0; j < 4; j++) {
+            if ((uint8_t) (value >> (j * 8)) < probability) {
+                mask |= 1UL << (i + j);
+            }
+        }
+    }
+
+    return mask;
+}
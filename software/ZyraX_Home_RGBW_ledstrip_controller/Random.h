@@ -0,0 +1,49 @@
+/******************************************************************************/
+/*
+ * File:    Random.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * 
+ * Brief:   Fast pseudo random number generator for the effects (xorshift32).
+ *          Every segment has its own generator, so the random numbers of a
+ *          mode only depend on its seed. With a fixed seed, the effects are
+ *          reproducible.
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef RANDOM_H
+#define RANDOM_H
+#include "stdint.h"                                                             //For size defined int types
+#include "stddef.h"                                                             //For the size_t type
+
+#define RANDOM_DEFAULT_SEED             0x9E3779B9                              //Used for seed 0, xorshift cannot leave a zero state
+
+class Random {
+    public:
+        Random(uint32_t seed = RANDOM_DEFAULT_SEED);
+
+        void seed(uint32_t seed);
+
+        /* Inline, called per pixel */
+        uint32_t next() {
+            _state ^= _state << 13;
+            _state ^= _state >> 17;
+            _state ^= _state << 5;
+            return _state;
+        }
+        uint16_t next(uint16_t max) {                                           //0 up to max (exclusive), like random(max)
+            return ((next() >> 16) * max) >> 16;
+        }
+        uint16_t next(uint16_t min, uint16_t max) {                             //min up to max (exclusive), like random(min, max)
+            return min + next(max - min);
+        }
+
+        void randomBytes(uint8_t buffer[], size_t length);
+        uint32_t bernoulliMask(uint8_t probability);
+
+    private:
+        uint32_t _state = RANDOM_DEFAULT_SEED;
+};
+#endif
@@ -183,9 +183,10 @@ void UpdateManager::_taskUpdateSystem() {
         _nvMemory.putUChar("powerCycles", _powerCycles);
         _nvMemory.end();
 
-        _taskHandlerUpdateSystem = NULL;
-        vTaskDelete(_taskHandlerUpdateSystem);
         _sendState();
+
+        _taskHandlerUpdateSystem = NULL;
+        vTaskDelete(NULL);                                                      //Deletes this task, nothing after it runs
     }
 
     _l.logi("Files downloaded, installing firmware", false);
@@ -193,7 +194,7 @@ void UpdateManager::_taskUpdateSystem() {
     _installOtaFile();
     
     _taskHandlerUpdateSystem = NULL;
-    vTaskDelete(_taskHandlerUpdateSystem);
+    vTaskDelete(NULL);
 }
 
 /******************************************************************************/
@@ -99,6 +99,7 @@ void setup() {
         Command command;
         command.command = COMMAND_SET_MODE;
         command.parameter1 = SYSTEM_MODE_PULSES;
+        command.parameter2 = ALL_SEGMENTS;
         commandQueue.pushCommand(command);
         command.command = COMMAND_SET_POWER;
         command.parameter1 = 1;
@@ -191,10 +192,11 @@ void setConfiguration(AsyncWebServerRequest *request) {
                                         "number_of_leds",
                                         "has_sensor",
                                         "sensor_inverted",
-                                        "sensor_model"
+                                        "sensor_model",
+                                        "segments"
                                     };
 
-    if (!checkPostParameters(request, neededParameters, 9, false)) {
+    if (!checkPostParameters(request, neededParameters, 10, false)) {
         return;
     }
 
@@ -283,13 +285,21 @@ void setConfiguration(AsyncWebServerRequest *request) {
 
         if (numberOfLeds == 0) {
             l.logw("Number of leds cannot be zero, ignoring");
-        } else if (numberOfLeds >= MAX_NUMBER_LEDS) {
+        } else if (numberOfLeds > MAX_NUMBER_LEDS) {
             l.logw("Number of leds too high, ignoring");
         } else {
-            //if (numberOfLeds != strip.getNumberOfLeds()) {
-            //    needsRestart = true;
-            //}
-            strip.setPixelAddressing(addresses, numberOfLeds);
+            if (strip.setPixelAddressing(addresses, numberOfLeds)) {
+                needsRestart = true;                                            //Number of LEDs or outputs changed
+            }
+        }
+    }
+
+    if (request->hasParam("segments", true)) {
+        String segments = request->getParam("segments", true)->value();
+        l.logd("segments: " + segments);
+
+        if (strip.setSegments(segments)) {
+            needsRestart = true;
         }
     }
 
@@ -366,10 +376,6 @@ void setBrightness(AsyncWebServerRequest *request) {
         resultString = generateResponseJson(request->url(), HTTP_CODE_SERVICE_UNAVAILABLE, "Not available");
         request->send(HTTP_CODE_SERVICE_UNAVAILABLE, "application/json", resultString);
     }
-    
-    command.command = COMMAND_SET_MODE;
-    command.parameter1 = strip.getMode();
-    commandQueue.pushCommand(command);
 }
 
 /******************************************************************************/
@@ -396,7 +402,7 @@ void drawPixels(AsyncWebServerRequest *request) {
 
     deserializeJson(jsonParser, request->getParam("leds", true)->value());  //Convert JSON string to object
 
-    CRGB leds[strip.getNumberOfLeds()];
+    CRGB* leds = new CRGB[strip.getNumberOfLeds()];                             //Too big for the stack on long strips
     for (uint16_t i = 0; i < strip.getNumberOfLeds(); i++) {
         leds[i] = hexStringToRGB(jsonParser[i]);
     }
@@ -405,6 +411,7 @@ void drawPixels(AsyncWebServerRequest *request) {
     request->send(HTTP_CODE_OK, "application/json", resultString);
 
     strip.drawPixels(leds);
+    delete[] leds;
 }
 
 /******************************************************************************/
@@ -424,6 +431,11 @@ void setMode(AsyncWebServerRequest *request) {
     Command command;
     command.command = COMMAND_SET_MODE;
     command.parameter1 = (uint8_t) atoi(request->getParam("mode", true)->value().c_str());
+    command.parameter2 = ALL_SEGMENTS;
+
+    if (request->hasParam("segment", true)) {
+        command.parameter2 = (uint8_t) atoi(request->getParam("segment", true)->value().c_str());
+    }
 
     if (commandQueue.pushCommand(command)) {
         resultString = generateResponseJson(request->url(), HTTP_CODE_OK);
@@ -459,127 +471,128 @@ void configureMode(AsyncWebServerRequest *request) {
     l.logd("Mode: " + String(mode));
 
     ModeParameters parameters;
+    uint32_t parameterFlags = Ledstrip::getModeParameterFlags(mode);
     
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_MIN_COLOR_POS)) {
+    if (parameterFlags & PARAMETER_MIN_COLOR_POS) {
         if (!request->hasParam(PARAMETER_NAME_MIN_COLOR_POS, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_MIN_COLOR_POS));
         } else {
             parameters.minColorPos = (uint8_t) atoi(request->getParam(PARAMETER_NAME_MIN_COLOR_POS, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_MAX_COLOR_POS)) {
+    if (parameterFlags & PARAMETER_MAX_COLOR_POS) {
         if (!request->hasParam(PARAMETER_NAME_MAX_COLOR_POS, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_MAX_COLOR_POS));
         } else {
             parameters.maxColorPos = (uint8_t) atoi(request->getParam(PARAMETER_NAME_MAX_COLOR_POS, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_COLOR1)) {
+    if (parameterFlags & PARAMETER_COLOR1) {
         if (!request->hasParam(PARAMETER_NAME_COLOR1, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_COLOR1));
         } else {
             parameters.color1 = hexStringToRGB(request->getParam(PARAMETER_NAME_COLOR1, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_COLOR2)) {
+    if (parameterFlags & PARAMETER_COLOR2) {
         if (!request->hasParam(PARAMETER_NAME_COLOR2, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_COLOR2));
         } else {
             parameters.color2 = hexStringToRGB(request->getParam(PARAMETER_NAME_COLOR2, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_USE_GRADIENT1)) {
+    if (parameterFlags & PARAMETER_USE_GRADIENT1) {
         if (!request->hasParam(PARAMETER_NAME_USE_GRADIENT1, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_USE_GRADIENT1));
         } else {
             parameters.useGradient1 = (bool) atoi(request->getParam(PARAMETER_NAME_USE_GRADIENT1, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_USE_GRADIENT2)) {
+    if (parameterFlags & PARAMETER_USE_GRADIENT2) {
         if (!request->hasParam(PARAMETER_NAME_USE_GRADIENT2, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_USE_GRADIENT2));
         } else {
             parameters.useGradient2 = (bool) atoi(request->getParam(PARAMETER_NAME_USE_GRADIENT2, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_SEGMENT_SIZE)) {
+    if (parameterFlags & PARAMETER_SEGMENT_SIZE) {
         if (!request->hasParam(PARAMETER_NAME_SEGMENT_SIZE, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_SEGMENT_SIZE));
         } else {
             parameters.segmentSize = (uint8_t) atoi(request->getParam(PARAMETER_NAME_SEGMENT_SIZE, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_TAIL_LENGTH)) {
+    if (parameterFlags & PARAMETER_TAIL_LENGTH) {
         if (!request->hasParam(PARAMETER_NAME_TAIL_LENGTH, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_TAIL_LENGTH));
         } else {
             parameters.tailLength = (uint8_t) atoi(request->getParam(PARAMETER_NAME_TAIL_LENGTH, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_WAVE_LENGTH)) {
+    if (parameterFlags & PARAMETER_WAVE_LENGTH) {
         if (!request->hasParam(PARAMETER_NAME_WAVE_LENGTH, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_WAVE_LENGTH));
         } else {
             parameters.waveLength = (uint8_t) atoi(request->getParam(PARAMETER_NAME_WAVE_LENGTH, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_TIME_FADE)) {
+    if (parameterFlags & PARAMETER_TIME_FADE) {
         if (!request->hasParam(PARAMETER_NAME_TIME_FADE, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_TIME_FADE));
         } else {
             parameters.timeFade = (uint16_t) atoi(request->getParam(PARAMETER_NAME_TIME_FADE, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_DELAY)) {
+    if (parameterFlags & PARAMETER_DELAY) {
         if (!request->hasParam(PARAMETER_NAME_DELAY, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_DELAY));
         } else {
             parameters.delay = (uint16_t) atoi(request->getParam(PARAMETER_NAME_DELAY, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_DELAY_BETWEEN)) {
+    if (parameterFlags & PARAMETER_DELAY_BETWEEN) {
         if (!request->hasParam(PARAMETER_NAME_DELAY_BETWEEN, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_DELAY_BETWEEN));
         } else {
             parameters.delayBetween = (uint16_t) atoi(request->getParam(PARAMETER_NAME_DELAY_BETWEEN, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_RANDOMNESS_DELAY)) {
+    if (parameterFlags & PARAMETER_RANDOMNESS_DELAY) {
         if (!request->hasParam(PARAMETER_NAME_RANDOMNESS_DELAY, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_RANDOMNESS_DELAY));
         } else {
             parameters.randomnessDelay = (uint8_t) atoi(request->getParam(PARAMETER_NAME_RANDOMNESS_DELAY, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_INTENSITY)) {
+    if (parameterFlags & PARAMETER_INTENSITY) {
         if (!request->hasParam(PARAMETER_NAME_INTENSITY, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_INTENSITY));
         } else {
             parameters.intensity = (uint8_t) atoi(request->getParam(PARAMETER_NAME_INTENSITY, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_DIRECTION)) {
+    if (parameterFlags & PARAMETER_DIRECTION) {
         if (!request->hasParam(PARAMETER_NAME_DIRECTION, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_DIRECTION));
         } else {
             parameters.direction = (uint8_t) atoi(request->getParam(PARAMETER_NAME_DIRECTION, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_NUMBER_OF_ELEMENTS)) {
+    if (parameterFlags & PARAMETER_NUMBER_OF_ELEMENTS) {
         if (!request->hasParam(PARAMETER_NAME_NUMBER_OF_ELEMENTS, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_NUMBER_OF_ELEMENTS));
         } else {
             parameters.numberOfElements = (uint8_t) atoi(request->getParam(PARAMETER_NAME_NUMBER_OF_ELEMENTS, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_PALETTE)) {
+    if (parameterFlags & PARAMETER_PALETTE) {
         if (!request->hasParam(PARAMETER_NAME_PALETTE, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_PALETTE));
         } else {
             parameters.palette = (uint8_t) atoi(request->getParam(PARAMETER_NAME_PALETTE, true)->value().c_str());
         }
     }
-    if (memoryManager.modeHasParameter(mode, PARAMETER_NAME_FADE_LENGTH)) {
+    if (parameterFlags & PARAMETER_FADE_LENGTH) {
         if (!request->hasParam(PARAMETER_NAME_FADE_LENGTH, true)) {
             l.logw("Missing mode configuration parameter: " + String(PARAMETER_NAME_FADE_LENGTH));
         } else {
@@ -587,12 +600,18 @@ void configureMode(AsyncWebServerRequest *request) {
         }
     }
 
-    strip.configureMode(mode, parameters);
+    uint8_t segment = ALL_SEGMENTS;
+    if (request->hasParam("segment", true)) {
+        segment = (uint8_t) atoi(request->getParam("segment", true)->value().c_str());
+    }
+
+    strip.configureMode(mode, parameters, true, segment);
 
     if (request->hasParam("start_mode", true)) {
         Command command;
         command.command = COMMAND_SET_MODE;
         command.parameter1 = mode;
+        command.parameter2 = segment;
         commandQueue.pushCommand(command);
     }
 }
@@ -681,7 +700,7 @@ void createCommandRoutes() {
     });
 
     server.on(CMD_GET_LEDS, ASYNC_HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(HTTP_CODE_OK, "text/javascript", strip.getPixels());
+        request->send(HTTP_CODE_OK, "text/plain", strip.getPixels());
     });
     
     server.on(CMD_GET_LOGS, ASYNC_HTTP_GET, downloadLogs);
@@ -801,13 +820,31 @@ String generateStatesJSON() {
     String sdMounted = "\"sd_card_inserted\":" + (String) memoryManager.getSdMounted();
     String brightness = "\"brightness\" : " + (String) strip.getBrightness();
     String mode = "\"mode\":" + (String) strip.getMode();
+    String segmentModes = "\"segment_modes\":[";
+    for (uint8_t i = 0; i < strip.getNumberOfSegments(); i++) {
+        segmentModes += (i > 0 ? "," : "") + String(strip.getSegmentMode(i));
+    }
+    segmentModes += "]";
     String sensorState = "\"sensor_state\":" + String(localDoorState);
+    String framesSent = "\"frames_sent\":" + String(strip.getFramesSent());
+    String framesSkipped = "\"frames_skipped\":" + String(strip.getFramesSkipped());
+    String missedFrameDeadlines = "\"missed_frame_deadlines\":" + String(strip.getMissedFrameDeadlines());
+    String frameHeadroom = "\"frame_headroom\":" + String(strip.getFrameHeadroom());
+    String maxRemapTime = "\"max_remap_time\":" + String(strip.getMaxRemapTime());
+    String maxModeSwitchTime = "\"max_mode_switch_time\":" + String(strip.getMaxModeSwitchTime());
 
     String jsonString = "{" + power;
     jsonString += ", " + sdMounted;
     jsonString += ", " + brightness;
     jsonString += ", " + mode;
-    jsonString += ", " + sensorState + "}";
+    jsonString += ", " + segmentModes;
+    jsonString += ", " + sensorState;
+    jsonString += ", " + framesSent;
+    jsonString += ", " + framesSkipped;
+    jsonString += ", " + missedFrameDeadlines;
+    jsonString += ", " + frameHeadroom;
+    jsonString += ", " + maxRemapTime;
+    jsonString += ", " + maxModeSwitchTime + "}";
 
     return jsonString;
 }
@@ -827,6 +864,7 @@ String generateConfigurationJSON() {
     String sensorEnabledStr = "\"has_sensor\":" + String(sensorEnabled);
     String sensorInvertedStr = "\"sensor_inverted\":" + String(sensorInverted);
     String sensorModelStr = "\"sensor_model\":" + String(sensorModel);
+    String segments = "\"segments\":" + strip.getSegments();
 
     String jsonString = "{" + idString;
     jsonString += ", " + hostname;
@@ -836,7 +874,8 @@ String generateConfigurationJSON() {
     jsonString += ", " + firmwareVersion;
     jsonString += ", " + sensorEnabledStr;
     jsonString += ", " + sensorInvertedStr;
-    jsonString += ", " + sensorModelStr + "}";
+    jsonString += ", " + sensorModelStr;
+    jsonString += ", " + segments + "}";
 
     l.logd(jsonString);
     return jsonString;
@@ -851,7 +890,7 @@ String generateModeConfigurationJSON() {
     String jsonString = "[";
 
     for (uint8_t mode = 1; mode < NUM_MODES; mode++) {
-        String modeString = memoryManager.getModeJsonString(mode);
+        String modeString = memoryManager.getModeJsonString(mode, Ledstrip::getModeParameterFlags(mode));
         jsonString += modeString;
 
         if (mode < NUM_MODES-1) {
@@ -980,22 +1019,18 @@ void executeCommands(void *parameters) {
             case COMMAND_SET_POWER:
                 strip.setPower((bool) command.parameter1);
                 commandQueue.popCommand();
-                while (strip.getState() != _READY_TO_RUN && strip.getState() != _LOOPING) continue;
                 break;
             case COMMAND_SET_BRIGHTNESS:
                 strip.setBrightness((uint8_t) command.parameter1);
                 commandQueue.popCommand();
-                while (strip.getState() != _READY_TO_RUN && strip.getState() != _LOOPING) continue;
                 break;
             case COMMAND_SET_MODE:
-                strip.setMode((uint8_t) command.parameter1);
+                strip.setMode((uint8_t) command.parameter1, (uint8_t) command.parameter2);
                 commandQueue.popCommand();
-                while (strip.getState() != _READY_TO_RUN && strip.getState() != _LOOPING) continue;
                 break;
             case COMMAND_DOOR_CHANGE:
                 strip.doorHandler((bool) command.parameter1);
                 commandQueue.popCommand();
-                while (strip.getState() != _READY_TO_RUN && strip.getState() != _LOOPING && strip.getState() != _WAIT_FOR_DOOR_CLOSED) continue;
                 break;
             
             default:
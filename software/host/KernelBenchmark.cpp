@@ -0,0 +1,435 @@
+/******************************************************************************/
+/*
+ * File:    KernelBenchmark.cpp
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * 
+ * Brief:   Host checks and benchmark of the pixel kernels in PixelKernels.h,
+ *          the same code the controller runs. Measures the fixed point
+ *          blend against the float blend it replaced, the Q8.8 fade, and
+ *          the color corrected remap against the plain per-pixel gather of
+ *          the old output stage, for several strip lengths and layouts.
+ *          Times are per frame, on the host, so only the ratios carry over
+ *          to the ESP32.
+ * 
+ *          Usage:
+ *          make bench
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#include "stdint.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include "time.h"
+
+/* Same layout as the FastLED types */
+struct CRGB {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+
+    CRGB() {}
+    CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+};
+
+struct CRGBW {
+    uint8_t g;
+    uint8_t r;
+    uint8_t b;
+    uint8_t w;
+};
+
+#include "PixelKernels.h"
+
+#define BENCHMARK_GAMMA         2.2                                             //Gamma of the host tables, the values do not change the timing
+#define BENCHMARK_FRAME_LEDS    250000                                          //LEDs processed per measurement, so short strips run more frames
+#define DITHER_FRAMES           256                                             //Frames for the dither average to be exact
+
+/* Measured kernels */
+#define KERNEL_BLEND_FLOAT      0
+#define KERNEL_BLEND_FIXED      1
+#define KERNEL_FADE             2
+#define KERNEL_GATHER           3
+#define KERNEL_REMAP_COPY       4                                               //Identity tables, no correction
+#define KERNEL_REMAP            5
+#define KERNEL_REMAP_DITHERED   6
+#define KERNEL_REMAP_RGBW_DITHERED 7
+
+/* Address layouts */
+#define LAYOUT_IDENTITY         0
+#define LAYOUT_MIRRORED         1
+#define LAYOUT_SCATTERED        2
+
+struct Benchmark {
+    const char* name;
+    uint8_t kernel;
+    uint8_t layout;
+};
+
+static const Benchmark BENCHMARKS[] = {
+    {"blend, float (old)", KERNEL_BLEND_FLOAT, LAYOUT_IDENTITY},
+    {"blend, fixed point", KERNEL_BLEND_FIXED, LAYOUT_IDENTITY},
+    {"fade, Q8.8", KERNEL_FADE, LAYOUT_IDENTITY},
+    {"gather per pixel, RGB (old)", KERNEL_GATHER, LAYOUT_IDENTITY},
+    {"remap identity, uncorrected", KERNEL_REMAP_COPY, LAYOUT_IDENTITY},
+    {"remap scattered, uncorrected", KERNEL_REMAP_COPY, LAYOUT_SCATTERED},
+    {"remap identity, RGB", KERNEL_REMAP, LAYOUT_IDENTITY},
+    {"remap mirrored, RGB", KERNEL_REMAP, LAYOUT_MIRRORED},
+    {"remap scattered, RGB", KERNEL_REMAP, LAYOUT_SCATTERED},
+    {"remap identity, RGB, dithered", KERNEL_REMAP_DITHERED, LAYOUT_IDENTITY},
+    {"remap scattered, RGBW, dithered", KERNEL_REMAP_RGBW_DITHERED, LAYOUT_SCATTERED}
+};
+
+static const uint16_t LED_COUNTS[] = {250, 1000, 4000};
+
+static uint16_t failures = 0;
+static ColorLut lut;
+
+/******************************************************************************/
+/*!
+  @brief    Counts and prints a failed check.
+  @param    condition           Result of the check
+  @param    description         What was checked
+*/
+/******************************************************************************/
+static void check(bool condition, const char* description) {
+    if (!condition) {
+        printf("FAIL: %s\n", description);
+        failures++;
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Keeps the compiler from removing or hoisting the measured work.
+  @param    data                Output of the measured work
+*/
+/******************************************************************************/
+static inline void keep(void* data) {
+    asm volatile("" : : "g"(data) : "memory");
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns a monotonic time stamp.
+  @returns  double              Time, in us
+*/
+/******************************************************************************/
+static double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e6 + time.tv_nsec / 1e3;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Pseudo random numbers, fixed sequence so runs are comparable.
+  @returns  uint32_t            Random number
+*/
+/******************************************************************************/
+static uint32_t nextRandom() {
+    static uint32_t state = 12345;
+    state = state * 1664525 + 1013904223;
+    return state >> 8;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Blend of the previous versions, double precision with rounding.
+  @param    color1              First color
+  @param    color1Portion       Portion of color 1, 0.0 - 1.0
+  @param    color2              Second color
+  @returns  CRGB                Blended color
+*/
+/******************************************************************************/
+static CRGB blendColorsFloat(CRGB color1, float color1Portion, CRGB color2) {
+    float portion2 = 1.0 - color1Portion;
+    uint8_t r = round(color1.r * color1Portion * 1.0 + color2.r * portion2 * 1.0);
+    uint8_t g = round(color1.g * color1Portion * 1.0 + color2.g * portion2 * 1.0);
+    uint8_t b = round(color1.b * color1Portion * 1.0 + color2.b * portion2 * 1.0);
+
+    return CRGB(r, g, b);
+}
+
+__attribute__((noinline)) static void blendFloatFrame(CRGB leds[], const CRGB colors1[], const CRGB colors2[], const uint8_t alphas[], uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
+        leds[i] = blendColorsFloat(colors2[i], alphas[i] / 255.0, colors1[i]);
+    }
+}
+
+__attribute__((noinline)) static void blendFixedFrame(CRGB leds[], const CRGB colors1[], const CRGB colors2[], const uint8_t alphas[], uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
+        leds[i] = blendColors(colors1[i], colors2[i], alphas[i]);
+    }
+}
+
+/* Output stage of the previous versions, one gather per pixel without correction */
+template <typename T>
+__attribute__((noinline)) static void gatherFrame(T output[], const CRGB frame[], const uint16_t addresses[], uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
+        const CRGB& color = frame[addresses[i]];
+        output[i].r = color.r;
+        output[i].g = color.g;
+        output[i].b = color.b;
+    }
+}
+
+template <bool correct, bool dither, typename T>
+__attribute__((noinline)) static uint8_t remapFrame(T output[], const CRGB frame[], const PixelRun runs[], uint16_t numberOfRuns, const uint16_t addresses[], uint8_t errors[]) {
+    return remapRuns<correct, dither>(output, frame, runs, numberOfRuns, addresses, lut, errors);
+}
+
+/******************************************************************************/
+/*!
+  @brief    Fills the correction tables like makeColorLut() does, with one
+            gamma for all channels and a white white point.
+*/
+/******************************************************************************/
+static void fillColorLut() {
+    for (uint16_t i = 0; i < 256; i++) {
+        uint16_t value = (uint16_t) (pow(i / 255.0, BENCHMARK_GAMMA) * 255 * 256 + 0.5);
+        lut.red[i] = value;
+        lut.green[i] = value;
+        lut.blue[i] = value;
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Fills the address table of a layout.
+  @param    addresses           Address table
+  @param    length              Number of LEDs
+  @param    layout              LAYOUT_x
+*/
+/******************************************************************************/
+static void fillAddresses(uint16_t addresses[], uint16_t length, uint8_t layout) {
+    for (uint16_t i = 0; i < length; i++) {
+        addresses[i] = layout == LAYOUT_MIRRORED ? length - 1 - i : i;
+    }
+
+    if (layout == LAYOUT_SCATTERED) {
+        for (uint16_t i = length - 1; i > 0; i--) {
+            uint16_t j = nextRandom() % (i + 1);
+            uint16_t address = addresses[i];
+            addresses[i] = addresses[j];
+            addresses[j] = address;
+        }
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Checks the kernels against the definitions they replace.
+*/
+/******************************************************************************/
+static void runChecks() {
+    uint8_t maxDifference = 0;
+    bool isExact = true;
+
+    /* Blend */
+    for (uint32_t i = 0; i < 100000; i++) {
+        CRGB color1(nextRandom(), nextRandom(), nextRandom());
+        CRGB color2(nextRandom(), nextRandom(), nextRandom());
+        uint8_t alpha = nextRandom();
+        CRGB fixed = blendColors(color1, color2, alpha);
+        CRGB first = blendColors(color1, color2, 0);
+        CRGB second = blendColors(color1, color2, 255);
+
+        isExact &= memcmp(&first, &color1, sizeof(CRGB)) == 0 && memcmp(&second, &color2, sizeof(CRGB)) == 0;
+        CRGB reference = blendColorsFloat(color2, alpha / 255.0, color1);
+
+        for (uint8_t c = 0; c < 3; c++) {
+            uint8_t difference = abs((&fixed.r)[c] - (&reference.r)[c]);
+            if (difference > maxDifference) {
+                maxDifference = difference;
+            }
+        }
+    }
+    check(isExact, "blend at alpha 0 and 255 is exactly color 1 and color 2");
+    check(maxDifference <= 1, "fixed point blend is within 1 of the float blend");
+
+    /* Fade */
+    uint8_t from[100];
+    uint8_t to[100];
+    uint8_t out[100];
+    bool isBetween = true;
+
+    for (uint8_t i = 0; i < sizeof(from); i++) {
+        from[i] = nextRandom();
+        to[i] = nextRandom();
+    }
+
+    fadeChannels(out, from, to, 0, sizeof(out));
+    check(memcmp(out, from, sizeof(out)) == 0, "fade at progress 0 is the start");
+    fadeChannels(out, from, to, FADE_PROGRESS_END, sizeof(out));
+    check(memcmp(out, to, sizeof(out)) == 0, "fade at the end is the end");
+
+    for (uint16_t progress = 0; progress <= FADE_PROGRESS_END; progress++) {
+        fadeChannels(out, from, to, progress, sizeof(out));
+        for (uint8_t i = 0; i < sizeof(out); i++) {
+            isBetween &= out[i] >= (from[i] < to[i] ? from[i] : to[i]) && out[i] <= (from[i] > to[i] ? from[i] : to[i]);
+        }
+    }
+    check(isBetween, "fade stays between the endpoints");
+    check(getFadeProgress(0, 500) == 0 && getFadeProgress(250, 500) == 128 && getFadeProgress(600, 500) == FADE_PROGRESS_END, "fade progress");
+
+    /* Dither, the sum over DITHER_FRAMES frames is the 8.8 value */
+    isExact = true;
+    for (uint32_t value = 0; value <= 0xFF00; value++) {
+        uint8_t error = 0;
+        uint32_t sum = 0;
+        for (uint16_t frame = 0; frame < DITHER_FRAMES; frame++) {
+            sum += ditherChannel(value, error);
+        }
+        isExact &= sum == value;
+    }
+    check(isExact, "dithered channels average to the 8.8 value");
+
+    /* Remap, runs give the same output as a corrected per-pixel gather */
+    const uint16_t length = 1000;
+    CRGB frame[length];
+    uint16_t addresses[length];
+    PixelRun runs[length];
+    CRGB output[length];
+    uint8_t errors[3 * length];
+
+    for (uint16_t i = 0; i < length; i++) {
+        frame[i] = CRGB(nextRandom(), nextRandom(), nextRandom());
+    }
+
+    for (uint8_t layout = LAYOUT_IDENTITY; layout <= LAYOUT_SCATTERED; layout++) {
+        bool isEqual = true;
+        bool isCopied = true;
+        CRGBW outputRgbw[length];
+        fillAddresses(addresses, length, layout);
+        uint16_t numberOfRuns = compilePixelRuns(addresses, length, runs);
+        remapRuns<true, false>(output, frame, runs, numberOfRuns, addresses, lut, errors);
+
+        for (uint16_t i = 0; i < length; i++) {
+            const CRGB& color = frame[addresses[i]];
+            isEqual &= output[i].r == (lut.red[color.r] + 128) >> 8;
+            isEqual &= output[i].g == (lut.green[color.g] + 128) >> 8;
+            isEqual &= output[i].b == (lut.blue[color.b] + 128) >> 8;
+        }
+
+        remapRuns<false, false>(output, frame, runs, numberOfRuns, addresses, lut, errors);
+        remapRuns<false, false>(outputRgbw, frame, runs, numberOfRuns, addresses, lut, errors);
+
+        for (uint16_t i = 0; i < length; i++) {
+            const CRGB& color = frame[addresses[i]];
+            isCopied &= memcmp(&output[i], &color, sizeof(CRGB)) == 0;
+            isCopied &= outputRgbw[i].r == color.r && outputRgbw[i].g == color.g && outputRgbw[i].b == color.b;
+        }
+
+        check(isEqual, "remapped runs match the corrected per-pixel gather");
+        check(isCopied, "uncorrected runs match the per-pixel gather");
+        check(layout == LAYOUT_SCATTERED || numberOfRuns == 1, "identity and mirrored layouts are one run");
+    }
+
+    ColorLut identity;
+    for (uint16_t i = 0; i < 256; i++) {
+        identity.red[i] = identity.green[i] = identity.blue[i] = i << 8;
+    }
+    check(isIdentityLut(identity) && !isIdentityLut(lut), "identity tables are detected");
+}
+
+/******************************************************************************/
+/*!
+  @brief    Measures the kernels for every LED count and prints a table.
+*/
+/******************************************************************************/
+static void runBenchmarks() {
+    printf("%-34s", "us per frame");
+    for (uint8_t n = 0; n < sizeof(LED_COUNTS) / sizeof(LED_COUNTS[0]); n++) {
+        printf("%7u LEDs", LED_COUNTS[n]);
+    }
+    printf("\n");
+
+    for (uint8_t k = 0; k < sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]); k++) {
+        const Benchmark& benchmark = BENCHMARKS[k];
+        printf("%-34s", benchmark.name);
+
+        for (uint8_t n = 0; n < sizeof(LED_COUNTS) / sizeof(LED_COUNTS[0]); n++) {
+            uint16_t length = LED_COUNTS[n];
+            uint32_t frames = BENCHMARK_FRAME_LEDS / length;
+            CRGB* colors1 = new CRGB[length];
+            CRGB* colors2 = new CRGB[length];
+            CRGB* leds = new CRGB[length];
+            CRGBW* ledsRgbw = new CRGBW[length];
+            uint8_t* alphas = new uint8_t[length];
+            uint16_t* addresses = new uint16_t[length];
+            PixelRun* runs = new PixelRun[length];
+            uint8_t* errors = new uint8_t[3 * length]();
+
+            for (uint16_t i = 0; i < length; i++) {
+                colors1[i] = CRGB(nextRandom(), nextRandom(), nextRandom());
+                colors2[i] = CRGB(nextRandom(), nextRandom(), nextRandom());
+                alphas[i] = nextRandom();
+            }
+
+            fillAddresses(addresses, length, benchmark.layout);
+            uint16_t numberOfRuns = compilePixelRuns(addresses, length, runs);
+
+            double start = now();
+            for (uint32_t f = 0; f < frames; f++) {
+                switch (benchmark.kernel) {
+                    case KERNEL_BLEND_FLOAT:
+                        blendFloatFrame(leds, colors1, colors2, alphas, length);
+                        break;
+                    case KERNEL_BLEND_FIXED:
+                        blendFixedFrame(leds, colors1, colors2, alphas, length);
+                        break;
+                    case KERNEL_FADE:
+                        fadeChannels((uint8_t*) leds, (uint8_t*) colors1, (uint8_t*) colors2, f & 0xFF, length * sizeof(CRGB));
+                        break;
+                    case KERNEL_GATHER:
+                        gatherFrame(leds, colors1, addresses, length);
+                        break;
+                    case KERNEL_REMAP_COPY:
+                        remapFrame<false, false>(leds, colors1, runs, numberOfRuns, addresses, errors);
+                        break;
+                    case KERNEL_REMAP:
+                        remapFrame<true, false>(leds, colors1, runs, numberOfRuns, addresses, errors);
+                        break;
+                    case KERNEL_REMAP_DITHERED:
+                        remapFrame<true, true>(leds, colors1, runs, numberOfRuns, addresses, errors);
+                        break;
+                    case KERNEL_REMAP_RGBW_DITHERED:
+                        remapFrame<true, true>(ledsRgbw, colors1, runs, numberOfRuns, addresses, errors);
+                        break;
+                    default:
+                        break;
+                }
+                keep(leds);
+                keep(ledsRgbw);
+            }
+            printf("%12.2f", (now() - start) / frames);
+
+            delete[] colors1;
+            delete[] colors2;
+            delete[] leds;
+            delete[] ledsRgbw;
+            delete[] alphas;
+            delete[] addresses;
+            delete[] runs;
+            delete[] errors;
+        }
+        printf("\n");
+    }
+}
+
+int main() {
+    fillColorLut();
+    runChecks();
+    printf("%s: kernel checks, %u failures\n\n", failures == 0 ? "PASS" : "FAIL", failures);
+    if (failures > 0) {
+        return 1;
+    }
+
+    runBenchmarks();
+    return 0;
+}
@@ -0,0 +1,249 @@
+/******************************************************************************/
+/*
+ * File:    LedstripHarness.cpp
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * 
+ * Brief:   Host harness of the strip renderer. Ledstrip.cpp is built against
+ *          the shims in shims/ and renders into a RecordingOutputDriver, with
+ *          the render and output tasks running as threads. Without
+ *          arguments, it runs every mode and checks the frames. With a path,
+ *          the frames are also recorded, so they can be converted to a PPM
+ *          image with the OutputDriverHarness. Seekable modes are rendered
+ *          at a fixed time on a stopped clock and checked against the
+ *          checksums of their frames.
+ * 
+ *          Usage:
+ *          make test
+ *          ./LedstripHarness [recording]
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#include "stdint.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "Ledstrip.h"
+#include "HostShims.h"
+
+#define TEST_NUMBER_OF_LEDS     60
+#define TEST_DRIVER             _WS2801                                         //RGB output buffer, 3 bytes per LED
+#define TEST_MODE_TIME          200                                             //Time every mode runs, in ms
+#define TEST_SETTLE_TIMEOUT     5000                                            //Longest wait for a static frame or the end of an animation, in ms
+#define SEEK_START_TIME         100000                                          //Time the seekable modes start at, after the rest of the harness, in ms
+#define SEEK_TIME               12845                                           //Time since the start the seekable modes are checked at, in ms
+#define SEEK_SEED               1                                               //Seed of esp_random(), for the random palettes of the color waves
+#define FNV_OFFSET_BASIS        2166136261UL
+#define FNV_PRIME               16777619UL
+
+/* Checksums of the frames of the seekable modes at SEEK_TIME, with the default parameters */
+struct SeekCheck {
+    uint8_t mode;
+    uint32_t checksum;
+};
+
+static const SeekCheck seekChecks[] = {
+    {MODE_FADE, 0xB0135381},
+    {MODE_GRADIENT, 0xCD9FEC31},
+    {MODE_BLINK, 0x67E36CD5},
+    {MODE_THEATER, 0xF449CE13},
+    {MODE_SINE, 0xAA920D01},
+    {MODE_SWEEP, 0xF56F61B4},
+    {MODE_COLOR_WAVES, 0x0D238FF4}
+};
+
+static uint16_t failures = 0;
+
+/******************************************************************************/
+/*!
+  @brief    Counts and prints a failed check.
+  @param    condition           Result of the check
+  @param    description         What was checked
+*/
+/******************************************************************************/
+static void check(bool condition, const char* description) {
+    if (!condition) {
+        printf("FAIL: %s\n", description);
+        failures++;
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Waits until the strip has nothing left to animate, so no more
+            frames are sent.
+  @param    strip               Strip
+  @returns  bool                False if the strip is still animating after
+                                TEST_SETTLE_TIMEOUT
+*/
+/******************************************************************************/
+static bool waitUntilStatic(Ledstrip &strip) {
+    for (uint16_t time = 0; time < TEST_SETTLE_TIMEOUT; time += 10) {
+        if (strip.getState() == _READY_TO_RUN) {
+            vTaskDelay(pdMS_TO_TICKS(50));                                      //Output task sends the last frame
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return false;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Checks that every output LED is the color corrected pixel of the
+            last sent frame.
+  @param    strip               Strip
+  @param    output              Last frame of the output driver
+*/
+/******************************************************************************/
+static void checkOutput(Ledstrip &strip, const uint8_t output[]) {
+    const ColorLut &lut = COLOR_LUTS[TEST_DRIVER];
+    CRGB pixels[TEST_NUMBER_OF_LEDS];
+    bool isCorrected = true;
+
+    check(strip.getPixels(pixels, TEST_NUMBER_OF_LEDS) == TEST_NUMBER_OF_LEDS, "last frame can be read");
+
+    for (uint16_t i = 0; i < TEST_NUMBER_OF_LEDS; i++) {
+        isCorrected &= output[3 * i] == (lut.red[pixels[i].r] + 128) >> 8;
+        isCorrected &= output[3 * i + 1] == (lut.green[pixels[i].g] + 128) >> 8;
+        isCorrected &= output[3 * i + 2] == (lut.blue[pixels[i].b] + 128) >> 8;
+    }
+    check(isCorrected, "output is the color corrected frame");
+}
+
+/******************************************************************************/
+/*!
+  @brief    Starts the mode on a stopped clock and moves the clock to the
+            specified times since the start, one frame per time.
+  @param    strip               Strip
+  @param    mode                Mode ID
+  @param    times               Times since the start of the mode, in ms
+  @param    numberOfTimes       Number of times
+  @returns  uint32_t            FNV-1a checksum of the frame at the last time,
+                                0 if the frame was not presented
+*/
+/******************************************************************************/
+static uint32_t renderAt(Ledstrip &strip, uint8_t mode, const uint32_t times[], uint8_t numberOfTimes) {
+    CRGB pixels[TEST_NUMBER_OF_LEDS];
+    uint32_t checksum = FNV_OFFSET_BASIS;
+
+    stopHostClock(SEEK_START_TIME);
+    seedHostRandom(SEEK_SEED);
+    strip.setMode(mode);
+
+    for (uint8_t i = 0; i < numberOfTimes; i++) {
+        uint32_t framesPresented = strip.getFramesSent() + strip.getFramesSkipped();   //Identical frames are skipped
+        uint16_t time = 0;
+
+        stopHostClock(SEEK_START_TIME + times[i]);
+
+        /* The frame at the time is presented when the crossfade into the mode ended and a frame followed */
+        while (strip.getFramesSent() + strip.getFramesSkipped() == framesPresented || strip.getState() == _FADE_TO_MODE) {
+            if (time >= TEST_SETTLE_TIMEOUT) {
+                return 0;
+            }
+            vTaskDelay(pdMS_TO_TICKS(10));
+            time += 10;
+        }
+        vTaskDelay(pdMS_TO_TICKS(50));                                          //Output task publishes the frame
+    }
+
+    strip.getPixels(pixels, TEST_NUMBER_OF_LEDS);
+    const uint8_t* bytes = (const uint8_t *) pixels;
+
+    for (uint16_t i = 0; i < sizeof(pixels); i++) {
+        checksum = (checksum ^ bytes[i]) * FNV_PRIME;
+    }
+
+    return checksum;
+}
+
+int main(int argc, char* argv[]) {
+    uint8_t output[3 * TEST_NUMBER_OF_LEDS];
+    RecordingOutputDriver driver(output, sizeof(output));
+    Preferences preferences;
+
+    if (argc > 1 && !driver.open(argv[1])) {
+        printf("Cannot write %s\n", argv[1]);
+        return 1;
+    }
+
+    /* Configured like a controller, the strip reads it from non-volatile memory */
+    preferences.begin(NV_MEM_CONFIG);
+    preferences.putUChar("driver", TEST_DRIVER);
+    preferences.putUShort("numberLeds", TEST_NUMBER_OF_LEDS);
+    preferences.putUChar("mode", MODE_COLOR);
+    preferences.end();
+
+    Ledstrip* strip = new Ledstrip();                                           //Never destructed, the tasks keep running until exit
+    strip->setOutputDriver(&driver);
+    strip->initialize();
+
+    check(strip->getNumberOfLeds() == TEST_NUMBER_OF_LEDS, "number of LEDs is configured");
+    check(waitUntilStatic(*strip), "color mode becomes static");
+    check(driver.getNumberOfFrames() > 0, "frames are sent to the output driver");
+    checkOutput(*strip, output);
+
+    /* Every mode renders frames, animated modes keep sending them */
+    for (uint8_t mode = MODE_COLOR; mode < NUM_MODES; mode++) {
+        uint32_t framesSent = strip->getFramesSent();
+
+        strip->setMode(mode);
+        vTaskDelay(pdMS_TO_TICKS(TEST_MODE_TIME));
+
+        char description[64];
+        snprintf(description, sizeof(description), "mode %u sends frames", mode);
+        check(strip->getMode() == mode && strip->getFramesSent() > framesSent, description);
+    }
+
+    /* A drawing is sent as it is */
+    CRGB drawing[TEST_NUMBER_OF_LEDS];
+    CRGB pixels[TEST_NUMBER_OF_LEDS];
+
+    for (uint16_t i = 0; i < TEST_NUMBER_OF_LEDS; i++) {
+        drawing[i] = CRGB(i * 4, 255 - i * 4, i);
+    }
+    strip->setMode(MODE_DRAWING);
+    strip->drawPixels(drawing);
+    check(waitUntilStatic(*strip), "drawing becomes static");
+    strip->getPixels(pixels, TEST_NUMBER_OF_LEDS);
+    check(memcmp(pixels, drawing, sizeof(drawing)) == 0, "drawing is sent");
+    checkOutput(*strip, output);
+
+    /* Power animation ends in a black frame */
+    strip->setPower(false);
+    check(waitUntilStatic(*strip), "power animation ends");
+
+    bool isBlack = true;
+    for (uint16_t i = 0; i < sizeof(output); i++) {
+        isBlack &= output[i] == 0;
+    }
+    check(!strip->getPower() && isBlack, "strip is black when off");
+
+    /* Seekable modes render the same frame at a time, whether it is reached at once or in steps */
+    const uint32_t seekTime[] = {SEEK_TIME};
+    const uint32_t seekSteps[] = {SEEK_TIME / 3, SEEK_TIME * 2 / 3 + 7, SEEK_TIME};
+
+    strip->setPower(true);
+
+    for (uint8_t i = 0; i < sizeof(seekChecks) / sizeof(seekChecks[0]); i++) {
+        uint8_t mode = seekChecks[i].mode;
+        uint32_t checksum = renderAt(*strip, mode, seekTime, 1);
+        uint32_t steppedChecksum = renderAt(*strip, mode, seekSteps, 3);
+
+        char description[96];
+        snprintf(description, sizeof(description), "mode %u at %u ms has checksum %08X, expected %08X", mode, SEEK_TIME, checksum, seekChecks[i].checksum);
+        check(checksum == seekChecks[i].checksum, description);
+
+        snprintf(description, sizeof(description), "mode %u at %u ms is the same in steps", mode, SEEK_TIME);
+        check(checksum != 0 && checksum == steppedChecksum, description);
+    }
+
+    driver.close();
+    printf("%s: %u frames sent, %u failures\n", failures == 0 ? "PASS" : "FAIL", strip->getFramesSent(), failures);
+
+    fflush(stdout);
+    _Exit(failures == 0 ? 0 : 1);                                               //The tasks do not end, so the strip is not destructed
+}
@@ -0,0 +1,196 @@
+/******************************************************************************/
+/*
+ * File:    ModeBenchmark.cpp
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * 
+ * Brief:   Host benchmark of the modes at 250, 1000 and 4000 LEDs. Every
+ *          frame runs the work of the render and output task: the step of
+ *          the mode, compositing and the color corrected remap into the
+ *          output buffer of an SK6812 strip. The clock of the modes is
+ *          stopped and moved to every step, so each frame renders one
+ *          step. Times are per frame, on the host, so only the scaling
+ *          carries over to the ESP32. The last row is the time to clock the
+ *          frame out to an SK6812 strip, the limit of the hardware.
+ * 
+ *          Usage:
+ *          make bench
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#include "stdint.h"
+#include "stdio.h"
+#include "time.h"
+#include "Ledstrip.h"
+#include "HostShims.h"
+
+#define BENCHMARK_FRAME_LEDS    250000                                          //LEDs rendered per measurement, so short strips run more frames
+#define BENCHMARK_START_TIME    100000                                          //Time the modes start at, in ms
+#define WARM_UP_FRAMES          1000                                            //Most frames to end the crossfade into the mode
+#define STATIC_FRAME_TIME       (1000 / DEFAULT_FRAME_RATE)                     //Time between frames of a static mode, in ms
+#define SK6812_LED_TIME         40                                              //32 bits of 1.25 us per LED
+#define SK6812_RESET_TIME       80                                              //Latch time after a frame, in us
+
+static const uint16_t LED_COUNTS[] = {250, 1000, 4000};
+
+static double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e6 + time.tv_nsec / 1e3;
+}
+
+/* Friend of the strip, so it can run the render stages without the tasks */
+class ModeBenchmark {
+  public:
+    static double measureMode(Ledstrip &strip, uint8_t mode);
+    static const char* getModeName(uint8_t mode);
+
+  private:
+    static void renderFrame(Ledstrip &strip, CRGB frame[], TickType_t time);
+    static TickType_t getNextFrameTime(Ledstrip &strip, TickType_t time);
+};
+
+/******************************************************************************/
+/*!
+  @brief    Renders one frame of the first segment at the specified time,
+            like the render task, and remaps it like the output task.
+  @param    strip               Strip, its tasks waiting for messages
+  @param    frame               Frame to composite into
+  @param    time                Time of the frame, in ticks
+*/
+/******************************************************************************/
+void ModeBenchmark::renderFrame(Ledstrip &strip, CRGB frame[], TickType_t time) {
+    Segment &segment = strip._segments[0];
+
+    if (segment.state.phase != SEGMENT_IDLE && (int32_t) (time - segment.state.nextFrameTime) >= 0) {
+        if (!strip._renderSegment(segment, time)) {
+            segment.state.phase = SEGMENT_IDLE;
+        }
+    }
+    if (segment.isTransitioning) {
+        strip._renderTransition(segment, time);
+    }
+
+    strip._compositeFrame(frame);
+    strip._remapFrame(frame);
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns the time of the next frame of the first segment, the
+            next step of its mode.
+  @param    strip               Strip
+  @param    time                Time of the last frame, in ticks
+  @returns  TickType_t          Time of the next frame, in ticks
+*/
+/******************************************************************************/
+TickType_t ModeBenchmark::getNextFrameTime(Ledstrip &strip, TickType_t time) {
+    Segment &segment = strip._segments[0];
+
+    if (segment.state.phase == SEGMENT_IDLE || segment.isTransitioning) {
+        return time + pdMS_TO_TICKS(STATIC_FRAME_TIME);
+    }
+    return segment.state.nextFrameTime;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Starts the specified mode on the first segment and measures
+            it after the crossfade into the mode.
+  @param    strip               Strip, its tasks waiting for messages
+  @param    mode                Mode ID
+  @returns  double              Time per frame, in us
+*/
+/******************************************************************************/
+double ModeBenchmark::measureMode(Ledstrip &strip, uint8_t mode) {
+    Segment &segment = strip._segments[0];
+    uint16_t numberOfLeds = strip.getNumberOfLeds();
+    uint32_t frames = BENCHMARK_FRAME_LEDS / numberOfLeds;
+    CRGB* frame = new CRGB[numberOfLeds];
+    TickType_t time = pdMS_TO_TICKS(BENCHMARK_START_TIME);
+
+    stopHostClock(BENCHMARK_START_TIME);
+    segment.mode = mode;
+    strip._startSegment(segment);
+
+    for (uint16_t i = 0; i < WARM_UP_FRAMES && segment.isTransitioning; i++) {
+        renderFrame(strip, frame, time);
+        time = getNextFrameTime(strip, time);
+    }
+
+    double start = now();
+    for (uint32_t f = 0; f < frames; f++) {
+        renderFrame(strip, frame, time);
+        time = getNextFrameTime(strip, time);
+    }
+    double frameTime = (now() - start) / frames;
+
+    delete[] frame;
+    return frameTime;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns the name of the specified mode, as in the API.
+  @param    mode                Mode ID
+  @returns  const char*         Name
+*/
+/******************************************************************************/
+const char* ModeBenchmark::getModeName(uint8_t mode) {
+    return Ledstrip::_findMode(mode)->name;
+}
+
+int main() {
+    Ledstrip* strips[sizeof(LED_COUNTS) / sizeof(LED_COUNTS[0])];
+    RecordingOutputDriver driver;
+    Preferences preferences;
+
+    /* One strip per LED count, configured like a controller with the default driver */
+    for (uint8_t n = 0; n < sizeof(LED_COUNTS) / sizeof(LED_COUNTS[0]); n++) {
+        preferences.begin(NV_MEM_CONFIG);
+        preferences.putUChar("driver", _SK6812);
+        preferences.putUShort("numberLeds", LED_COUNTS[n]);
+        preferences.putUChar("mode", MODE_COLOR);
+        preferences.end();
+
+        strips[n] = new Ledstrip();                                             //Never destructed, the tasks keep running until exit
+        strips[n]->setOutputDriver(&driver);
+        strips[n]->initialize();
+    }
+
+    /* Tasks of a static strip wait for messages, so the benchmark can render on its own */
+    for (uint8_t n = 0; n < sizeof(LED_COUNTS) / sizeof(LED_COUNTS[0]); n++) {
+        while (strips[n]->getState() != _READY_TO_RUN) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));                                              //Output tasks send the last frame
+
+    printf("%-20s", "us per frame (FPS)");
+    for (uint8_t n = 0; n < sizeof(LED_COUNTS) / sizeof(LED_COUNTS[0]); n++) {
+        printf("%15u LEDs", LED_COUNTS[n]);
+    }
+    printf("\n");
+
+    for (uint8_t mode = MODE_COLOR; mode < NUM_MODES; mode++) {
+        printf("%-20s", ModeBenchmark::getModeName(mode));
+
+        for (uint8_t n = 0; n < sizeof(LED_COUNTS) / sizeof(LED_COUNTS[0]); n++) {
+            double frameTime = ModeBenchmark::measureMode(*strips[n], mode);
+            printf("%10.2f (%7.0f)", frameTime, 1e6 / frameTime);
+        }
+        printf("\n");
+    }
+
+    printf("%-20s", "sk6812 wire time");
+    for (uint8_t n = 0; n < sizeof(LED_COUNTS) / sizeof(LED_COUNTS[0]); n++) {
+        double frameTime = LED_COUNTS[n] * SK6812_LED_TIME + SK6812_RESET_TIME;
+        printf("%10.2f (%7.0f)", frameTime, 1e6 / frameTime);
+    }
+    printf("\n");
+
+    fflush(stdout);
+    _Exit(0);                                                                   //The tasks do not end, so the strips are not destructed
+}
@@ -0,0 +1,240 @@
+/******************************************************************************/
+/*
+ * File:    OutputDriverHarness.cpp
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * 
+ * Brief:   Host harness of the output drivers. Without arguments, it records
+ *          test frames with the RecordingOutputDriver, in memory and to a
+ *          file, reads the recording back and checks it. With a recording
+ *          (for example one made on the controller with
+ *          Ledstrip::setOutputDriver()), it converts the recording to a PPM
+ *          image with one row per frame.
+ * 
+ *          Usage:
+ *          make test
+ *          ./OutputDriverHarness <recording> <image.ppm> [bytes per pixel]
+ * 
+ *          Bytes per pixel is 3 for RGB strips (default), 4 for SK6812
+ *          strips (GRBW).
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#include "stdint.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "OutputDriver.h"
+
+#define TEST_NUMBER_OF_LEDS     60
+#define TEST_NUMBER_OF_FRAMES   16
+#define TEST_RECORDING_FILE     "OutputDriverHarness.bin"
+
+struct RecordedFrame {
+    uint64_t timestamp;                                                         //In us
+    uint32_t size;                                                              //In bytes
+    uint8_t brightness;
+    uint8_t* pixels;                                                            //Owned by the caller of readFrame()
+};
+
+static uint16_t failures = 0;
+
+/******************************************************************************/
+/*!
+  @brief    Counts and prints a failed check.
+  @param    condition           Result of the check
+  @param    description         What was checked
+*/
+/******************************************************************************/
+static void check(bool condition, const char* description) {
+    if (!condition) {
+        printf("FAIL: %s\n", description);
+        failures++;
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Reads the next frame of a recording.
+  @param    file                Recording
+  @param    frame               Frame, pixels are allocated with malloc()
+  @returns  bool                True if a whole frame was read
+*/
+/******************************************************************************/
+static bool readFrame(FILE* file, RecordedFrame &frame) {
+    if (fread(&frame.timestamp, sizeof(frame.timestamp), 1, file) != 1
+        || fread(&frame.size, sizeof(frame.size), 1, file) != 1
+        || fread(&frame.brightness, sizeof(frame.brightness), 1, file) != 1) {
+        return false;
+    }
+
+    frame.pixels = (uint8_t*) malloc(frame.size);
+    if (frame.pixels == NULL || fread(frame.pixels, 1, frame.size, file) != frame.size) {
+        free(frame.pixels);
+        frame.pixels = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Fills a test frame, a pattern that moves one LED per frame.
+  @param    pixels              Output buffer, RGB
+  @param    frame               Frame number
+*/
+/******************************************************************************/
+static void fillTestFrame(uint8_t pixels[], uint16_t frame) {
+    for (uint16_t i = 0; i < TEST_NUMBER_OF_LEDS; i++) {
+        pixels[3 * i] = (i + frame) * 4;
+        pixels[3 * i + 1] = 255 - i;
+        pixels[3 * i + 2] = frame;
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Records test frames in memory and to a file, then reads the file
+            back and compares it with the frames.
+  @returns  int                 Exit code, 0 if all checks passed
+*/
+/******************************************************************************/
+static int runSelfTest() {
+    uint8_t pixels[3 * TEST_NUMBER_OF_LEDS];
+    uint8_t lastFrame[3 * TEST_NUMBER_OF_LEDS];
+    RecordingOutputDriver driver(lastFrame, sizeof(lastFrame));
+
+    remove(TEST_RECORDING_FILE);
+    check(driver.open(TEST_RECORDING_FILE), "recording file opens");
+
+    for (uint16_t i = 0; i < TEST_NUMBER_OF_FRAMES; i++) {
+        fillTestFrame(pixels, i);
+        driver.setBrightness(i * 16);
+        driver.show(pixels, sizeof(pixels));
+        check(memcmp(lastFrame, pixels, sizeof(pixels)) == 0, "last frame is kept in memory");
+    }
+    driver.close();
+
+    check(driver.getNumberOfFrames() == TEST_NUMBER_OF_FRAMES, "every frame is counted");
+    check(driver.getBrightness() == (TEST_NUMBER_OF_FRAMES - 1) * 16, "brightness is kept");
+
+    FILE* file = fopen(TEST_RECORDING_FILE, "rb");
+    check(file != NULL, "recording file can be read");
+    if (file == NULL) {
+        return 1;
+    }
+
+    RecordedFrame frame;
+    uint64_t lastTimestamp = 0;
+    uint16_t numberOfFrames = 0;
+
+    while (readFrame(file, frame)) {
+        fillTestFrame(pixels, numberOfFrames);
+        check(frame.size == sizeof(pixels), "frame size is recorded");
+        check(frame.brightness == numberOfFrames * 16, "brightness is recorded with the frame");
+        check(frame.timestamp >= lastTimestamp, "timestamps do not go back");
+        check(frame.size == sizeof(pixels) && memcmp(frame.pixels, pixels, sizeof(pixels)) == 0, "pixels are recorded");
+
+        lastTimestamp = frame.timestamp;
+        numberOfFrames++;
+        free(frame.pixels);
+    }
+    fclose(file);
+    remove(TEST_RECORDING_FILE);
+
+    check(numberOfFrames == TEST_NUMBER_OF_FRAMES, "every frame is in the recording");
+    check(lastTimestamp == driver.getLastFrameTime(), "last timestamp matches the driver");
+
+    printf("%s: %u frames recorded, %u failures\n", failures == 0 ? "PASS" : "FAIL", numberOfFrames, failures);
+    return failures == 0 ? 0 : 1;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Converts a recording to a PPM image, one row per frame. Shorter
+            frames are padded with black. The brightness is not applied.
+  @param    recordingPath       Path of the recording
+  @param    imagePath           Path of the image
+  @param    bytesPerPixel       3 for RGB, 4 for GRBW
+  @returns  int                 Exit code, 0 if success
+*/
+/******************************************************************************/
+static int convertRecording(const char* recordingPath, const char* imagePath, uint8_t bytesPerPixel) {
+    FILE* recording = fopen(recordingPath, "rb");
+    if (recording == NULL) {
+        printf("Cannot open %s\n", recordingPath);
+        return 1;
+    }
+
+    /* First pass for the size of the image */
+    RecordedFrame frame;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    while (readFrame(recording, frame)) {
+        if (frame.size / bytesPerPixel > width) {
+            width = frame.size / bytesPerPixel;
+        }
+        height++;
+        free(frame.pixels);
+    }
+
+    if (width == 0) {
+        printf("No frames in %s\n", recordingPath);
+        fclose(recording);
+        return 1;
+    }
+
+    FILE* image = fopen(imagePath, "wb");
+    if (image == NULL) {
+        printf("Cannot write %s\n", imagePath);
+        fclose(recording);
+        return 1;
+    }
+
+    fprintf(image, "P6\n%u %u\n255\n", width, height);
+    rewind(recording);
+
+    while (readFrame(recording, frame)) {
+        for (uint32_t i = 0; i < width; i++) {
+            uint8_t rgb[3] = {0, 0, 0};
+            const uint8_t* pixel = &frame.pixels[i * bytesPerPixel];
+
+            if ((i + 1) * bytesPerPixel <= frame.size) {
+                rgb[0] = bytesPerPixel == 4 ? pixel[1] : pixel[0];
+                rgb[1] = bytesPerPixel == 4 ? pixel[0] : pixel[1];
+                rgb[2] = pixel[2];
+            }
+            fwrite(rgb, 1, sizeof(rgb), image);
+        }
+        free(frame.pixels);
+    }
+
+    fclose(recording);
+    fclose(image);
+    printf("%u frames of %u LEDs written to %s\n", height, width, imagePath);
+
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 1) {
+        return runSelfTest();
+    }
+
+    if (argc < 3) {
+        printf("Usage: %s [<recording> <image.ppm> [bytes per pixel]]\n", argv[0]);
+        return 1;
+    }
+
+    uint8_t bytesPerPixel = argc > 3 ? atoi(argv[3]) : 3;
+    if (bytesPerPixel != 3 && bytesPerPixel != 4) {
+        printf("Bytes per pixel is 3 (RGB) or 4 (GRBW)\n");
+        return 1;
+    }
+
+    return convertRecording(argv[1], argv[2], bytesPerPixel);
+}
@@ -0,0 +1,107 @@
+/******************************************************************************/
+/*
+ * File:    SwitchBenchmark.cpp
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ * 
+ * Brief:   Host benchmark of the mode switch latency. setMode() hands the
+ *          mode over to the render task as a message and returns when the
+ *          task applied it in a frame. The time setMode() blocks is measured
+ *          per switch, and getMaxModeSwitchTime() gives the longest time
+ *          until the first frame of a mode is presented. Host tasks are
+ *          threads, so the times do not carry over to the ESP32, the spread
+ *          between the shortest and longest switch does.
+ * 
+ *          Usage:
+ *          make bench
+ * 
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#include "stdint.h"
+#include "stdio.h"
+#include "time.h"
+#include "Ledstrip.h"
+
+#define NUMBER_OF_SWITCHES      200
+#define SWITCH_INTERVAL         5                                               //Time the mode runs before the next switch, in ms
+
+static const uint16_t LED_COUNTS[] = {250, 4000};
+
+/* Latencies of a series of switches */
+struct Latencies {
+    double min = 1e12;
+    double max = 0;
+    double total = 0;
+    uint16_t count = 0;
+
+    void add(double latency) {
+        min = latency < min ? latency : min;
+        max = latency > max ? latency : max;
+        total += latency;
+        count++;
+    }
+};
+
+static double now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e6 + time.tv_nsec / 1e3;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Prints a row of the latency table.
+  @param    name                Name of the row
+  @param    latencies           Latencies, in us
+*/
+/******************************************************************************/
+static void printLatencies(const char* name, const Latencies &latencies) {
+    printf("%-40s%10.1f%10.1f%10.1f\n", name, latencies.min, latencies.total / latencies.count, latencies.max);
+}
+
+int main() {
+    RecordingOutputDriver driver;
+    Preferences preferences;
+    char name[48];
+
+    printf("%-40s%10s%10s%10s\n", "us per switch", "min", "avg", "max");
+
+    for (uint8_t n = 0; n < sizeof(LED_COUNTS) / sizeof(LED_COUNTS[0]); n++) {
+        preferences.begin(NV_MEM_CONFIG);
+        preferences.putUChar("driver", _SK6812);
+        preferences.putUShort("numberLeds", LED_COUNTS[n]);
+        preferences.putUChar("mode", MODE_COLOR);
+        preferences.end();
+
+        Ledstrip* strip = new Ledstrip();                                       //Never destructed, the tasks keep running until exit
+        strip->setOutputDriver(&driver);
+        strip->initialize();
+
+        while (strip->getState() != _READY_TO_RUN) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+
+        /* Every switch starts the next animated mode, so the render task is busy when the message comes in */
+        Latencies latencies;
+        for (uint16_t i = 0; i < NUMBER_OF_SWITCHES; i++) {
+            uint8_t mode = MODE_FADE + i % (NUM_MODES - MODE_FADE);
+
+            double start = now();
+            strip->setMode(mode);
+            latencies.add(now() - start);
+
+            vTaskDelay(pdMS_TO_TICKS(SWITCH_INTERVAL));
+        }
+
+        snprintf(name, sizeof(name), "setMode(), %u LEDs", LED_COUNTS[n]);
+        printLatencies(name, latencies);
+
+        snprintf(name, sizeof(name), "until first frame, %u LEDs", LED_COUNTS[n]);
+        printf("%-40s%10s%10s%10u\n", name, "", "", strip->getMaxModeSwitchTime());
+    }
+
+    fflush(stdout);
+    _Exit(0);                                                                   //The tasks do not end, so the strips are not destructed
+}
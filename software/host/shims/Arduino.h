@@ -0,0 +1,81 @@
+/******************************************************************************/
+/*
+ * File:    Arduino.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host shim of the Arduino framework, only what the strip renderer
+ *          uses: the String object, min/max/constrain and the time functions. Like on
+ *          the ESP32, it also includes the FreeRTOS shim.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+#include "stdint.h"                                                             //For size defined int types
+#include "stddef.h"                                                             //For the size_t type
+#include "stdlib.h"
+#include "string.h"
+#include "math.h"
+#include <string>                                                               //For the storage of String
+#include <algorithm>                                                            //For min and max
+#include "freertos/FreeRTOS.h"                                                  //For the tasks, queues and semaphores
+
+using std::min;
+using std::max;
+
+#define constrain(value, low, high) ((value) < (low) ? (low) : ((value) > (high) ? (high) : (value)))
+
+typedef uint8_t byte;
+
+#ifndef PI
+#define PI                      3.1415926535897932384626433832795
+#endif
+
+#define MOSI                    11                                              //Default SPI pins of the ESP32-S3
+#define SCK                     12
+
+class String {
+  public:
+    String(const char* string = "") : _string(string != NULL ? string : "") {}
+    String(const std::string &string) : _string(string) {}
+    String(char character) : _string(1, character) {}
+    String(int value) : _string(std::to_string(value)) {}
+    String(unsigned int value) : _string(std::to_string(value)) {}
+    String(long value) : _string(std::to_string(value)) {}
+    String(unsigned long value) : _string(std::to_string(value)) {}
+    String(long long value) : _string(std::to_string(value)) {}
+    String(unsigned long long value) : _string(std::to_string(value)) {}
+    String(float value, uint8_t decimals = 2) : String((double) value, decimals) {}
+    String(double value, uint8_t decimals = 2);
+
+    const char* c_str() const { return _string.c_str(); }
+    unsigned int length() const { return _string.length(); }
+    bool reserve(unsigned int size) { _string.reserve(size); return true; }
+
+    String& operator+=(const String &string) { _string += string._string; return *this; }
+    String& operator+=(const char* string) { _string += string; return *this; }
+    String& operator+=(char character) { _string += character; return *this; }
+    friend String operator+(const String &string1, const String &string2) { return String(string1._string + string2._string); }
+    friend String operator+(const char* string1, const String &string2) { return String(string1 + string2._string); }
+    friend String operator+(const String &string1, const char* string2) { return String(string1._string + string2); }
+
+    bool operator==(const String &string) const { return _string == string._string; }
+    bool operator==(const char* string) const { return _string == string; }
+    bool operator!=(const String &string) const { return _string != string._string; }
+    bool operator!=(const char* string) const { return _string != string; }
+    char operator[](unsigned int index) const { return _string[index]; }
+
+  private:
+    std::string _string;
+};
+
+/* Time since the start of the program, on the clock of the FreeRTOS shim */
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long time);
+
+bool psramFound();
+#endif
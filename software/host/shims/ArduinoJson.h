@@ -0,0 +1,55 @@
+/******************************************************************************/
+/*
+ * File:    ArduinoJson.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host shim of ArduinoJson, only what the strip renderer parses: an
+ *          array of numbers or an array of arrays of numbers, like the pixel
+ *          addressing and the segment lengths. Values that are missing read
+ *          as 0, like in ArduinoJson.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef HOST_ARDUINO_JSON_H
+#define HOST_ARDUINO_JSON_H
+#include "Arduino.h"                                                            //For the String object
+#include <vector>                                                               //For the elements of the arrays
+
+class JsonArray {};
+
+class JsonVariant {
+  public:
+    long value = 0;
+    bool isArray = false;
+    std::vector<JsonVariant> elements;
+
+    template <typename T> bool is() const;
+    size_t size() const { return elements.size(); }
+
+    JsonVariant& operator[](size_t index) {
+        static JsonVariant missing;                                             //Read as 0, never written
+        missing = JsonVariant();
+        return index < elements.size() ? elements[index] : missing;
+    }
+
+    operator long() const { return value; }
+};
+
+template <> inline bool JsonVariant::is<JsonArray>() const { return isArray; }
+
+class JsonDocument : public JsonVariant {};
+
+class DeserializationError {
+  public:
+    DeserializationError(bool isError = false) : _isError(isError) {}
+    explicit operator bool() const { return _isError; }
+
+  private:
+    bool _isError;
+};
+
+DeserializationError deserializeJson(JsonDocument &document, const String &json);
+#endif
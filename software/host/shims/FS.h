@@ -0,0 +1,15 @@
+/******************************************************************************/
+/*
+ * File:    FS.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host shim of the file system, the host logger and memory manager do not use files.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef HOST_FS_H
+#define HOST_FS_H
+#endif
@@ -0,0 +1,262 @@
+/******************************************************************************/
+/*
+ * File:    FastLED.cpp
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host implementation of the FastLED shim: the sine table, the
+ *          rainbow hue conversion, the palettes and the FastLED object.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#include "FastLED.h"
+
+CFastLED FastLED;
+
+/* Standard palettes of FastLED */
+const TProgmemRGBPalette16 CloudColors_p = {
+    0x0000FF, 0x00008B, 0x00008B, 0x00008B, 0x00008B, 0x00008B, 0x00008B, 0x00008B,
+    0x0000FF, 0x00008B, 0x87CEEB, 0x87CEEB, 0xADD8E6, 0xFFFFFF, 0xADD8E6, 0x87CEEB
+};
+
+const TProgmemRGBPalette16 LavaColors_p = {
+    0x000000, 0x800000, 0x000000, 0x800000, 0x8B0000, 0x8B0000, 0x800000, 0x8B0000,
+    0x8B0000, 0x8B0000, 0xFF0000, 0xFFA500, 0xFFFFFF, 0xFFA500, 0xFF0000, 0x8B0000
+};
+
+const TProgmemRGBPalette16 OceanColors_p = {
+    0x191970, 0x00008B, 0x191970, 0x000080, 0x00008B, 0x0000CD, 0x2E8B57, 0x008080,
+    0x5F9EA0, 0x0000FF, 0x008B8B, 0x6495ED, 0x7FFFD4, 0x2E8B57, 0x00FFFF, 0x87CEFA
+};
+
+const TProgmemRGBPalette16 ForestColors_p = {
+    0x006400, 0x006400, 0x556B2F, 0x006400, 0x008000, 0x228B22, 0x6B8E23, 0x008000,
+    0x2E8B57, 0x66CDAA, 0x32CD32, 0x9ACD32, 0x90EE90, 0x7CFC00, 0x66CDAA, 0x228B22
+};
+
+const TProgmemRGBPalette16 RainbowColors_p = {
+    0xFF0000, 0xD52A00, 0xAB5500, 0xAB7F00, 0xABAB00, 0x56D500, 0x00FF00, 0x00D52A,
+    0x00AB55, 0x0056AA, 0x0000FF, 0x2A00D5, 0x5500AB, 0x7F0081, 0xAB0055, 0xD5002B
+};
+
+/******************************************************************************/
+/*!
+  @brief    Sine of an 8 bit angle, with the piecewise linear approximation of
+            FastLED.
+  @param    theta               Angle, 0 - 255 is one period
+  @returns  uint8_t             Sine, 0 - 255 with 128 as zero
+*/
+/******************************************************************************/
+uint8_t sin8(uint8_t theta) {
+    static const uint8_t interleave[] = {0, 49, 49, 41, 90, 27, 117, 10};      //Offset and slope of every quarter section
+    uint8_t offset = theta;
+
+    if (theta & 0x40) {
+        offset = 255 - offset;
+    }
+    offset &= 0x3F;
+
+    uint8_t sectionOffset = offset & 0x0F;
+    if (theta & 0x40) {
+        sectionOffset++;
+    }
+
+    const uint8_t* section = &interleave[(offset >> 4) * 2];
+    int8_t y = ((section[1] * sectionOffset) >> 4) + section[0];
+
+    if (theta & 0x80) {
+        y = -y;
+    }
+
+    return y + 128;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Converts a color to RGB with the rainbow hue map of FastLED, which
+            has more yellow than the spectrum.
+  @param    hsv                 Color
+  @param    rgb                 Converted color
+*/
+/******************************************************************************/
+void hsv2rgb_rainbow(const CHSV &hsv, CRGB &rgb) {
+    uint8_t hue = hsv.hue;
+    uint8_t saturation = hsv.sat;
+    uint8_t value = hsv.val;
+    uint8_t offset8 = (hue & 0x1F) << 3;
+    uint8_t third = scale8(offset8, 256 / 3);
+    uint8_t twoThirds = scale8(offset8, (256 * 2) / 3);
+    uint8_t r, g, b;
+
+    switch (hue >> 5) {
+        case 0:                                                                 //Red to orange
+            r = 255 - third;
+            g = third;
+            b = 0;
+            break;
+        case 1:                                                                 //Orange to yellow
+            r = 171;
+            g = 85 + third;
+            b = 0;
+            break;
+        case 2:                                                                 //Yellow to green
+            r = 171 - twoThirds;
+            g = 170 + third;
+            b = 0;
+            break;
+        case 3:                                                                 //Green to aqua
+            r = 0;
+            g = 255 - third;
+            b = third;
+            break;
+        case 4:                                                                 //Aqua to blue
+            r = 0;
+            g = 171 - twoThirds;
+            b = 85 + twoThirds;
+            break;
+        case 5:                                                                 //Blue to purple
+            r = third;
+            g = 0;
+            b = 255 - third;
+            break;
+        case 6:                                                                 //Purple to pink
+            r = 85 + third;
+            g = 0;
+            b = 171 - third;
+            break;
+        default:                                                                //Pink to red
+            r = 170 + third;
+            g = 0;
+            b = 85 - third;
+            break;
+    }
+
+    if (saturation != 255) {
+        if (saturation == 0) {
+            r = 255;
+            g = 255;
+            b = 255;
+        } else {
+            uint8_t desaturation = scale8_video(255 - saturation, 255 - saturation);
+            uint8_t saturationScale = 255 - desaturation;
+
+            r = scale8(r, saturationScale) + desaturation;
+            g = scale8(g, saturationScale) + desaturation;
+            b = scale8(b, saturationScale) + desaturation;
+        }
+    }
+
+    if (value != 255) {
+        value = scale8_video(value, value);
+        if (value == 0) {
+            r = 0;
+            g = 0;
+            b = 0;
+        } else {
+            r = r ? scale8(r, value) + 1 : 0;
+            g = g ? scale8(g, value) + 1 : 0;
+            b = b ? scale8(b, value) + 1 : 0;
+        }
+    }
+
+    rgb.r = r;
+    rgb.g = g;
+    rgb.b = b;
+}
+
+void fadeToBlackBy(CRGB leds[], uint16_t numberOfLeds, uint8_t fade) {
+    for (uint16_t i = 0; i < numberOfLeds; i++) {
+        leds[i].nscale8(255 - fade);
+    }
+}
+
+CRGBPalette16::CRGBPalette16(const TProgmemRGBPalette16 &palette) {
+    for (uint8_t i = 0; i < 16; i++) {
+        entries[i] = CRGB(palette[i]);
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Palette with a gradient through four colors, at entry 0, 5, 10
+            and 15.
+*/
+/******************************************************************************/
+CRGBPalette16::CRGBPalette16(const CHSV &color1, const CHSV &color2, const CHSV &color3, const CHSV &color4) {
+    CRGB colors[4] = {CRGB(color1), CRGB(color2), CRGB(color3), CRGB(color4)};
+
+    for (uint8_t i = 0; i < 16; i++) {
+        uint8_t section = i < 15 ? i / 5 : 2;
+        uint8_t amount = (i - section * 5) * 255 / 5;
+        entries[i] = blend(colors[section], colors[section + 1], amount);
+    }
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns the color at an index of a palette, blended between the
+            two nearest entries. The last entry blends into the first.
+  @param    palette             Palette
+  @param    index               Index, 16 per entry
+  @param    brightness          Brightness of the color
+  @param    blendType           LINEARBLEND or NOBLEND
+  @returns  CRGB                Color
+*/
+/******************************************************************************/
+CRGB ColorFromPalette(const CRGBPalette16 &palette, uint8_t index, uint8_t brightness, TBlendType blendType) {
+    uint8_t entry = index >> 4;
+    uint8_t fraction = index & 0x0F;
+    CRGB color = palette[entry];
+
+    if (fraction != 0 && blendType != NOBLEND) {
+        const CRGB &next = palette[(entry + 1) & 0x0F];
+        uint8_t amountOfNext = fraction << 4;
+        uint8_t amountOfColor = 255 - amountOfNext;
+
+        color.r = scale8(color.r, amountOfColor) + scale8(next.r, amountOfNext);
+        color.g = scale8(color.g, amountOfColor) + scale8(next.g, amountOfNext);
+        color.b = scale8(color.b, amountOfColor) + scale8(next.b, amountOfNext);
+    }
+
+    if (brightness != 255) {
+        color.nscale8_video(brightness);
+    }
+
+    return color;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Moves the channels of a palette one step towards a target palette.
+  @param    current             Palette to change
+  @param    target              Palette to move to
+  @param    maxChanges          Maximum number of changed channels
+*/
+/******************************************************************************/
+void nblendPaletteTowardPalette(CRGBPalette16 &current, CRGBPalette16 &target, uint8_t maxChanges) {
+    uint8_t* channels = (uint8_t*) current.entries;
+    const uint8_t* targetChannels = (const uint8_t*) target.entries;
+    uint8_t changes = 0;
+
+    for (uint8_t i = 0; i < sizeof(current.entries) && changes < maxChanges; i++) {
+        if (channels[i] < targetChannels[i]) {
+            channels[i]++;
+            changes++;
+        } else if (channels[i] > targetChannels[i]) {
+            channels[i]--;
+            changes++;
+            if (channels[i] > targetChannels[i]) {
+                channels[i]--;
+            }
+        }
+    }
+}
+
+CLEDController& CFastLED::_addController(CRGB leds[], int numberOfLeds) {
+    CLEDController &controller = _controllers[_numberOfControllers < 7 ? _numberOfControllers++ : 7];
+    controller.leds = leds;
+    controller.size = numberOfLeds;
+    return controller;
+}
@@ -0,0 +1,205 @@
+/******************************************************************************/
+/*
+ * File:    FastLED.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host shim of FastLED, only what the strip renderer uses: the color
+ *          types, the 8 bit math, the palettes and a FastLED object without
+ *          strips. The math follows FastLED (fixed scale8, rainbow hue
+ *          conversion), so host frames match the controller. Palettes built
+ *          from four CHSV colors are a gradient in RGB instead of in HSV.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef HOST_FASTLED_H
+#define HOST_FASTLED_H
+#include "Arduino.h"                                                            //For size defined int types and the FreeRTOS shim
+
+#define DISABLE_DITHER          0x00
+#define BINARY_DITHER           0x01
+
+/* 8 bit math */
+static inline uint8_t scale8(uint8_t value, uint8_t scale) {
+    return (value * (1 + (uint16_t) scale)) >> 8;
+}
+
+static inline uint8_t scale8_video(uint8_t value, uint8_t scale) {
+    return ((value * (uint16_t) scale) >> 8) + (value && scale ? 1 : 0);
+}
+
+static inline uint8_t qadd8(uint8_t value1, uint8_t value2) {
+    uint16_t sum = value1 + value2;
+    return sum > 255 ? 255 : sum;
+}
+
+static inline uint8_t blend8(uint8_t value1, uint8_t value2, uint8_t amountOfValue2) {
+    uint16_t partial = (value1 << 8) | value2;
+    partial += value2 * amountOfValue2;
+    partial -= value1 * amountOfValue2;
+    return partial >> 8;
+}
+
+uint8_t sin8(uint8_t theta);
+
+struct CHSV {
+    union {
+        struct {
+            union { uint8_t hue; uint8_t h; };
+            union { uint8_t saturation; uint8_t sat; uint8_t s; };
+            union { uint8_t value; uint8_t val; uint8_t v; };
+        };
+        uint8_t raw[3];
+    };
+
+    CHSV() = default;
+    CHSV(uint8_t hue, uint8_t saturation, uint8_t value) : h(hue), s(saturation), v(value) {}
+};
+
+struct CRGB;
+void hsv2rgb_rainbow(const CHSV &hsv, CRGB &rgb);
+
+struct CRGB {
+    union {
+        struct {
+            union { uint8_t r; uint8_t red; };
+            union { uint8_t g; uint8_t green; };
+            union { uint8_t b; uint8_t blue; };
+        };
+        uint8_t raw[3];
+    };
+
+    CRGB() = default;
+    CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+    CRGB(uint32_t colorCode) : r(colorCode >> 16), g(colorCode >> 8), b(colorCode) {}
+    CRGB(const CHSV &hsv) { hsv2rgb_rainbow(hsv, *this); }
+
+    CRGB& operator=(const CHSV &hsv) { hsv2rgb_rainbow(hsv, *this); return *this; }
+    uint8_t& operator[](uint8_t index) { return raw[index]; }
+    const uint8_t& operator[](uint8_t index) const { return raw[index]; }
+    bool operator==(const CRGB &color) const { return r == color.r && g == color.g && b == color.b; }
+    bool operator!=(const CRGB &color) const { return !(*this == color); }
+
+    CRGB& operator+=(const CRGB &color) {
+        r = qadd8(r, color.r);
+        g = qadd8(g, color.g);
+        b = qadd8(b, color.b);
+        return *this;
+    }
+
+    CRGB& nscale8(uint8_t scale) {
+        r = scale8(r, scale);
+        g = scale8(g, scale);
+        b = scale8(b, scale);
+        return *this;
+    }
+
+    CRGB& nscale8_video(uint8_t scale) {
+        r = scale8_video(r, scale);
+        g = scale8_video(g, scale);
+        b = scale8_video(b, scale);
+        return *this;
+    }
+
+    CRGB& fadeToBlackBy(uint8_t fade) {
+        return nscale8_video(255 - fade);
+    }
+};
+
+static inline CRGB blend(const CRGB &color1, const CRGB &color2, uint8_t amountOfColor2) {
+    return CRGB(blend8(color1.r, color2.r, amountOfColor2), blend8(color1.g, color2.g, amountOfColor2), blend8(color1.b, color2.b, amountOfColor2));
+}
+
+void fadeToBlackBy(CRGB leds[], uint16_t numberOfLeds, uint8_t fade);
+
+/* Palettes */
+typedef const uint32_t TProgmemRGBPalette16[16];
+
+enum TBlendType {
+    NOBLEND,
+    LINEARBLEND
+};
+
+class CRGBPalette16 {
+  public:
+    CRGBPalette16() { memset(entries, 0, sizeof(entries)); }
+    CRGBPalette16(const TProgmemRGBPalette16 &palette);
+    CRGBPalette16(const CHSV &color1, const CHSV &color2, const CHSV &color3, const CHSV &color4);
+
+    CRGB& operator[](uint8_t index) { return entries[index]; }
+    const CRGB& operator[](uint8_t index) const { return entries[index]; }
+    bool operator==(const CRGBPalette16 &palette) const { return memcmp(entries, palette.entries, sizeof(entries)) == 0; }
+    bool operator!=(const CRGBPalette16 &palette) const { return !(*this == palette); }
+
+    CRGB entries[16];
+};
+
+extern const TProgmemRGBPalette16 CloudColors_p;
+extern const TProgmemRGBPalette16 LavaColors_p;
+extern const TProgmemRGBPalette16 OceanColors_p;
+extern const TProgmemRGBPalette16 ForestColors_p;
+extern const TProgmemRGBPalette16 RainbowColors_p;
+
+CRGB ColorFromPalette(const CRGBPalette16 &palette, uint8_t index, uint8_t brightness = 255, TBlendType blendType = LINEARBLEND);
+void nblendPaletteTowardPalette(CRGBPalette16 &current, CRGBPalette16 &target, uint8_t maxChanges = 24);
+
+/* Strips, the host has none, so controllers only keep their LEDs */
+enum EOrder {
+    RGB = 0012,
+    RBG = 0021,
+    GRB = 0102,
+    GBR = 0120,
+    BRG = 0201,
+    BGR = 0210
+};
+
+enum ESPIChipsets {
+    LPD8806,
+    WS2801,
+    WS2803,
+    SM16716,
+    P9813,
+    APA102,
+    SK9822,
+    DOTSTAR
+};
+
+template <uint8_t DATA_PIN, EOrder RGB_ORDER> class WS2812B {};
+template <uint8_t DATA_PIN, EOrder RGB_ORDER> class SK6812 {};
+
+class CLEDController {
+  public:
+    CRGB* leds = NULL;
+    int size = 0;
+};
+
+class CFastLED {
+  public:
+    template <ESPIChipsets CHIPSET, uint8_t DATA_PIN, uint8_t CLOCK_PIN, EOrder RGB_ORDER>
+    CLEDController& addLeds(CRGB leds[], int numberOfLeds, int offset = 0) {
+        return _addController(leds + offset, numberOfLeds);
+    }
+
+    template <template <uint8_t DATA_PIN, EOrder RGB_ORDER> class CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+    CLEDController& addLeds(CRGB leds[], int numberOfLeds, int offset = 0) {
+        return _addController(leds + offset, numberOfLeds);
+    }
+
+    void show() {}
+    void setBrightness(uint8_t brightness) { _brightness = brightness; }
+    uint8_t getBrightness() { return _brightness; }
+    void setDither(uint8_t ditherMode = BINARY_DITHER) {}
+    int count() { return _numberOfControllers; }
+
+  private:
+    CLEDController& _addController(CRGB leds[], int numberOfLeds);
+
+    CLEDController _controllers[8];                                             //One per output
+    int _numberOfControllers = 0;
+    uint8_t _brightness = 255;
+};
+
+extern CFastLED FastLED;
+#endif
@@ -0,0 +1,85 @@
+/******************************************************************************/
+/*
+ * File:    HostLogger.cpp
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host implementation of the Logger class. Logs are printed to
+ *          stdout from the log level on, nothing is saved.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#include "Logger.h"
+#include "stdio.h"                                                              //For printing the logs
+
+#define HOST_LOG_LEVEL          LOG_TYPE_WARNING                                //Lower logs are not printed, so the harness output stays readable
+
+static const char* logTypeNames[] = {"DEBUG", "INFO", "WARNING", "ERROR", "FATAL ERROR"};
+
+Logger::Logger(const char* tag, uint8_t logLevel) {
+    _tag = tag;
+    _logLevel = max(logLevel, (uint8_t) HOST_LOG_LEVEL);
+}
+
+void Logger::setTag(const char* tag) {
+    _tag = tag;
+}
+
+void Logger::setLogLevel(uint8_t logLevel) {
+    _logLevel = max(logLevel, (uint8_t) HOST_LOG_LEVEL);
+}
+
+void Logger::logd(String logString) {
+    _log(logString.c_str(), LOG_TYPE_DEBUG, false);
+}
+
+void Logger::logd(const char* logString) {
+    _log(logString, LOG_TYPE_DEBUG, false);
+}
+
+void Logger::logi(String logString, bool saveToFile) {
+    _log(logString.c_str(), LOG_TYPE_INFO, saveToFile);
+}
+
+void Logger::logi(const char* logString, bool saveToFile) {
+    _log(logString, LOG_TYPE_INFO, saveToFile);
+}
+
+void Logger::logw(String logString, bool saveToFile) {
+    _log(logString.c_str(), LOG_TYPE_WARNING, saveToFile);
+}
+
+void Logger::logw(const char* logString, bool saveToFile) {
+    _log(logString, LOG_TYPE_WARNING, saveToFile);
+}
+
+void Logger::loge(String logString, bool saveToFile) {
+    _log(logString.c_str(), LOG_TYPE_ERROR, saveToFile);
+}
+
+void Logger::loge(const char* logString, bool saveToFile) {
+    _log(logString, LOG_TYPE_ERROR, saveToFile);
+}
+
+void Logger::logfe(String logString, bool saveToFile) {
+    _log(logString.c_str(), LOG_TYPE_FATAL_ERROR, saveToFile);
+}
+
+void Logger::logfe(const char* logString, bool saveToFile) {
+    _log(logString, LOG_TYPE_FATAL_ERROR, saveToFile);
+}
+
+String Logger::generateJsonLog(uint8_t type, const char* log) {
+    return String("{\"type\":") + String(type) + ",\"log\":\"" + log + "\"}";
+}
+
+void Logger::markLogsAsRead() {}
+
+void Logger::_log(const char* logString, uint8_t type, bool saveToFile) {
+    if (type < _logLevel || type > LOG_TYPE_FATAL_ERROR) {
+        return;
+    }
+    printf("%s: %s: %s\n", logTypeNames[type], _tag, logString);
+}
@@ -0,0 +1,77 @@
+/******************************************************************************/
+/*
+ * File:    HostMemoryManager.cpp
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host implementation of the mode parameter functions of the
+ *          MemoryManager class, in the non-volatile memory shim. Modes that
+ *          were not configured get the defaults of the controller.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#include "MemoryManager.h"
+
+MemoryManager::MemoryManager() {
+    _l.setTag("MemoryManager");
+    _sdMounted = false;
+}
+
+ModeParameters MemoryManager::loadModeParameters(uint8_t mode) {
+    ModeParameters parameters;
+    String key = "modeParams_" + String(mode);
+
+    /* Same defaults as the controller, where they differ from the struct */
+    parameters.intensity = 1;
+    parameters.numberOfElements = 1;
+    parameters.palette = PALETTE_RANDOM;
+    parameters.fadeLength = 100;
+
+    _nvMemory.begin(NV_MEM_CONFIG);
+    _nvMemory.getBytes(key.c_str(), &parameters, sizeof(parameters));
+    _nvMemory.end();
+
+    return parameters;
+}
+
+void MemoryManager::writeModeParameters(uint8_t mode, ModeParameters parameters, uint32_t parameterFlags) {
+    String key = "modeParams_" + String(mode);
+
+    _nvMemory.begin(NV_MEM_CONFIG);
+    _nvMemory.putBytes(key.c_str(), &parameters, sizeof(parameters));
+    _nvMemory.end();
+}
+
+bool MemoryManager::loadSegmentModeParameters(uint8_t segment, uint8_t mode, ModeParameters &parameters) {
+    ModeParameters loadedParameters;
+    String key = "segParams_" + String(segment) + "_" + String(mode);
+
+    _nvMemory.begin(NV_MEM_CONFIG);
+    size_t size = _nvMemory.getBytes(key.c_str(), &loadedParameters, sizeof(loadedParameters));
+    _nvMemory.end();
+
+    if (size != sizeof(loadedParameters)) {
+        return false;
+    }
+
+    parameters = loadedParameters;
+    return true;
+}
+
+void MemoryManager::writeSegmentModeParameters(uint8_t segment, uint8_t mode, ModeParameters parameters) {
+    String key = "segParams_" + String(segment) + "_" + String(mode);
+
+    _nvMemory.begin(NV_MEM_CONFIG);
+    _nvMemory.putBytes(key.c_str(), &parameters, sizeof(parameters));
+    _nvMemory.end();
+}
+
+void MemoryManager::removeSegmentModeParameters(uint8_t segment, uint8_t mode) {
+    String key = "segParams_" + String(segment) + "_" + String(mode);
+
+    _nvMemory.begin(NV_MEM_CONFIG);
+    _nvMemory.remove(key.c_str());
+    _nvMemory.end();
+}
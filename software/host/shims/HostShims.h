@@ -0,0 +1,22 @@
+/******************************************************************************/
+/*
+ * File:    HostShims.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Controls of the host shims for the harnesses. The clock can be
+ *          stopped at a time, so modes render at an exact time, and the
+ *          hardware random generator can be seeded.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef HOST_SHIMS_H
+#define HOST_SHIMS_H
+#include "stdint.h"                                                             //For size defined int types
+
+void stopHostClock(uint32_t time);                                              //Tick count and timer stay at the time, in ms
+void startHostClock();                                                          //Clock runs again, from the time of the program
+void seedHostRandom(uint32_t seed);                                             //Restarts the numbers of esp_random()
+#endif
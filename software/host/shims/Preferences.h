@@ -0,0 +1,44 @@
+/******************************************************************************/
+/*
+ * File:    Preferences.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host shim of the non-volatile memory, kept in memory for as long
+ *          as the program runs. Every namespace is shared by all Preferences
+ *          objects, like on the controller, so a harness can configure the
+ *          strip before it is initialized.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+#include "Arduino.h"                                                            //For the String object
+
+class Preferences {
+  public:
+    bool begin(const char* name, bool readOnly = false);
+    void end();
+
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0);
+    uint16_t getUShort(const char* key, uint16_t defaultValue = 0);
+    bool getBool(const char* key, bool defaultValue = false);
+    String getString(const char* key, String defaultValue = String());
+    size_t getBytes(const char* key, void* buffer, size_t length);
+
+    size_t putUChar(const char* key, uint8_t value);
+    size_t putUShort(const char* key, uint16_t value);
+    size_t putBool(const char* key, bool value);
+    size_t putString(const char* key, String value);
+    size_t putBytes(const char* key, const void* value, size_t length);
+    bool remove(const char* key);
+
+  private:
+    bool _get(const char* key, void* value, size_t size);
+    size_t _put(const char* key, const void* value, size_t size);
+
+    String _name;
+};
+#endif
@@ -0,0 +1,15 @@
+/******************************************************************************/
+/*
+ * File:    SD_MMC.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host shim of the SD card, the host logger and memory manager do not use files.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef HOST_SD_MMC_H
+#define HOST_SD_MMC_H
+#endif
@@ -0,0 +1,15 @@
+/******************************************************************************/
+/*
+ * File:    SPI.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host shim of the SPI bus, the host has no strips to send to.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+#endif
@@ -0,0 +1,15 @@
+/******************************************************************************/
+/*
+ * File:    SPIFFS.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host shim of the internal flash file system, the host memory manager does not use files.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef HOST_SPIFFS_H
+#define HOST_SPIFFS_H
+#endif
@@ -0,0 +1,468 @@
+/******************************************************************************/
+/*
+ * File:    Shims.cpp
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host implementation of the Arduino, FreeRTOS and ESP-IDF shims,
+ *          the in-memory non-volatile memory and the JSON parser.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#include "Arduino.h"
+#include "ArduinoJson.h"
+#include "Preferences.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "HostShims.h"
+#include <atomic>                                                               //For the state of the clock
+#include <chrono>                                                               //For the clock
+#include <condition_variable>                                                   //For blocking tasks
+#include <deque>                                                                //For the items of the queues
+#include <map>                                                                  //For the non-volatile memory
+#include <mutex>
+#include <thread>                                                               //For the tasks
+#include <vector>
+
+#pragma region Clock
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+static std::atomic<bool> isClockStopped(false);
+static std::atomic<int64_t> stoppedTime(0);                                     //In us
+
+/******************************************************************************/
+/*!
+  @brief    Stops the clock at the specified time, until startHostClock().
+  @param    time                Time, in ms
+*/
+/******************************************************************************/
+void stopHostClock(uint32_t time) {
+    stoppedTime = (int64_t) time * 1000;
+    isClockStopped = true;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Lets the clock run again, at the time since the start of the
+            program.
+*/
+/******************************************************************************/
+void startHostClock() {
+    isClockStopped = false;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns the time since the start of the program, or the time the
+            clock is stopped at.
+  @returns  int64_t             Time, in us
+*/
+/******************************************************************************/
+int64_t esp_timer_get_time() {
+    if (isClockStopped) {
+        return stoppedTime;
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long millis() {
+    return esp_timer_get_time() / 1000;
+}
+
+unsigned long micros() {
+    return esp_timer_get_time();
+}
+
+void delay(unsigned long time) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(time));
+}
+
+TickType_t xTaskGetTickCount() {
+    return pdMS_TO_TICKS(esp_timer_get_time() / 1000);
+}
+#pragma endregion
+
+#pragma region Random
+static std::mutex randomMutex;
+static uint32_t randomState = 0x9E3779B9;
+
+/******************************************************************************/
+/*!
+  @brief    Restarts the numbers of esp_random().
+  @param    seed                Seed, 0 is not allowed
+*/
+/******************************************************************************/
+void seedHostRandom(uint32_t seed) {
+    std::lock_guard<std::mutex> lock(randomMutex);
+    randomState = seed != 0 ? seed : 0x9E3779B9;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Returns a random number, from a xorshift generator instead of the
+            hardware generator.
+  @returns  uint32_t            Random number
+*/
+/******************************************************************************/
+uint32_t esp_random() {
+    std::lock_guard<std::mutex> lock(randomMutex);
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+bool psramFound() {
+    return true;
+}
+#pragma endregion
+
+#pragma region Tasks
+struct HostTask {
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint32_t notification = 0;
+    bool isNotified = false;
+};
+
+static thread_local HostTask* currentTask = NULL;
+
+/******************************************************************************/
+/*!
+  @brief    Returns the task of the calling thread. Threads that were not
+            started as task, like the main thread, get a task at their first
+            call.
+  @returns  HostTask*           Task
+*/
+/******************************************************************************/
+static HostTask* getCurrentTask() {
+    if (currentTask == NULL) {
+        currentTask = new HostTask();
+    }
+    return currentTask;
+}
+
+/******************************************************************************/
+/*!
+  @brief    Waits on the condition until the predicate is true or the timeout
+            passed.
+  @param    condition           Condition variable
+  @param    lock                Locked mutex of the condition
+  @param    timeout             Timeout in ticks, portMAX_DELAY waits forever
+  @param    predicate           Returns true when the wait is over
+  @returns  bool                Result of the predicate
+*/
+/******************************************************************************/
+template <typename P>
+static bool waitFor(std::condition_variable &condition, std::unique_lock<std::mutex> &lock, TickType_t timeout, P predicate) {
+    if (timeout == portMAX_DELAY) {
+        condition.wait(lock, predicate);
+        return true;
+    }
+    return condition.wait_for(lock, std::chrono::milliseconds(pdTICKS_TO_MS(timeout)), predicate);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackSize, void* parameter, UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    HostTask* task = new HostTask();
+
+    if (handle != NULL) {
+        *handle = task;                                                         //Known before the task runs, like in FreeRTOS
+    }
+
+    std::thread([task, function, parameter]() {
+        currentTask = task;
+        function(parameter);
+    }).detach();
+
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(pdTICKS_TO_MS(ticks)));
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    std::lock_guard<std::mutex> lock(task->mutex);
+
+    switch (action) {
+        case eSetBits:
+            task->notification |= value;
+            break;
+        case eIncrement:
+            task->notification++;
+            break;
+        case eSetValueWithoutOverwrite:
+            if (task->isNotified) {
+                return pdFAIL;
+            }
+            task->notification = value;
+            break;
+        case eSetValueWithOverwrite:
+            task->notification = value;
+            break;
+        default:
+            break;
+    }
+    task->isNotified = true;
+    task->condition.notify_all();
+
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, TickType_t timeout) {
+    HostTask* task = getCurrentTask();
+    std::unique_lock<std::mutex> lock(task->mutex);
+
+    if (!task->isNotified) {
+        task->notification &= ~clearOnEntry;
+    }
+
+    bool isNotified = waitFor(task->condition, lock, timeout, [task]() { return task->isNotified; });
+
+    if (value != NULL) {
+        *value = task->notification;
+    }
+    if (!isNotified) {
+        return pdFALSE;
+    }
+
+    task->notification &= ~clearOnExit;
+    task->isNotified = false;
+
+    return pdTRUE;
+}
+#pragma endregion
+
+#pragma region Queues and semaphores
+struct HostQueue {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t itemSize;                                                            //0 for semaphores
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    HostQueue* queue = new HostQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t timeout) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+
+    if (!waitFor(queue->condition, lock, timeout, [queue]() { return queue->items.size() < queue->length; })) {
+        return pdFAIL;
+    }
+
+    const uint8_t* bytes = (const uint8_t*) item;
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    queue->condition.notify_all();
+
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t timeout) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+
+    if (!waitFor(queue->condition, lock, timeout, [queue]() { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+
+    if (queue->itemSize > 0) {
+        memcpy(item, queue->items.front().data(), queue->itemSize);
+    }
+    queue->items.pop_front();
+    queue->condition.notify_all();
+
+    return pdTRUE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return xQueueCreate(1, 0);                                                  //Empty, has to be given first
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    SemaphoreHandle_t mutex = xQueueCreate(1, 0);
+    xSemaphoreGive(mutex);
+    return mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout) {
+    return xQueueReceive(semaphore, NULL, timeout);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    return xQueueSend(semaphore, NULL, 0);
+}
+#pragma endregion
+
+#pragma region Arduino
+String::String(double value, uint8_t decimals) {
+    char string[32];
+    snprintf(string, sizeof(string), "%.*f", decimals, value);
+    _string = string;
+}
+#pragma endregion
+
+#pragma region Preferences
+static std::mutex preferencesMutex;
+static std::map<std::string, std::vector<uint8_t>> preferences;                 //Values by namespace and key
+
+bool Preferences::begin(const char* name, bool readOnly) {
+    _name = name;
+    return true;
+}
+
+void Preferences::end() {}
+
+bool Preferences::_get(const char* key, void* value, size_t size) {
+    std::lock_guard<std::mutex> lock(preferencesMutex);
+    auto entry = preferences.find(std::string(_name.c_str()) + "/" + key);
+
+    if (entry == preferences.end() || entry->second.size() != size) {
+        return false;
+    }
+
+    memcpy(value, entry->second.data(), size);
+    return true;
+}
+
+size_t Preferences::_put(const char* key, const void* value, size_t size) {
+    std::lock_guard<std::mutex> lock(preferencesMutex);
+    const uint8_t* bytes = (const uint8_t*) value;
+
+    preferences[std::string(_name.c_str()) + "/" + key] = std::vector<uint8_t>(bytes, bytes + size);
+    return size;
+}
+
+uint8_t Preferences::getUChar(const char* key, uint8_t defaultValue) {
+    uint8_t value = defaultValue;
+    _get(key, &value, sizeof(value));
+    return value;
+}
+
+uint16_t Preferences::getUShort(const char* key, uint16_t defaultValue) {
+    uint16_t value = defaultValue;
+    _get(key, &value, sizeof(value));
+    return value;
+}
+
+bool Preferences::getBool(const char* key, bool defaultValue) {
+    return getUChar(key, defaultValue);
+}
+
+String Preferences::getString(const char* key, String defaultValue) {
+    std::lock_guard<std::mutex> lock(preferencesMutex);
+    auto entry = preferences.find(std::string(_name.c_str()) + "/" + key);
+
+    if (entry == preferences.end()) {
+        return defaultValue;
+    }
+    return String(std::string(entry->second.begin(), entry->second.end()));
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t length) {
+    std::lock_guard<std::mutex> lock(preferencesMutex);
+    auto entry = preferences.find(std::string(_name.c_str()) + "/" + key);
+
+    if (entry == preferences.end() || entry->second.size() > length) {
+        return 0;
+    }
+
+    memcpy(buffer, entry->second.data(), entry->second.size());
+    return entry->second.size();
+}
+
+size_t Preferences::putUChar(const char* key, uint8_t value) {
+    return _put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putUShort(const char* key, uint16_t value) {
+    return _put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putBool(const char* key, bool value) {
+    return putUChar(key, value);
+}
+
+size_t Preferences::putString(const char* key, String value) {
+    return _put(key, value.c_str(), value.length());
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    return _put(key, value, length);
+}
+
+bool Preferences::remove(const char* key) {
+    std::lock_guard<std::mutex> lock(preferencesMutex);
+    return preferences.erase(std::string(_name.c_str()) + "/" + key) > 0;
+}
+#pragma endregion
+
+#pragma region JSON
+/******************************************************************************/
+/*!
+  @brief    Parses a number or an array of values.
+  @param    json                JSON, moved past the value
+  @param    variant             Parsed value
+  @returns  bool                False if the JSON is not a number or array
+*/
+/******************************************************************************/
+static bool parseValue(const char* &json, JsonVariant &variant) {
+    while (*json == ' ' || *json == '\t' || *json == '\r' || *json == '\n') {
+        json++;
+    }
+
+    if (*json != '[') {
+        char* end;
+        variant.value = strtol(json, &end, 10);
+        if (end == json) {
+            return false;
+        }
+        json = end;
+        return true;
+    }
+
+    variant.isArray = true;
+    json++;
+
+    while (1) {
+        while (*json == ' ' || *json == '\t' || *json == '\r' || *json == '\n') {
+            json++;
+        }
+        if (*json == ']') {
+            json++;
+            return true;
+        }
+
+        variant.elements.emplace_back();
+        if (!parseValue(json, variant.elements.back())) {
+            return false;
+        }
+
+        while (*json == ' ' || *json == '\t' || *json == '\r' || *json == '\n') {
+            json++;
+        }
+        if (*json == ',') {
+            json++;
+        } else if (*json != ']') {
+            return false;
+        }
+    }
+}
+
+DeserializationError deserializeJson(JsonDocument &document, const String &json) {
+    const char* position = json.c_str();
+
+    document = JsonDocument();
+    if (!parseValue(position, document)) {
+        document = JsonDocument();
+        return DeserializationError(true);
+    }
+
+    return DeserializationError(false);
+}
+#pragma endregion
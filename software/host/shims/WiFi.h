@@ -0,0 +1,26 @@
+/******************************************************************************/
+/*
+ * File:    WiFi.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host shim of the WiFi library, only the IPAddress type of the
+ *          global network configuration.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+#include "Arduino.h"                                                            //For size defined int types
+
+class IPAddress {
+  public:
+    IPAddress(uint8_t octet1 = 0, uint8_t octet2 = 0, uint8_t octet3 = 0, uint8_t octet4 = 0) : _octets{octet1, octet2, octet3, octet4} {}
+    uint8_t operator[](uint8_t index) const { return _octets[index]; }
+
+  private:
+    uint8_t _octets[4];
+};
+#endif
@@ -0,0 +1,24 @@
+/******************************************************************************/
+/*
+ * File:    esp_heap_caps.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host shim of the ESP-IDF heap, the capabilities are ignored.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+#include "stdint.h"                                                             //For size defined int types
+#include "stdlib.h"                                                             //For calloc
+
+#define MALLOC_CAP_SPIRAM       (1 << 10)
+#define MALLOC_CAP_8BIT         (1 << 2)
+
+static inline void* heap_caps_calloc(size_t number, size_t size, uint32_t caps) {
+    return calloc(number, size);
+}
+#endif
@@ -0,0 +1,20 @@
+/******************************************************************************/
+/*
+ * File:    esp_random.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host shim of the hardware random generator. The numbers come from
+ *          a generator with a fixed seed, so host runs are reproducible (see
+ *          seedHostRandom()).
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef HOST_ESP_RANDOM_H
+#define HOST_ESP_RANDOM_H
+#include "stdint.h"                                                             //For size defined int types
+
+uint32_t esp_random();
+#endif
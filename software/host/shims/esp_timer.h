@@ -0,0 +1,18 @@
+/******************************************************************************/
+/*
+ * File:    esp_timer.h
+ * Author:  Luke de Munk
+ * Version: 0.9.0
+ *
+ * Brief:   Host shim of the ESP-IDF timer, on the clock of the FreeRTOS shim.
+ *
+ *          More information:
+ *          https://github.com/LukedeMunk/zyrax-home-rgbw-led-strip-controller
+ */
+/******************************************************************************/
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+#include "stdint.h"                                                             //For size defined int types
+
+int64_t esp_timer_get_time();                                                   //Time since the start of the program, in us
+#endif